@@ -0,0 +1,81 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+// Streams captured frames as tile deltas (see TileDeltaProtocol) to one TCP
+// viewer. The GL thread copies each readback into a pooled frame; the
+// streamer thread hashes fixed-size tiles, run-length encodes the tiles whose
+// hash differs from what the viewer last received and sends them. A frame
+// dropped because the queue is full is simply not sent: hashes only advance
+// with what went out, so the next frame still carries every change. A new
+// connection replaces the current viewer and starts with a keyframe.
+class DeltaStreamer {
+public:
+  DeltaStreamer() = default;
+  ~DeltaStreamer();
+
+  DeltaStreamer(const DeltaStreamer&) = delete;
+  DeltaStreamer& operator=(const DeltaStreamer&) = delete;
+
+  bool open(const char* address, int port, int width, int height, int tile_size, int max_queued);
+
+  //Copies bottom-up RGBA into a pooled frame and queues it; dropped when the queue is full
+  void submit(const unsigned char* rgba, int width, int height);
+
+  //Sends everything queued, then disconnects and stops the thread
+  void close();
+
+  bool isOpen() const { return worker_.joinable(); }
+
+  //Frames sent, tiles changed and bytes against raw RGB
+  void report(std::ostream& out) const;
+
+private:
+  struct Frame {
+    std::vector<unsigned char> rgba;   // bottom-up rows, as read from GL
+  };
+
+  void workerLoop();
+  void acceptViewer();
+  void sendFrame(const Frame& frame);
+  void disconnect();
+
+  int width_ = 0;
+  int height_ = 0;
+  int tile_size_ = 32;
+  int tiles_x_ = 0;
+  int tiles_y_ = 0;
+
+  std::vector<std::unique_ptr<Frame>> frames_;
+  std::vector<Frame*> free_;
+  std::deque<Frame*> queue_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stopping_ = false;
+  std::thread worker_;
+
+  //Streamer thread only
+  int listen_fd_ = -1;
+  int client_fd_ = -1;
+  bool keyframe_ = true;
+  uint32_t frame_number_ = 0;
+  std::vector<uint64_t> sent_hashes_;   // per tile, as last sent to the viewer
+  std::vector<unsigned char> message_;
+
+  int dropped_ = 0;
+  int frames_sent_ = 0;
+  int keyframes_ = 0;
+  int viewers_ = 0;
+  uint64_t tiles_sent_ = 0;
+  uint64_t tiles_total_ = 0;
+  uint64_t bytes_sent_ = 0;
+  double hash_ms_ = 0.0;
+  double encode_ms_ = 0.0;
+};
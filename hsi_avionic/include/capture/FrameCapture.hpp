@@ -0,0 +1,54 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <chrono>
+#include <functional>
+#include <ostream>
+#include <vector>
+
+// Asynchronous framebuffer readback. capture() starts a glReadPixels into the
+// next pixel buffer object of a small ring and fences it; collect() maps the
+// buffers whose fence has signaled and hands their pixels to every sink. No
+// call waits on the GPU: when every buffer is still in flight the frame is
+// skipped. GL thread only.
+class FrameCapture {
+public:
+  //Mapped pixels, bottom-up RGBA; valid only during the call
+  using Sink = std::function<void(const unsigned char* rgba, int width, int height,
+                                  std::chrono::steady_clock::time_point drawn)>;
+
+  bool init(int width, int height, int pbo_count);
+  void addSink(Sink sink);
+  bool active() const { return !sinks_.empty(); }
+  void shutdown();
+
+  //After the frame is drawn, before the swap
+  void capture();
+  //Hands finished readbacks to the encoder; wait = true drains the ring
+  void collect(bool wait = false);
+
+  //Frames captured and skipped, and the GL-thread cost of capture() + collect()
+  void report(std::ostream& out) const;
+
+private:
+  struct Slot {
+    GLuint pbo = 0;
+    GLsync fence = nullptr;
+    std::chrono::steady_clock::time_point drawn;
+  };
+
+  std::vector<Slot> slots_;
+  size_t next_ = 0;          // slot capture() fills
+  size_t oldest_ = 0;        // slot collect() checks first
+  size_t in_flight_ = 0;
+  int width_ = 0;
+  int height_ = 0;
+  std::vector<Sink> sinks_;
+
+  int captured_ = 0;
+  int skipped_ = 0;
+  int frames_ = 0;
+  double cost_total_ms_ = 0.0;
+  double cost_max_ms_ = 0.0;
+  double frame_cost_ms_ = 0.0;   // capture() + collect() of the current frame
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Background writer for captured frames. The GL thread copies pixels into a
+// pooled frame and queues it; the encoder thread converts and writes it. The format follows
+// the path: ".y4m" writes a YUV 4:4:4 Y4M stream, ".rgb" raw RGB24 frames,
+// and a pattern with one %d or %0Nd such as "frames/hsi_%05d.png" numbered PNGs. When the
+// queue is full the frame is dropped instead of blocking the render loop.
+class FrameEncoder {
+public:
+  enum class Format { Y4M, RawRgb, PngSequence };
+
+  struct Frame {
+    int width, height;
+    std::vector<unsigned char> rgba;   // bottom-up rows, as read from GL
+  };
+
+  FrameEncoder() = default;
+  ~FrameEncoder();
+
+  FrameEncoder(const FrameEncoder&) = delete;
+  FrameEncoder& operator=(const FrameEncoder&) = delete;
+
+  bool open(const std::string& path, int width, int height, double fps, int max_queued);
+
+  //Copies bottom-up RGBA into a pooled frame and queues it; dropped when the queue is full
+  void submit(const unsigned char* rgba, int width, int height);
+
+  //Writes everything queued, then stops the thread
+  void close();
+
+  bool isOpen() const { return worker_.joinable(); }
+  int written() const { return written_; }
+  int dropped() const { return dropped_; }
+
+private:
+  void workerLoop();
+  bool write(const Frame& frame);
+  bool writeY4m(const Frame& frame);
+  bool writeRgb(const Frame& frame);
+  bool writePng(const Frame& frame);
+
+  Format format_ = Format::Y4M;
+  std::string path_;
+  std::string name_prefix_;    // PNG sequence: file names are prefix, zero-padded number, suffix
+  std::string name_suffix_;
+  int name_digits_ = 0;
+  std::FILE* file_ = nullptr;
+  int width_ = 0;
+  int height_ = 0;
+  double fps_ = 60.0;
+
+  std::vector<std::unique_ptr<Frame>> frames_;
+  std::vector<Frame*> free_;
+  std::deque<Frame*> queue_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stopping_ = false;
+  std::thread worker_;
+
+  std::vector<unsigned char> scratch_;   // encoder thread only
+  int written_ = 0;
+  int dropped_ = 0;
+};
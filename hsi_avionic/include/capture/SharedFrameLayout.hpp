@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Memory layout of the shared-memory frame ring, shared by the publisher and
+// its consumers. The object starts with a RingHeader; the pixels of slot i
+// follow at pixel_offset + i * slot_bytes as top-down RGBA8 rows of stride
+// bytes. Frame n (1-based) is written to slot (n - 1) % slot_count.
+//
+// Each slot is guarded by a sequence lock. The writer makes seq odd, writes
+// the pixels and the slot header, makes seq even again and then stores n in
+// latest. A reader loads latest, reads seq (retrying while it is odd), uses
+// the slot in place, and accepts what it read only if seq is unchanged
+// afterwards and frame_number still equals n. Readers never write.
+namespace SharedFrameLayout {
+  constexpr uint32_t MAGIC = 0x46495348;   // "HSIF"
+  constexpr uint32_t VERSION = 1;
+  constexpr int MAX_SLOTS = 4;
+  constexpr size_t PAGE_ALIGN = 4096;
+
+  struct SlotHeader {
+    std::atomic<uint32_t> seq;       // odd while the slot is written
+    uint32_t reserved;
+    uint64_t frame_number;
+    uint64_t timestamp_ns;           // CLOCK_MONOTONIC when the frame was drawn
+    //Pixels changed since frame_number - 1, top-left origin; empty when nothing changed
+    int32_t dirty_x, dirty_y, dirty_w, dirty_h;
+  };
+
+  struct RingHeader {
+    std::atomic<uint32_t> magic;     // stored last when the ring is created
+    uint32_t version;
+    uint32_t width, height;
+    uint32_t stride;                 // bytes per row
+    uint32_t slot_count;
+    uint64_t slot_bytes;
+    uint64_t pixel_offset;           // slot 0 pixels, from the start of the object
+    std::atomic<uint64_t> latest;    // newest complete frame number; 0 before the first
+    std::atomic<uint32_t> closed;    // set when the publisher exits
+    uint32_t reserved;
+    SlotHeader slots[MAX_SLOTS];
+  };
+
+  static_assert(std::atomic<uint32_t>::is_always_lock_free &&
+                std::atomic<uint64_t>::is_always_lock_free,
+                "seqlock fields must be lock-free to work across processes");
+
+  inline size_t pixelOffset() {
+    return (sizeof(RingHeader) + PAGE_ALIGN - 1) / PAGE_ALIGN * PAGE_ALIGN;
+  }
+
+  inline size_t objectBytes(uint32_t width, uint32_t height, uint32_t slot_count) {
+    return pixelOffset() + (size_t)width * height * 4 * slot_count;
+  }
+}
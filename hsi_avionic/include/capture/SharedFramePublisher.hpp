@@ -0,0 +1,44 @@
+#pragma once
+
+#include "capture/SharedFrameLayout.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Publishes finished frames into a POSIX shared-memory ring (see
+// SharedFrameLayout) so a compositor process on the same machine can use them
+// in place. publish() receives the bottom-up pixels of a FrameCapture
+// readback, flips them into the next slot and computes the dirty rectangle
+// against the previous frame. GL thread only; the object is unlinked on close.
+class SharedFramePublisher {
+public:
+  SharedFramePublisher() = default;
+  ~SharedFramePublisher();
+
+  SharedFramePublisher(const SharedFramePublisher&) = delete;
+  SharedFramePublisher& operator=(const SharedFramePublisher&) = delete;
+
+  //name is a shm_open name such as "/hsi_frames"; slot_count 2 or 3 (up to MAX_SLOTS)
+  bool open(const std::string& name, int width, int height, int slot_count);
+  void publish(const unsigned char* rgba, int width, int height,
+               std::chrono::steady_clock::time_point drawn);
+  void close();
+
+  bool isOpen() const { return header_ != nullptr; }
+
+  //Frames published and the GL-thread cost of publish()
+  void report(std::ostream& out) const;
+
+private:
+  unsigned char* slotPixels(uint64_t frame_number) const;
+
+  std::string name_;
+  SharedFrameLayout::RingHeader* header_ = nullptr;
+  size_t mapped_bytes_ = 0;
+  uint64_t frame_number_ = 0;
+
+  double cost_total_ms_ = 0.0;
+  double cost_max_ms_ = 0.0;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Wire format of the tile delta stream (--delta-stream), shared by the
+// streamer and its viewers. All integers are little-endian.
+//
+// Each frame is a FrameHeader followed by tile_count tiles. A tile is a
+// TileHeader followed by its encoded pixels: the tile's RGB pixels in
+// row-major order, top-left origin, as packets
+//   0x80 | (n - 1), r, g, b        run of n (2..128) identical pixels
+//   n - 1, n * (r, g, b)           n (1..128) literal pixels
+// Tiles not listed are unchanged since the previous frame on the connection.
+// The first frame of a connection is a keyframe that lists every tile.
+namespace TileDeltaProtocol {
+  constexpr uint32_t MAGIC = 0x54495348;   // "HSIT"
+  constexpr uint16_t FLAG_KEYFRAME = 1;
+
+  constexpr size_t FRAME_HEADER_BYTES = 24;
+  //magic u32, frame_number u32, width u16, height u16, tile_size u16, flags u16,
+  //tile_count u32, payload_bytes u32 (everything after the header)
+
+  constexpr size_t TILE_HEADER_BYTES = 8;
+  //tile_x u16, tile_y u16 (in tiles), encoded_bytes u32
+
+  inline void putLe16(unsigned char* p, uint16_t v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+  }
+
+  inline void putLe32(unsigned char* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = (unsigned char)(v >> (8 * i));
+  }
+
+  inline uint16_t getLe16(const unsigned char* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+  }
+
+  inline uint32_t getLe32(const unsigned char* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+  }
+
+  //Decodes one tile into top-down RGB rows; false on malformed data
+  inline bool decodeTile(const unsigned char* data, size_t bytes, unsigned char* rgb, size_t stride,
+                         int width, int height) {
+    const size_t total = (size_t)width * height;
+    size_t pixel = 0;
+    const unsigned char* end = data + bytes;
+
+    auto put = [&](const unsigned char* c) {
+      unsigned char* dst = rgb + (pixel / width) * stride + (pixel % width) * 3;
+      dst[0] = c[0];
+      dst[1] = c[1];
+      dst[2] = c[2];
+      ++pixel;
+    };
+
+    while (data < end) {
+      const unsigned char packet = *data++;
+      const size_t n = (size_t)(packet & 0x7F) + 1;
+      const bool run = (packet & 0x80) != 0;
+      if (pixel + n > total || (size_t)(end - data) < (run ? 3 : 3 * n)) return false;
+
+      if (run) {
+        for (size_t i = 0; i < n; ++i) put(data);
+        data += 3;
+      } else {
+        for (size_t i = 0; i < n; ++i, data += 3) put(data);
+      }
+    }
+    return pixel == total;
+  }
+}
@@ -1,7 +1,7 @@
 #pragma once
 
-#include "gfx/Shader.hpp"
 #include <glad/glad.h>
+#include <vector>
 
 class CompasRenderer {
 public:
@@ -32,53 +32,22 @@ public:
   float getPerpLineOffset() const { return perp_line_offset_; }
   
   void toggleToFromFlag() { is_to_flag_ = !is_to_flag_; }
+  void setToFromFlag(bool is_to) { is_to_flag_ = is_to; }
   bool getToFromFlagState() const { return is_to_flag_; }
 
 private:
-  void buildRingGeometry(float radius_ndc, int segments);
-  void buildTicksGeometry(float radius_ndc,
-                         float len_cardinal,
-                         float len_major,
-                         float len_medium,
-                         float len_minor);
   void buildCardinalMarkersGeometry(float radius_ndc, float size_ndc);
   void buildHeadingIndicatorGeometry();
 
-  Shader shader_;
-
-  GLuint vao_ = 0;
-  GLuint vbo_ = 0;
-  int vertex_count_ = 0;
-
-  GLuint cardinal_vao_ = 0;
-  GLuint cardinal_vbo_ = 0;
-  int cardinal_count_ = 0;
-
-  GLuint major_vao_ = 0;
-  GLuint major_vbo_ = 0;
-  int major_count_ = 0;
-
-  GLuint medium_vao_ = 0;
-  GLuint medium_vbo_ = 0;
-  int medium_count_ = 0;
-
-  GLuint minor_vao_ = 0;
-  GLuint minor_vbo_ = 0;
-  int minor_count_ = 0;
-
-  GLuint markers_vao_ = 0;
-  GLuint markers_vbo_ = 0;
-  int markers_vertex_count_ = 0;
-
-  GLuint heading_indicator_vao_ = 0;
-  GLuint heading_indicator_vbo_ = 0;
-  int heading_indicator_vertex_count_ = 0;
+  std::vector<float> markers_verts_;
+  std::vector<float> heading_indicator_verts_;
 
   float heading_deg_ = 0.0f;
 
   int width_ = 800;
   int height_ = 600;
 
+  float ring_radius_ = 0.70f;
   float tick_outer_r_ = 0.70f;
   float tick_inner_r_90_ = 0.10f;
   float tick_inner_r_30_ = 0.08f;
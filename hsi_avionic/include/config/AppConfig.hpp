@@ -42,7 +42,7 @@ namespace PerpLineConfig {
   constexpr float LINE_LENGTH = 0.20f;
   constexpr float LINE_WIDTH  = 6.0f;
 
-  constexpr float SENSITIVITY      = 0.008f;
+  constexpr float SLEW_RATE        = 0.48f;   // NDC per second while 1/2 is held
   constexpr float MAX_OFFSET_RIGHT =  0.45f;
   constexpr float MAX_OFFSET_LEFT  = -0.45f;
 }
@@ -57,12 +57,14 @@ namespace DataConfig {
   // GPS
   constexpr const char* GPS_STATUS = "GPS OK";
   constexpr float GPS_Y = 0.80f;
+  constexpr float GPS_LATITUDE  = 51.1934f;   // EDAB
+  constexpr float GPS_LONGITUDE = 14.5197f;
 
   // IAS
   constexpr float IAS_VALUE = 181.0f;
   constexpr float IAS_Y     = 0.0f;
 
-  // Course / GS
+  // Course / GS (COG is GPS true track, displayed magnetic)
   constexpr float COURSE_COG   = 45.0f;
   constexpr float COURSE_GS    = 181.0f;
   constexpr float COURSE_Y_COG = 0.90f;
@@ -111,8 +113,115 @@ namespace DataConfig {
   constexpr float HEADING_BOX_HEIGHT = 0.10f;
 }
 
+//Magnetic variation
+namespace MagneticConfig {
+  constexpr const char* COF_PATH = "../assets/wmm/WMM.COF";
+  constexpr int GRID_TILE_DEG = 10;   // lazily built tile size
+  constexpr int GRID_STEP_DEG = 1;    // node spacing inside a tile
+}
+
+//Software rasterizer backend
+namespace SoftwareConfig {
+  constexpr int TILE_SIZE = 64;       // pixels per tile side
+  constexpr unsigned THREADS = 0;     // 0 = hardware concurrency
+}
+
+//Simulation and render rates
+namespace TimingConfig {
+  constexpr double SIM_HZ = 100.0;        // fixed state update rate (--sim-hz)
+  constexpr int MAX_SIM_STEPS = 10;       // per rendered frame; time beyond that is dropped after a stall
+  constexpr double RENDER_HZ_CAP = 0.0;   // 0 = uncapped (--fps-cap)
+  constexpr bool VSYNC = true;            // --no-vsync
+}
+
+//Input-to-photon latency measurement
+namespace LatencyConfig {
+  constexpr bool ENABLED = false;          // --latency-report
+  constexpr double REPORT_INTERVAL_S = 5.0;
+}
+
+//Continuous frame recording (--record path)
+namespace RecordConfig {
+  constexpr int PBO_COUNT = 3;            // readbacks in flight
+  constexpr int MAX_QUEUED_FRAMES = 8;    // waiting for the encoder thread; more are dropped
+  constexpr double FPS = 60.0;            // frame rate written to Y4M headers
+}
+
+//Shared-memory frame ring for an external compositor (--shm-output [name])
+namespace SharedFrameConfig {
+  constexpr const char* NAME = "/hsi_frames";   // shm_open name
+  constexpr int SLOT_COUNT = 3;                 // 2 = double, 3 = triple buffered
+}
+
+//Tile delta stream to a remote viewer (--delta-stream [port])
+namespace DeltaStreamConfig {
+  constexpr const char* ADDRESS = "127.0.0.1";  // listen address
+  constexpr int PORT = 47800;
+  constexpr int TILE_SIZE = 32;                 // pixels; 4..64
+  constexpr int MAX_QUEUED_FRAMES = 4;          // waiting for the streamer thread; more are dropped
+}
+
+//Draw-command stream to remote display heads (--command-stream, --remote-head)
+namespace RemoteConfig {
+  constexpr const char* ENDPOINT = "unix:/tmp/hsi_commands.sock";  // or "[host:]port" over TCP
+  constexpr int MAX_QUEUED_FRAMES = 4;          // waiting for the sender thread; more are merged
+  constexpr double CONNECT_TIMEOUT_S = 10.0;    // a head waits this long for the HSI to listen
+}
+
+//Fleet wall (--fleet [N]): N instruments on a grid, batched into one frame
+namespace FleetConfig {
+  constexpr int WINDOW_WIDTH = 1920;
+  constexpr int WINDOW_HEIGHT = 1080;
+  constexpr int DEFAULT_COUNT = 64;
+  constexpr int MAX_COUNT = 256;
+  constexpr float MIN_TURN_RATE_DPS = 2.0f;     // simulated headings turn at 2..14 deg/s
+  constexpr float MAX_TURN_RATE_DPS = 14.0f;
+}
+
+//Runtime resolution (--size WxH, window resize): the WIDTH x HEIGHT layout is
+//fitted into the framebuffer with its aspect kept
+namespace ResizeConfig {
+  constexpr int MIN_WIDTH = 320;
+  constexpr int MIN_HEIGHT = 240;
+  constexpr double SETTLE_S = 0.3;              // atlases are rebuilt once the size has held this long
+  constexpr float RASTER_SCALE_STEP = 0.125f;   // atlas raster scales are rounded to this
+  constexpr float MIN_RASTER_SCALE = 0.5f;
+  constexpr float MAX_RASTER_SCALE = 2.0f;
+}
+
+//Adaptive quality: GPU frame time is held under a budget by stepping MSAA, then
+//internal resolution (upscaled on present). Edges keep their shader AA without MSAA.
+namespace QualityConfig {
+  constexpr bool ENABLED = true;                 // --no-governor: window MSAA 4x at full resolution
+  constexpr double BUDGET_MS = 1000.0 / 60.0;    // --frame-budget <ms>
+  constexpr int WINDOW_FRAMES = 30;              // frame times are averaged over this many frames
+  constexpr double HEADROOM = 0.7;               // step up when a window averages under this share of the budget
+  constexpr int UP_WINDOWS = 4;                  // ... this many windows in a row
+  constexpr int MAX_UP_WINDOWS = 64;             // wait doubles each time a level is left again
+  constexpr int MAX_PENDING_QUERIES = 8;
+
+  constexpr int LEVEL_COUNT = 6;
+  constexpr int SAMPLES[LEVEL_COUNT] = { 4, 2, 0, 0, 0, 0 };
+  constexpr float RESOLUTION_SCALE[LEVEL_COUNT] = { 1.0f, 1.0f, 1.0f, 0.85f, 0.7f, 0.5f };
+}
+
+//Frame pipelining: a builder thread records the next frame while the GL thread submits
+namespace PipelineConfig {
+  constexpr bool ENABLED = true;        // --no-pipeline builds on the GL thread instead
+  constexpr int MAX_QUEUED_FRAMES = 1;  // finished frames waiting for submission (--pipeline-depth)
+  constexpr int MAX_DEPTH = 4;          // largest --pipeline-depth; each frame queued adds a frame of latency
+}
+
+//Program binary cache
+namespace ProgramCacheConfig {
+  constexpr bool ENABLED = true;
+  constexpr const char* DIRECTORY = "program_cache";   // relative to the working directory
+}
+
 //Fonts
 namespace FontConfig {
+  constexpr const char* BAKED_ATLAS_PATH = "fonts.atlas";   // written by the bake_fonts target
+
   constexpr int FONT_COUNT = 12;
   constexpr const char* PATHS[FONT_COUNT] = {
     "../assets/fonts/DejaVuSans-Bold.ttf", // CARDINAL
@@ -2,6 +2,16 @@
 
 #include "data/HsiData.hpp"
 
+//Advanced only by the fixed-rate simulation tick
+struct SimulationState {
+  float heading_deg = 0.0f;
+  float bug_heading = 0.0f;
+  float wp_left_bearing = 347.0f;
+  float wp_right_bearing = 324.0f;
+  float cdi_offset = 0.0f;
+  bool to_flag = true;
+};
+
 struct ApplicationState {
   //Navigation data
   float heading_deg = 0.0f;
@@ -9,6 +19,12 @@ struct ApplicationState {
   float wp_left_bearing = 347.0f;
   float wp_right_bearing = 324.0f;
 
+  //Position and true track from GPS
+  float latitude_deg = 0.0f;
+  float longitude_deg = 0.0f;
+  float cog_true = 0.0f;
+  float magnetic_variation = 0.0f;   // east positive
+
   //Data groups
   WindGroup wind;
   GpsGroup gps;
@@ -19,9 +35,34 @@ struct ApplicationState {
   WaypointGroup wp_right;
   BugGroup bug;
 
+  //Render values between two simulation ticks; alpha = 0 gives prev
+  void interpolate(const SimulationState& prev, const SimulationState& next, float alpha) {
+    heading_deg = lerpAngle(prev.heading_deg, next.heading_deg, alpha);
+    bug_heading = lerpAngle(prev.bug_heading, next.bug_heading, alpha);
+    wp_left_bearing = lerpAngle(prev.wp_left_bearing, next.wp_left_bearing, alpha);
+    wp_right_bearing = lerpAngle(prev.wp_right_bearing, next.wp_right_bearing, alpha);
+  }
+
+  //Shortest way round, result in [0, 360)
+  static float lerpAngle(float a, float b, float alpha) {
+    float d = b - a;
+    if (d > 180.0f) d -= 360.0f;
+    if (d < -180.0f) d += 360.0f;
+
+    float v = a + d * alpha;
+    if (v < 0.0f) v += 360.0f;
+    if (v >= 360.0f) v -= 360.0f;
+    return v;
+  }
+
   void updateFromHeading() {
     bug.value = bug_heading;
     wp_left.bearing = wp_left_bearing;
     wp_right.bearing = wp_right_bearing;
+
+    float cog_mag = cog_true - magnetic_variation;
+    if (cog_mag < 0.0f) cog_mag += 360.0f;
+    if (cog_mag >= 360.0f) cog_mag -= 360.0f;
+    course.cog_value = cog_mag;
   }
 };
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "core/InputHandler.hpp"
+#include "gfx/CommandList.hpp"
+
+//Everything a frame is built from, sampled on the GL thread
+struct FrameInput {
+  std::vector<InputHandler::KeyEvent> events;   // since the previous frame
+  double time_s;
+  int width, height;     // framebuffer size
+};
+
+//A finished frame and the oldest input event it is the first to reflect
+struct BuiltFrame {
+  CommandList::Frame* commands;
+  double input_time_s;   // < 0: no new input
+};
+
+// Two-stage frame pipeline. A builder thread applies input, updates the state
+// and records frame N+1 into a CommandList frame while the GL thread submits
+// frame N. At most max_queued finished frames wait for the GL thread, which
+// bounds the added latency to that many frames; max_queued = 0 builds on the
+// calling thread for minimum latency.
+class FramePipeline {
+public:
+  //Records one frame; returns the oldest input time it reflects, or -1
+  using BuildFn = std::function<double(const FrameInput& input)>;
+
+  FramePipeline(int max_queued, BuildFn build);
+  ~FramePipeline();
+
+  FramePipeline(const FramePipeline&) = delete;
+  FramePipeline& operator=(const FramePipeline&) = delete;
+
+  //Starts a frame built from input; returns the oldest finished frame once more
+  //than max_queued are in flight, no commands while the pipeline fills
+  BuiltFrame advance(const FrameInput& input);
+
+  //Joins the builder and drops frames that were never submitted
+  void stop();
+
+  int maxQueued() const { return max_queued_; }
+
+private:
+  void builderLoop();
+
+  int max_queued_;
+  BuildFn build_;
+  std::thread builder_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<FrameInput> inputs_;
+  std::deque<BuiltFrame> finished_;
+  int in_flight_ = 0;
+  bool stopping_ = false;
+};
@@ -2,22 +2,56 @@
 
 #include <glad/glad.h> 
 #include <GLFW/glfw3.h>
-#include "compas/CompasRenderer.hpp"
+#include <deque>
+#include <vector>
+#include "core/ApplicationState.hpp"
 
+// Key callbacks append timestamped events on the GLFW thread; the state update
+// drains them in order, one fixed tick at a time, so every press and release
+// lands in the tick that covers its timestamp.
 class InputHandler {
 public:
-  void processInput(GLFWwindow* window, float& heading_deg, float& bug_heading,
-                    float& wp_left_bearing, float& wp_right_bearing,
-                    CompasRenderer& compas, float delta_time);
+  enum Key : uint8_t {
+    KEY_HEADING_LEFT, KEY_HEADING_RIGHT,
+    KEY_BUG_UP, KEY_BUG_DOWN,
+    KEY_WP_LEFT_UP, KEY_WP_LEFT_DOWN,
+    KEY_WP_RIGHT_UP, KEY_WP_RIGHT_DOWN,
+    KEY_CDI_LEFT, KEY_CDI_RIGHT,
+    KEY_TO_FROM,
+    KEY_COUNT
+  };
+
+  struct KeyEvent {
+    Key key;
+    bool pressed;
+    double time_s;       // glfwGetTime() when the callback ran
+  };
+
+  //GLFW thread only. ESC closes the window from the callback
+  static void install(GLFWwindow* window);
+  //Moves the events queued since the last call to the end of out
+  static void drainEvents(std::vector<KeyEvent>& out);
+
+  //State update side: events wait here until a tick reaches their timestamp
+  void queue(const std::vector<KeyEvent>& events);
+
+  //One fixed simulation step of dt seconds ending at tick_time_s; every slew is
+  //a rate, so the result does not depend on how often frames are rendered
+  void processInput(SimulationState& sim, double tick_time_s, float dt);
+
+  //Oldest event applied since the last call, or -1; the frame being built is
+  //the first to reflect it
+  double takeAppliedInputTime();
 
 private:
-  bool key3_pressed_ = false;
-
-  void handleHeadingAdjustment(GLFWwindow* window, float& heading_deg, 
-                               CompasRenderer& compas, float delta_time);
-  void handleBugHeadingAdjustment(GLFWwindow* window, float& bug_heading, float delta_time);
-  void handleWaypointAdjustment(GLFWwindow* window, float& wp_left_bearing, 
-                                float& wp_right_bearing, float delta_time);
-  void handlePerpLineControl(GLFWwindow* window, CompasRenderer& compas);
-  void handleToFromToggle(GLFWwindow* window, CompasRenderer& compas);
-};
\ No newline at end of file
+  bool held_[KEY_COUNT] = {};
+  std::deque<KeyEvent> pending_;
+  double applied_time_s_ = -1.0;
+
+  void applyEvent(const KeyEvent& e, SimulationState& sim);
+
+  void handleHeadingAdjustment(SimulationState& sim, float dt);
+  void handleBugHeadingAdjustment(SimulationState& sim, float dt);
+  void handleWaypointAdjustment(SimulationState& sim, float dt);
+  void handlePerpLineControl(SimulationState& sim, float dt);
+};
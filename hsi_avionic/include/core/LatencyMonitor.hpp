@@ -0,0 +1,44 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <deque>
+#include <ostream>
+#include <vector>
+
+// Input-to-photon latency. For every frame that is the first to reflect an
+// input event, input-to-swap is taken on the CPU when glfwSwapBuffers returns
+// and input-to-present from a GL_TIMESTAMP query issued right after the swap,
+// i.e. when the GPU has finished the frame. A fence tells when the query can
+// be read without stalling. GPU time is mapped onto glfwGetTime() by sampling
+// both clocks together, again at every report.
+class LatencyMonitor {
+public:
+  //GL thread only
+  void init();
+  void shutdown();
+
+  //After glfwSwapBuffers; input_time_s < 0 means the frame reflects no new input
+  void frameSwapped(double input_time_s, double swap_time_s);
+
+  //Collects finished queries; call once per frame
+  void poll();
+
+  //Distributions since the last report, then starts over
+  void report(std::ostream& out);
+
+private:
+  struct Pending {
+    GLuint query;
+    GLsync fence;
+    double input_time_s;
+  };
+
+  void calibrate();
+
+  std::deque<Pending> pending_;
+  std::vector<GLuint> free_queries_;
+  std::vector<double> to_swap_ms_;
+  std::vector<double> to_present_ms_;
+  double gpu_to_cpu_s_ = 0.0;    // cpu seconds = gpu ns * 1e-9 + gpu_to_cpu_s_
+  bool ready_ = false;
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <chrono>
+#include <deque>
+#include <ostream>
+#include <vector>
+
+// Holds a frame-time budget by stepping render quality. Every frame's submit
+// and present are timed with a GL_TIME_ELAPSED query, read once its result is
+// available, and on the CPU; the frame costs the larger of the two, since
+// software rasterizers such as llvmpipe draw on the calling thread and report
+// only part of it. Times are averaged over QualityConfig::WINDOW_FRAMES.
+// A window over budget steps one level down (QualityConfig::SAMPLES,
+// RESOLUTION_SCALE). UP_WINDOWS windows in a row under HEADROOM of the budget
+// step one level up. A level that is left for being over budget waits twice as
+// long before it is tried again. The window after a step is discarded while
+// the new level settles. GL thread only.
+class QualityGovernor {
+public:
+  void init(double budget_ms);
+  void shutdown();
+
+  //Around the GPU work of one frame: submit and present
+  void beginFrame();
+  void endFrame();
+
+  //Reads finished queries; true when the level changed
+  bool poll();
+
+  int level() const { return level_; }
+  int samples() const;
+  float resolutionScale() const;
+
+  //Frames and mean GPU time at each level, and the steps taken
+  void report(std::ostream& out) const;
+
+private:
+  void sample(double ms);
+
+  double budget_ms_ = 0.0;
+  int level_ = 0;
+  bool active_ = false;
+  GLuint running_ = 0;               // query between beginFrame and endFrame
+  std::chrono::steady_clock::time_point started_;
+
+  struct Pending {
+    GLuint query;
+    double cpu_ms;
+  };
+  std::deque<Pending> pending_;
+  std::vector<GLuint> free_queries_;
+
+  double window_sum_ = 0.0;
+  int window_frames_ = 0;
+  bool settling_ = false;
+  int calm_windows_ = 0;             // consecutive windows with headroom
+  bool entered_from_below_ = false;  // the current level was reached by stepping up
+  std::vector<int> up_windows_;      // windows of headroom needed to step up to each level
+
+  std::vector<int> frames_;          // per level
+  std::vector<double> frame_ms_;
+  int steps_down_ = 0;
+  int steps_up_ = 0;
+};
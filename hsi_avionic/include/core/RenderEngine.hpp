@@ -3,22 +3,41 @@
 #include <glad/glad.h>
 #include "compas/CompasRenderer.hpp"
 #include "gfx/TtfTextRenderer.hpp"
-#include "gfx/Shader.hpp"
 #include "ui/HsiUiRenderer.hpp"
+#include "ui/Readout.hpp"
 #include "core/ApplicationState.hpp"
 #include "config/AppConfig.hpp"
 
 class RenderEngine {
 public:
-  RenderEngine(Shader& shader);
-
+  //One instrument filling the window
   void renderFrame(CompasRenderer& compas, 
                    TtfTextRenderer fonts[],
                    HsiUiRenderer& ui_renderer,
                    ApplicationState& state);
 
+  //Several instruments in one frame: beginFrame() once, then renderInstrument()
+  //per instrument under its InstrumentView placement. Every instrument's draws
+  //batch into the same per-layer commands. beginFrame() sets only what all
+  //instruments share; each one's heading travels with its own draws.
+  static void beginFrame();
+  void renderInstrument(CompasRenderer& compas,
+                        TtfTextRenderer fonts[],
+                        HsiUiRenderer& ui_renderer,
+                        ApplicationState& state);
+
 private:
-  Shader& shader_;
+  //Draw order between layers is fixed; inside a layer CommandList sorts by state
+  enum FrameLayer : uint8_t {
+    LAYER_DIAL,        // ring and tick rose
+    LAYER_SYMBOLS,     // compass markers, aircraft, IAS/ALT frames
+    LAYER_TEXT,        // every label and readout
+    LAYER_NAV,         // waypoint arrows
+    LAYER_CDI,         // deviation dots
+    LAYER_OVERLAY      // CDI bar, TO/FROM flag, heading box, bug
+  };
+
+  static void beginLayer(FrameLayer layer);
 
   void renderCompass(CompasRenderer& compas, TtfTextRenderer& ttf_cardinal,
                      TtfTextRenderer& ttf_numbers, float heading_deg);
@@ -27,4 +46,12 @@ private:
                             float heading_deg);
 
   void renderNavigationOverlays(CompasRenderer& compas, const ApplicationState& state);
+
+  Readout heading_readout_{ "", { 0, 3, "" } };
+
+  //Retained label meshes, created on first use
+  TtfTextRenderer::TextHandle cardinal_text_[4] = { -1, -1, -1, -1 };
+  TtfTextRenderer::TextHandle number_text_[8] = {};
+  TtfTextRenderer::TextHandle hdg_text_ = -1;
+  TtfTextRenderer::TextHandle mag_text_ = -1;
 };
\ No newline at end of file
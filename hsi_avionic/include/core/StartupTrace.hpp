@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+
+// Startup phase timings for cold-start measurement. Scopes may be opened on
+// any thread; times are relative to begin(). Recording stops at
+// firstFrame(), which also fixes the time-to-first-frame.
+class StartupTrace {
+public:
+  //Call first thing in main()
+  static void begin();
+
+  static double elapsedMs();
+  static void record(const char* name, const std::string& detail, double start_ms, double end_ms);
+
+  //Stops recording after the first presented frame
+  static void firstFrame();
+  static double timeToFirstFrameMs();
+
+  //path "-" writes to stderr
+  static bool writeJson(const std::string& path);
+
+  class Scope {
+  public:
+    explicit Scope(const char* name, std::string detail = std::string());
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    void setDetail(std::string detail) { detail_ = std::move(detail); }
+
+  private:
+    const char* name_;
+    std::string detail_;
+    double start_ms_;
+  };
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+// One-shot dependency graph used for startup. Worker tasks run on a
+// ThreadPool; Main tasks run on the thread that calls run() (the GL context
+// thread) as soon as their dependencies finish. A failed task skips all of
+// its dependents. Each task is recorded in StartupTrace.
+class TaskGraph {
+public:
+  enum class Affinity { Worker, Main };
+  using TaskId = int;
+
+  TaskId add(const char* name, Affinity affinity, std::function<bool()> fn,
+             std::vector<TaskId> deps = {});
+
+  //Blocks until every task has run or been skipped; true if all succeeded
+  bool run(ThreadPool& pool);
+
+private:
+  struct Task {
+    std::string name;
+    Affinity affinity;
+    std::function<bool()> fn;
+    std::vector<TaskId> dependents;
+    int pending_deps = 0;
+    bool failed_dep = false;
+  };
+
+  void schedule(ThreadPool& pool, TaskId id);
+  void execute(ThreadPool& pool, TaskId id);
+  void finish(ThreadPool& pool, TaskId id, bool ok);
+
+  std::vector<Task> tasks_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<TaskId> main_queue_;
+  int remaining_ = 0;
+  bool all_ok_ = true;
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "core/MappedFile.hpp"
+#include "gfx/FontAtlas.hpp"
+
+// Pre-baked font atlases produced by tools/font_baker. The file is mapped
+// read-only and atlases point straight into the mapping, so it must stay
+// open for as long as any adopted FontAtlas is used.
+//
+// Layout: Header, Entry[count], then 16-byte aligned R8 pixel blocks.
+class BakedFontFile {
+public:
+  static constexpr uint32_t VERSION = 1;
+
+  struct Source {
+    std::string path;
+    float pixel_height;
+    const FontAtlas* atlas;
+  };
+
+  static bool write(const std::string& out_path, const std::vector<Source>& sources);
+
+  bool open(const std::string& path);
+  bool isOpen() const { return file_.isOpen(); }
+
+  //Fills the atlas if an entry for (path, size) with the current glyph set exists
+  bool find(const std::string& ttf_path, float pixel_height, FontAtlas& atlas) const;
+
+private:
+  struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+  };
+
+  struct Entry {
+    char path[128];
+    float pixel_height;
+    uint32_t glyph_set;
+    uint32_t width;
+    uint32_t height;
+    uint64_t pixels_offset;
+    FontAtlas::BakedChar chars[FontAtlas::CHAR_COUNT];
+  };
+
+  MappedFile file_;
+  const Entry* entries_ = nullptr;
+  uint32_t count_ = 0;
+};
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+class Shader;
+
+// Per-frame draw command list. Renderers record draws (program, textures,
+// vertex range, uniform values) instead of issuing GL calls, and put the
+// frame's vertex data into byte streams. finish() closes the frame on the
+// recording thread; submit() on the GL thread uploads every stream once,
+// sorts the draws by layer and then by state, merges adjacent ranges with
+// identical state and issues them in one pass. Recording makes no GL calls,
+// so a frame can be built on another thread while the previous one is
+// submitted. Submission order is only kept across layers, so draws sharing a
+// layer must not overlap each other.
+class CommandList {
+public:
+  static constexpr int TEXTURE_UNITS = 4;
+
+  struct Texture {
+    GLenum target;
+    GLuint name;
+  };
+
+  struct Command {
+    uint8_t layer;
+    uint32_t seq;                    // recording order, last sort key
+    const Shader* shader;
+    GLuint vao;
+    Texture textures[TEXTURE_UNITS];
+    bool blend;
+    GLenum primitive;
+    int first;                       // first vertex, or first instance
+    int count;                       // vertices, or instances
+    int index_count;                 // > 0: instanced draw over the VAO's GL_UNSIGNED_BYTE indices
+    GLuint instance_buffer;
+    void (*bind_instances)(GLuint buffer, int first);   // GL 3.3 has no base instance
+    uint32_t uniform_first;
+    uint32_t uniform_count;
+  };
+
+  //Recorded commands, uniform values and stream data of one frame
+  struct Frame;
+
+  struct Stats {
+    int commands;
+    int draws;
+    int program_changes;
+    int texture_changes;
+  };
+
+  //Layer for the commands recorded from now on; lower layers are drawn first
+  static void setLayer(uint8_t layer);
+  static uint8_t layer();
+
+  //Records a non-indexed draw; textures and instancing can be set on the returned
+  //command, which stays valid until the next record()
+  static Command& record(const Shader& shader, GLuint vao, GLenum primitive, int first, int count);
+
+  //Uniform values of the command recorded last
+  static void uniform1i(GLint location, int v);
+  static void uniform2f(GLint location, float x, float y);
+  static void uniform3f(GLint location, float x, float y, float z);
+  static void uniform4f(GLint location, float x, float y, float z, float w);
+  static void uniform4i(GLint location, int x, int y, int z, int w);
+  static void uniform4fv(GLint location, int count, const float* v);
+
+  //Recorded commands by index, for finish hooks that patch ranges known only then
+  static size_t size();
+  static Command& at(size_t index);
+
+  //Cleared before the frame's first draw
+  static void setClearColor(float r, float g, float b);
+
+  //Streams and hooks are registered on the GL thread before recording starts.
+  //A stream collects bytes while a frame is recorded; upload receives them on
+  //submit (only when non-empty).
+  static int addStream(std::function<void(const unsigned char* data, size_t bytes)> upload);
+  static std::vector<unsigned char>& stream(int id);
+  //The frame's payload of a cumulative stream holds everything sent so far:
+  //remote senders retain it in place of the earlier payloads
+  static void restartStream(int id);
+
+  //Called by finish() on the recording thread, in registration order
+  static void addFinishHook(std::function<void()> hook);
+
+  //Closes the frame being recorded; recording continues into a new one
+  static Frame* finish();
+
+  //Uploads, draws and recycles a finished frame; GL thread only
+  static void submit(Frame* frame);
+  //Recycles a finished frame without drawing it
+  static void discard(Frame* frame);
+
+  static void shutdown();
+
+  static const Stats& lastStats();
+
+  //Remote replay. Every shader, GL object, stream and instance binder a
+  //command can reference is exported under a key that is the same in every
+  //process built from this tree, so a frame encoded here decodes into commands
+  //on another process's own objects. Keys are owner << 8 | slot; 0 is none.
+  enum RemoteOwner : uint16_t {
+    REMOTE_PRIMITIVES = 1,
+    REMOTE_SDF_SHAPES,
+    REMOTE_FRAME_UNIFORMS,
+    REMOTE_TEXT_SHADERS,
+    REMOTE_FONT_FIRST = 16           // font i is REMOTE_FONT_FIRST + i
+  };
+  enum class ObjectKind : uint8_t { VertexArray, Buffer, Texture };
+
+  static constexpr uint16_t remoteKey(uint16_t owner, uint8_t slot) { return (uint16_t)(owner << 8 | slot); }
+
+  static void exportShader(uint16_t key, const Shader* shader);
+  static void exportObject(ObjectKind kind, uint16_t key, GLuint name);
+  static void exportBinder(uint16_t key, void (*bind)(GLuint buffer, int first));
+  //cumulative: each payload adds to the earlier ones instead of replacing them
+  static void exportStream(uint16_t key, int stream, bool cumulative = false);
+
+  struct EncodedStream {
+    uint16_t key;
+    bool cumulative;
+    bool restart;                    // replaces the retained payloads of a cumulative stream
+    std::vector<unsigned char> bytes;
+  };
+
+  //Non-empty streams plus the body: clear color, commands and their uniforms
+  struct EncodedFrame {
+    std::vector<EncodedStream> streams;
+    std::vector<unsigned char> body;
+  };
+
+  //Copies a finished frame with handles replaced by keys; call before submit()
+  static void encode(const Frame* frame, EncodedFrame& out);
+
+  //Uniform names of the exported shaders, so locations can be translated
+  static void encodeSetup(std::vector<unsigned char>& out);
+  static bool applySetup(const unsigned char* data, size_t bytes);
+
+  //Wire frame: u32 stream count, per stream u16 key, u16 0, u32 size and the
+  //bytes, then the body. Returns a frame for submit(), or nullptr when the
+  //data is malformed or names a key this process has not exported.
+  static Frame* decode(const unsigned char* data, size_t bytes);
+};
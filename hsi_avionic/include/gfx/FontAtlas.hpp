@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct stbtt_fontinfo;
+
+// CPU side of a baked font: atlas bitmap, glyph metrics and text layout.
+// Shared by the GL text renderer and the software rasterizer.
+// Page 0 is the static atlas (ASCII + degree sign, possibly baked). Any other
+// code point is rasterized on first use into dynamic pages packed in
+// fixed-height shelves; when they are full the least recently used shelf is
+// evicted. Glyphs used in the current frame are never evicted.
+class FontAtlas {
+public:
+  struct BakedChar {
+    float x0, y0, x1, y1;
+    float xoff, yoff, xadvance;
+  };
+
+  //Corners in NDC: (x0,y0) (x1,y0) (x1,y1) (x0,y1); UVs normalized to page
+  struct GlyphQuad {
+    float px[4], py[4];
+    float u0, v0, u1, v1;
+    int page;
+  };
+
+  //Page region rasterized since the last clearDirty()
+  struct DirtyRect {
+    int page, x, y, w, h;
+  };
+
+  static constexpr int atlas_w = 512;
+  static constexpr int atlas_h = 512;          // packing area; doubled for large sizes, unused rows are trimmed
+  static constexpr int MAX_ATLAS_H = 4096;
+  static constexpr float kScale = 0.0020f;   // pixels -> NDC at the design raster size
+
+  static constexpr int CHAR_COUNT = 256;
+  static constexpr unsigned GLYPH_SET = 1;     // ASCII 32-126 + degree sign; bump when it changes
+
+  static constexpr int PAGE_SIZE = 512;        // dynamic page side
+  static constexpr int MAX_PAGES = 4;          // dynamic pages per font
+
+  FontAtlas();
+  ~FontAtlas();
+
+  FontAtlas(const FontAtlas&) = delete;
+  FontAtlas& operator=(const FontAtlas&) = delete;
+
+  //Rasterizes the static page; drops any dynamic glyphs of an earlier build
+  bool build(const std::string& ttf_path, float pixel_height);
+
+  //Uses pre-baked metrics and pixels without copying; pixels must outlive the atlas.
+  //The TTF is only read if a glyph outside the static set is requested.
+  void adopt(const BakedChar chars[CHAR_COUNT], const unsigned char* pixels, int height,
+             const std::string& ttf_path, float pixel_height);
+
+  //NDC per atlas pixel in layouts: kScale for the design size, kScale / s for
+  //an atlas rasterized s times larger, so text keeps its size on screen
+  void setGlyphScale(float scale) { glyph_scale_ = scale; }
+  float glyphScale() const { return glyph_scale_; }
+
+  //Advances the LRU clock; call once per frame before any layout
+  static void beginFrame();
+
+  //Next code point of a UTF-8 string; malformed input yields U+FFFD and skips one byte
+  static uint32_t decodeUtf8(const char*& p);
+
+  //Rasterizes the glyph on first use; nullptr only if no page space can be freed
+  const BakedChar* getCharMetrics(uint32_t codepoint, int* page = nullptr);
+  const BakedChar* charTable() const { return chars_; }
+
+  //Static page
+  const unsigned char* pixels() const { return pixels_; }
+  int width() const { return atlas_w; }
+  int height() const { return height_; }
+
+  int pageCount() const { return 1 + (int)pages_.size(); }
+  const unsigned char* pagePixels(int page) const;
+  int pageWidth(int page) const { return page == 0 ? atlas_w : PAGE_SIZE; }
+  int pageHeight(int page) const { return page == 0 ? height_ : PAGE_SIZE; }
+
+  const std::vector<DirtyRect>& dirtyRects() const { return dirty_; }
+  void clearDirty() { dirty_.clear(); }
+
+  bool measure(const char* text, float& minx, float& miny, float& maxx, float& maxy);
+
+  void layoutNDC(const char* text, float x_ndc, float y_ndc, std::vector<GlyphQuad>& out);
+  void layoutCentered(const char* text, float cx_ndc, float cy_ndc, std::vector<GlyphQuad>& out);
+  void layoutCenteredRotated(const char* text, float cx_ndc, float cy_ndc, float rotation_deg,
+                             std::vector<GlyphQuad>& out);
+  void layoutLeftAligned(const char* text, float x, float y, std::vector<GlyphQuad>& out);
+  void layoutRightAligned(const char* text, float x, float y, std::vector<GlyphQuad>& out);
+
+private:
+  struct Shelf {
+    int y;
+    int x;                          // next free column
+    uint32_t last_used;             // frame stamp
+    std::vector<uint32_t> codepoints;
+  };
+
+  struct Page {
+    std::vector<unsigned char> pixels;
+    std::vector<Shelf> shelves;
+  };
+
+  struct Glyph {
+    BakedChar bc;
+    int page;                       // >= 1, or 0 for glyphs without pixels
+    int shelf;
+  };
+
+  bool loadFont();
+  void resetDynamic();
+  const Glyph* cacheGlyph(uint32_t codepoint);
+  bool allocate(int w, int& page, int& shelf);
+
+  void setUvs(const BakedChar* bc, int page, GlyphQuad& q) const;
+
+  std::vector<unsigned char> bitmap_;
+  const unsigned char* pixels_ = nullptr;
+  int height_ = 0;
+  BakedChar chars_[CHAR_COUNT] = {};
+  float glyph_scale_ = kScale;
+
+  //Dynamic glyphs
+  std::string ttf_path_;
+  float pixel_height_ = 0.0f;
+  std::vector<unsigned char> ttf_;
+  std::unique_ptr<stbtt_fontinfo> font_;
+  bool font_failed_ = false;
+  bool full_warned_ = false;
+  float scale_ = 0.0f;
+  int shelf_height_ = 0;
+
+  std::vector<Page> pages_;
+  std::unordered_map<uint32_t, Glyph> glyphs_;
+  std::vector<DirtyRect> dirty_;
+};
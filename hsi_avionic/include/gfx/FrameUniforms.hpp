@@ -0,0 +1,32 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Per-frame values shared by every program through one std140 uniform block.
+// Shader::build binds any program declaring FrameBlock to BINDING; update()
+// puts the values into the recorded frame, whose submission uploads and binds
+// the buffer.
+class FrameUniforms {
+public:
+  static constexpr GLuint BINDING = 0;
+  static constexpr const char* BLOCK_NAME = "FrameBlock";
+
+  //Mirrors FrameBlock in GLSL_BLOCK (std140)
+  struct Data {
+    float viewport[4];        // width, height, 1/width, 1/height
+  };
+
+  //Paste into shader sources that read the block
+  static constexpr const char* GLSL_BLOCK = R"(
+    layout (std140) uniform FrameBlock {
+      vec4 uViewport;
+    };
+  )";
+
+  static bool init(int width, int height);
+  static void shutdown();
+  static void setViewport(int width, int height);
+
+  static void update();
+  static const Data& current();
+};
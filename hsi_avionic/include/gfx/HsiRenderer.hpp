@@ -5,8 +5,9 @@
 
 class HsiRenderer {
 public:
+  //label is a retained Align::Pivot text of ttf
   static void drawTextAtBearingRadial(TtfTextRenderer& ttf,
-                                      const char* label,
+                                      TtfTextRenderer::TextHandle label,
                                       float bearing_deg,
                                       float radius,
                                       float aspect_fix,
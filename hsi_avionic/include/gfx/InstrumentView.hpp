@@ -0,0 +1,31 @@
+#pragma once
+
+// Placement of the instrument being recorded inside the window. Renderers lay
+// one instrument out over the whole NDC square; the GL backends map that into
+// the window as x * scale + offset and scale pixel sizes (line widths, tick
+// and ring sizes) by pixel_scale. The default is the identity, so a window
+// showing a single instrument is unaffected. Set on the recording thread
+// before the instrument's draws.
+class InstrumentView {
+public:
+  struct Placement {
+    float scale_x = 1.0f, scale_y = 1.0f;
+    float offset_x = 0.0f, offset_y = 0.0f;
+    float pixel_scale = 1.0f;
+
+    float x(float v) const { return v * scale_x + offset_x; }
+    float y(float v) const { return v * scale_y + offset_y; }
+    bool identity() const {
+      return scale_x == 1.0f && scale_y == 1.0f && offset_x == 0.0f && offset_y == 0.0f && pixel_scale == 1.0f;
+    }
+  };
+
+  static void set(const Placement& placement);
+  static void reset();
+  static const Placement& current();
+
+  //Cell index of a grid over the window holding count instruments of the given
+  //size, aspect kept; columns are chosen for the largest cell
+  static Placement cell(int index, int count, int window_width, int window_height,
+                        int instrument_width, int instrument_height);
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Expands polylines, line lists and filled triangles into triangle lists.
+// Each vertex carries edge distances in pixels so the fragment shader can
+// anti-alias the stroke without glLineWidth / GL_LINE_SMOOTH.
+class LineTessellator {
+public:
+  enum class Join { Miter, Bevel, Round };
+  enum class Cap { Butt, Round };
+
+  struct Style {
+    float width_px = 1.0f;
+    Join join = Join::Miter;
+    Cap cap = Cap::Butt;
+    float miter_limit = 4.0f;
+  };
+
+  //side: signed distance from the centerline, half_width: stroke half width,
+  //along/length: distance along the segment for cap anti-aliasing
+  struct Vertex {
+    float x, y;
+    uint8_t r, g, b, a;
+    float side, half_width, along, length;
+  };
+
+  void setViewport(int width, int height);
+
+  void polyline(const float* xy, int count, bool closed, const Style& style,
+                const uint8_t rgba[4], std::vector<Vertex>& out) const;
+  void lines(const float* xy, int count, const Style& style,
+             const uint8_t rgba[4], std::vector<Vertex>& out) const;
+  void triangles(const float* xy, int count, const uint8_t rgba[4], std::vector<Vertex>& out) const;
+
+private:
+  struct Point { float x, y; };
+
+  Point toPixel(const float* xy) const { return { xy[0] * half_w_, xy[1] * half_h_ }; }
+
+  void emit(std::vector<Vertex>& out, Point p, const uint8_t rgba[4],
+            float side, float half_width, float along, float length) const;
+  void segment(Point a, Point b, float half_width, bool cap_start, bool cap_end,
+               const uint8_t rgba[4], std::vector<Vertex>& out) const;
+  void join(Point c, Point dir_in, Point dir_out, float half_width, const Style& style,
+            const uint8_t rgba[4], std::vector<Vertex>& out) const;
+  void fan(Point c, float angle0, float angle1, float half_width,
+           const uint8_t rgba[4], std::vector<Vertex>& out) const;
+
+  float half_w_ = 400.0f;
+  float half_h_ = 300.0f;
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <glad/glad.h>
+
+class SoftRasterizer;
+
+// Immediate 2D primitive submission used by the compass and HSI renderers.
+// Vertices are NDC xy pairs. Draws go to GL unless a software target is bound.
+// On GL, lines are tessellated into anti-aliased triangles, placed by the
+// current InstrumentView and queued per CommandList layer; each layer becomes
+// one draw when the frame is finished, and the frame's vertices are uploaded
+// once when the list is submitted.
+class Primitives {
+public:
+  enum class Mode { Lines, LineStrip, LineLoop, Triangles };
+
+  static bool init(int width, int height);
+  static void shutdown();
+  static void setViewport(int width, int height);
+
+  static void bindSoftwareTarget(SoftRasterizer* target);
+  static SoftRasterizer* softwareTarget();
+
+  static void clear(float r, float g, float b);
+
+  static void draw(const float* xy, int vertex_count, Mode mode,
+                   float r, float g, float b, float alpha = 1.0f, float line_width = 1.0f);
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <string>
+
+// On-disk cache of linked program binaries (ARB_get_program_binary).
+// Entries are keyed by a hash of the shader sources and the driver's vendor,
+// renderer and version strings; anything that fails to load is rebuilt from
+// source and rewritten. Inactive when the driver exposes no binary formats.
+class ProgramCache {
+public:
+  static void init(GLADloadproc load, const std::string& directory);
+  static bool enabled();
+
+  //Linked program for these sources, or 0 on a miss
+  static GLuint load(const char* vs_src, const char* fs_src);
+
+  //Call between glCreateProgram and glLinkProgram
+  static void prepare(GLuint program);
+  static void store(GLuint program, const char* vs_src, const char* fs_src);
+
+  static void report();
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Framebuffer a frame is drawn into at its own internal resolution and MSAA
+// level. bind() before submit makes it the draw framebuffer; present()
+// resolves the samples and scales the image into the window, with linear
+// filtering when the sizes differ. Frames at the window size without MSAA are
+// still drawn offscreen: the present blit makes every frame finish inside the
+// work being timed, also on drivers that defer drawing to the swap. Storage is
+// reallocated only when the format changes. GL thread only.
+class RenderTarget {
+public:
+  //Internal size and MSAA samples (0: none) of a frame
+  struct Format {
+    int width = 0, height = 0;
+    int samples = 0;
+
+    bool operator==(const Format& o) const { return width == o.width && height == o.height && samples == o.samples; }
+    bool operator!=(const Format& o) const { return !(*this == o); }
+  };
+
+  void bind(const Format& format, int window_width, int window_height);
+  void present();
+  void shutdown();
+
+private:
+  void allocate(const Format& format);
+
+  //0: drawn into, with format_.samples; 1: resolved, only for scaled MSAA frames
+  GLuint fbo_[2] = {};
+  GLuint color_[2] = {};
+  Format format_;
+  int window_width_ = 0;
+  int window_height_ = 0;
+  bool offscreen_ = false;
+};
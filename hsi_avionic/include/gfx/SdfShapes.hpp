@@ -0,0 +1,27 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Analytic shapes evaluated per pixel in a fragment shader: circle outlines
+// and the compass tick rose. Each shape is one instanced quad around it, placed
+// by the current InstrumentView; shapes are queued per CommandList layer and
+// every layer is one instanced draw when the frame is finished. Positions are
+// NDC; radii are in NDC y units with x aspect-corrected, matching the compass
+// geometry.
+class SdfShapes {
+public:
+  //Tick classes: every 90, 30, 10 and 5 degrees
+  enum TickClass { TICK_CARDINAL, TICK_MAJOR, TICK_MEDIUM, TICK_MINOR, TICK_CLASS_COUNT };
+
+  static bool init(int width, int height);
+  static void shutdown();
+  static void setViewport(int width, int height);
+
+  static void ring(float cx, float cy, float radius, float line_width,
+                   float r, float g, float b, float alpha = 1.0f);
+
+  //The rose turns with heading_deg, like the compass card
+  static void ticks(float cx, float cy, float outer_radius,
+                    const float lengths[TICK_CLASS_COUNT], const float widths[TICK_CLASS_COUNT],
+                    float heading_deg, float r, float g, float b);
+};
@@ -1,15 +1,41 @@
 #pragma once
 #include <glad/glad.h>
+#include <string>
+#include <vector>
 
 class Shader {
 public:
   Shader() = default;
   ~Shader();
 
+  Shader(const Shader&) = delete;
+  Shader& operator=(const Shader&) = delete;
+
   bool build(const char* vs_src, const char* fs_src);
+
+  //Binds the program unless it is already current
   void use() const;
   GLuint id() const { return program_id_; }
 
+  //Location from the table reflected at link time; -1 if not active
+  GLint uniform(const char* name) const;
+
+  //Reflected uniforms, sorted by name; arrays by their base name
+  size_t uniformCount() const { return uniforms_.size(); }
+  const std::string& uniformName(size_t i) const { return uniforms_[i].name; }
+  GLint uniformLocation(size_t i) const { return uniforms_[i].location; }
+
 private:
+  struct UniformEntry {
+    std::string name;
+    GLint location;
+  };
+
+  bool finishLink();
+  void reflectUniforms();
+
   GLuint program_id_ = 0;
+  std::vector<UniformEntry> uniforms_;
+
+  static GLuint bound_program_;
 };
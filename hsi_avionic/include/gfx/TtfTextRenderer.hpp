@@ -1,29 +1,148 @@
 #pragma once
 #include <glad/glad.h>
+#include <cstdint>
 #include <string>
+#include <vector>
+#include "gfx/FontAtlas.hpp"
+#include "gfx/Shader.hpp"
+
+class BakedFontFile;
 
 class TtfTextRenderer {
+public:
+  //Pivot: centered on (x, y) and rotated about it by drawTextTransformed
+  enum class Align { Left, Right, Center, Pivot };
+  using TextHandle = int;
+
+  //One instance per glyph; the vertex shader expands the quad (16 bytes per glyph)
+  struct GlyphInstance {
+    int16_t rect[4];     // x0, y0, x1, y1, snorm16
+    uint16_t uv[4];      // u0, v0, u1, v1, unorm16
+  };
+
 private:
-  struct BakedChar {
-    float x0, y0, x1, y1;
-    float xoff, yoff, xadvance;
+  //Laid out once into the static VBO; rebuilt only when the string, position or glyphs change
+  struct RetainedText {
+    struct Range { int page, first, count; };
+
+    std::string text;
+    Align align;
+    float x, y;
+    std::vector<FontAtlas::GlyphQuad> quads;
+    std::vector<Range> ranges;
+    bool dynamic_glyphs;             // uses evictable glyph pages
   };
 
-  GLuint program_ = 0;
-  GLuint uColor_ = 0;
+  const Shader* shader_ = nullptr;     // shared by all fonts
+  GLint uColor_ = -1;
+  GLint uTransform_ = -1;
+  GLint uPlacement_ = -1;
   GLuint tex_ = 0;
+  GLuint page_tex_[FontAtlas::MAX_PAGES] = {};     // dynamic glyph pages, index = page - 1
+  bool page_storage_[FontAtlas::MAX_PAGES] = {};   // allocated on the GL thread
+  int pages_sent_ = 0;                             // pages whose pixels went into a frame
+  size_t glyph_bytes_ = 0;                         // glyph stream bytes since the pages went out in full
   GLuint vao_ = 0;
   GLuint vbo_ = 0;
-  
-  static constexpr int atlas_w_ = 512;
-  static constexpr int atlas_h_ = 512;
-  BakedChar chars_[256];
+  GLuint static_vao_ = 0;
+  GLuint static_vbo_ = 0;
+  bool static_dirty_ = false;
+  bool ready_ = false;
+
+  std::vector<RetainedText> texts_;
+
+  //Retained draw recorded this frame; its range is patched in finishFrame()
+  struct RetainedDraw {
+    size_t command;
+    TextHandle handle;
+    int page;
+  };
+  std::vector<RetainedDraw> retained_draws_;
+
+  //Vertex pulling: static-page strings upload only their glyph codes and a
+  //string record; all of a layer's strings are one draw per font
+  enum PullAlignment { PULL_ORIGIN = 0, PULL_LEFT, PULL_RIGHT, PULL_CENTER, PULL_PIVOT };
+  static constexpr int PULL_MAX_GLYPHS = 255;        // per string
+  static constexpr int PULL_MAX_STRINGS = 65536;     // per frame
+
+  const Shader* pull_shader_ = nullptr;
+  GLint uPullAtlas_ = -1;
+  GLuint pull_vao_ = 0;
+  GLuint metrics_buf_ = 0;
+  GLuint metrics_tex_ = 0;
+  GLuint codes_buf_ = 0;
+  GLuint codes_tex_ = 0;
+  GLuint strings_buf_ = 0;
+  GLuint strings_tex_ = 0;
+  std::vector<std::vector<uint32_t>> codes_;   // this frame's glyphs per CommandList layer
+  std::vector<float> strings_;                 // this frame's string records, 16 floats each
+
+  FontAtlas atlas_;
+  std::string ttf_path_;
+  float pixel_height_ = 0.0f;             // design size; the atlas holds it times raster_scale_
+  float raster_scale_ = 1.0f;
+  const BakedFontFile* baked_ = nullptr;  // must outlive prepare() and setRasterScale()
+  bool atlas_pending_ = true;             // static page not yet sent with a frame
+  std::vector<FontAtlas::GlyphQuad> quads_;
+  std::vector<GlyphInstance> instances_;   // this frame's immediate glyphs, uploaded on submit
+
+  //CommandList streams: recorded with the frame, uploaded when it is submitted
+  int instance_stream_ = -1;
+  int codes_stream_ = -1;
+  int strings_stream_ = -1;
+  int static_stream_ = -1;
+  int glyph_stream_ = -1;
+  int atlas_stream_ = -1;
 
   bool buildShader();
-  const BakedChar* getCharMetrics(unsigned char c);
+  bool rasterize(float raster_scale);
+  void captureAtlas();
+  void uploadAtlas(const unsigned char* data, size_t bytes);
+  void packMetrics(float* out) const;
+  void captureGlyphPages();
+  void uploadGlyphPages(const unsigned char* data, size_t bytes);
+  void uploadPullBuffers();
+  bool encodeStatic(const char* text, std::vector<uint32_t>& codes, uint32_t string);
+  bool drawPulled(const char* text, int alignment, float x, float y,
+                  float cos_a, float sin_a, float r, float g, float b);
+  void drawQuads(float r, float g, float b,
+                 float cos_a = 1.0f, float sin_a = 0.0f, float tx = 0.0f, float ty = 0.0f);
+  void recordInstances(GLuint vao, GLuint vbo, int page, int first, int count,
+                       float r, float g, float b, float cos_a, float sin_a, float tx, float ty);
+  void finishFrame();
+
+  void layoutRetained(RetainedText& t);
+  bool glyphsMoved(RetainedText& t);
+  void rebuildStaticBuffer();
+  void drawRetained(RetainedText& t, float r, float g, float b,
+                    float cos_a, float sin_a, float tx, float ty);
 
 public:
-  bool init(const std::string& ttf_path, float pixel_height);
+  //Takes the atlas from baked when it has this font, otherwise rasterizes it.
+  //raster_scale rasterizes pixel_height that many times larger for a display
+  //with that many physical pixels per design pixel; text keeps its layout size
+  bool init(const std::string& ttf_path, float pixel_height, const BakedFontFile* baked = nullptr,
+            float raster_scale = 1.0f);
+
+  //init() in two halves: prepare() is CPU only and may run on any thread,
+  //upload() creates the GL objects and must run on the context thread
+  bool prepare(const std::string& ttf_path, float pixel_height, const BakedFontFile* baked = nullptr,
+               float raster_scale = 1.0f);
+  bool upload();
+
+  //Frees the programs shared by all fonts; GL thread, before the context goes
+  static void shutdownShared();
+
+  //Re-rasterizes the atlas at a new scale and lays retained text out again;
+  //the next recorded frame carries the new pixels. Recording thread only
+  bool setRasterScale(float raster_scale);
+  float rasterScale() const { return raster_scale_; }
+
+  const FontAtlas& atlas() const { return atlas_; }
+
+  //Exports the GL objects and streams for remote replay under the given
+  //CommandList owner; call in the same order in every process, after upload()
+  void exportRemote(uint16_t owner) const;
 
   void drawTextNDC(const std::string& text, float x_ndc, float y_ndc,
                   float r, float g, float b);
@@ -35,4 +154,12 @@ public:
                           float r, float g, float b);
   void drawTextRightAligned(const char* text, float x, float y,
                            float r, float g, float b);
+
+  //Retained text for labels that rarely change; handles stay valid for the renderer's lifetime
+  TextHandle createText(const char* text, Align align, float x, float y);
+  void updateText(TextHandle handle, const char* text, float x, float y);
+  void drawText(TextHandle handle, float r, float g, float b);
+  //Rotates the mesh about the origin (the pivot, for Align::Pivot) and translates it by (x, y)
+  void drawTextTransformed(TextHandle handle, float x, float y, float rotation_deg,
+                           float r, float g, float b);
 };
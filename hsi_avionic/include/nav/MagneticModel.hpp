@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+// World Magnetic Model evaluator (WMM .COF coefficient file).
+// Full spherical harmonic evaluation is done once per grid node; per-frame
+// queries go through a lazily built declination grid and bilinear lookup.
+class MagneticModel {
+public:
+  bool load(const std::string& cof_path);
+  bool isLoaded() const { return max_degree_ > 0; }
+
+  void setDecimalYear(float year);
+  float getDecimalYear() const { return decimal_year_; }
+  float getEpoch() const { return epoch_; }
+
+  //Full harmonic evaluation (slow path)
+  float evaluateDeclination(float lat_deg, float lon_deg, float alt_km) const;
+
+  //Cached grid lookup (per-frame path)
+  float variationDeg(float lat_deg, float lon_deg);
+  float trueToMagnetic(float true_deg, float lat_deg, float lon_deg);
+
+  static float currentDecimalYear();
+
+private:
+  struct GridTile {
+    std::vector<float> nodes;
+  };
+
+  const GridTile& tileFor(int tile_lat, int tile_lon);
+  int index(int n, int m) const { return n * (max_degree_ + 1) + m; }
+
+  int max_degree_ = 0;
+  float epoch_ = 0.0f;
+  float decimal_year_ = 0.0f;
+
+  std::vector<double> g_, h_, g_dot_, h_dot_;
+
+  std::unordered_map<int64_t, GridTile> tiles_;
+  int nodes_per_side_ = 0;
+};
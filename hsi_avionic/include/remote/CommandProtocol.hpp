@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Draw-command stream between an HSI process and its display heads. Every
+// message is a MessageHeader followed by size bytes:
+//   SETUP  once per connection: uniform names of the exported shaders
+//   SYNC   the retained stream contents, for a head that joined or fell behind
+//   FRAME  one frame as encoded by CommandList (streams that changed + body)
+// Payloads are in host byte order; heads run on the sender's architecture.
+namespace CommandProtocol {
+  constexpr uint32_t MAGIC = 0x43495348;   // "HSIC"
+  //Largest payload a head accepts; a header announcing more ends the connection
+  constexpr uint32_t MAX_PAYLOAD = 64u << 20;
+
+  enum MessageType : uint32_t { SETUP = 1, SYNC = 2, FRAME = 3 };
+
+  struct MessageHeader {
+    uint32_t magic;
+    uint32_t type;
+    uint32_t size;
+  };
+
+  //"unix:/path" for a Unix-domain socket, otherwise "[host:]port" over TCP
+  struct Endpoint {
+    bool unix_socket = false;
+    std::string path;
+    std::string host = "127.0.0.1";
+    int port = 0;
+  };
+
+  bool parseEndpoint(const char* text, Endpoint& out);
+  std::string describe(const Endpoint& endpoint);
+
+  //Listening socket (non-blocking), or -1; a stale Unix socket file is replaced
+  int listenOn(const Endpoint& endpoint);
+  //Retries until timeout_s; -1 on failure
+  int connectTo(const Endpoint& endpoint, double timeout_s);
+  void closeSocket(int fd);
+
+  bool readAll(int fd, void* data, size_t bytes);
+}
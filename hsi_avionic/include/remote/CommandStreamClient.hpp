@@ -0,0 +1,40 @@
+#pragma once
+
+#include "gfx/CommandList.hpp"
+#include "remote/CommandProtocol.hpp"
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Display-head side of the draw-command stream. The head initializes the same
+// renderers and fonts as the HSI, so every exported key resolves to one of its
+// own objects; frames then decode straight into its command list. SETUP and
+// SYNC messages are applied on the way to the next frame.
+class CommandStreamClient {
+public:
+  CommandStreamClient() = default;
+  ~CommandStreamClient();
+
+  CommandStreamClient(const CommandStreamClient&) = delete;
+  CommandStreamClient& operator=(const CommandStreamClient&) = delete;
+
+  bool connect(const CommandProtocol::Endpoint& endpoint, double timeout_s);
+
+  //Blocks for the next frame, ready for CommandList::submit(); GL thread.
+  //nullptr once the stream has ended or sent something malformed.
+  CommandList::Frame* next();
+
+  void close();
+
+  //Frames received and bytes per frame
+  void report(std::ostream& out) const;
+
+private:
+  int fd_ = -1;
+  std::vector<unsigned char> payload_;
+
+  int frames_ = 0;
+  int syncs_ = 0;
+  uint64_t bytes_ = 0;
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "gfx/CommandList.hpp"
+#include "remote/CommandProtocol.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Sends every submitted frame as draw commands (see CommandProtocol) to any
+// number of display heads, which replay them with their own renderer and font
+// atlases. The GL thread encodes the frame's command list; the sender thread
+// drops stream payloads identical to the last ones sent, so a static display
+// costs only its command bodies. A head that cannot keep up skips frames and
+// gets a SYNC of the retained stream contents before its next one. When the
+// queue is full the newest frame is merged into the last queued one instead
+// of being dropped, so cumulative streams (glyph uploads) never lose data.
+class CommandStreamServer {
+public:
+  CommandStreamServer() = default;
+  ~CommandStreamServer();
+
+  CommandStreamServer(const CommandStreamServer&) = delete;
+  CommandStreamServer& operator=(const CommandStreamServer&) = delete;
+
+  bool open(const CommandProtocol::Endpoint& endpoint, int max_queued);
+
+  //Encodes and queues a finished frame; GL thread, before CommandList::submit()
+  void publish(const CommandList::Frame* frame);
+
+  //Sends everything queued, then disconnects the heads and stops the thread
+  void close();
+
+  bool isOpen() const { return worker_.joinable(); }
+
+  //Frames, heads, bytes per frame against raw RGB of width x height, encode cost
+  void report(std::ostream& out, int width, int height) const;
+
+private:
+  struct Head {
+    int fd;
+    std::vector<unsigned char> out;   // unsent message bytes
+    size_t sent;
+    bool needs_sync;
+  };
+
+  //Retained contents of one stream key: the last payload, or every payload of a
+  //cumulative stream since its last restart
+  struct StreamState {
+    bool cumulative;
+    std::vector<unsigned char> bytes;
+  };
+
+  void workerLoop();
+  void acceptHeads();
+  void sendFrame(const CommandList::EncodedFrame& frame);
+  void appendMessage(std::vector<unsigned char>& out, uint32_t type, const std::vector<unsigned char>& payload) const;
+  bool flush(Head& head);
+  void disconnectAll();
+
+  std::vector<std::unique_ptr<CommandList::EncodedFrame>> frames_;
+  std::vector<CommandList::EncodedFrame*> free_;
+  std::deque<CommandList::EncodedFrame*> queue_;
+  size_t max_queued_ = 0;
+  std::mutex mutex_;
+  bool stopping_ = false;
+  std::thread worker_;
+  int wake_fds_[2] = { -1, -1 };
+  std::string unix_path_;
+
+  //GL thread only
+  CommandList::EncodedFrame encoded_;
+  int frames_published_ = 0;
+  int merged_ = 0;
+  double encode_ms_ = 0.0;
+
+  //Sender thread only
+  int listen_fd_ = -1;
+  std::vector<Head> heads_;
+  std::map<uint16_t, StreamState> streams_;
+  std::vector<unsigned char> setup_;
+  std::vector<unsigned char> payload_;
+  std::vector<unsigned char> sync_;
+
+  int frames_sent_ = 0;
+  int heads_connected_ = 0;
+  int skipped_ = 0;
+  int syncs_ = 0;
+  uint64_t frame_bytes_ = 0;         // encoded once per frame, before fan-out
+  uint64_t bytes_sent_ = 0;          // to all heads
+};
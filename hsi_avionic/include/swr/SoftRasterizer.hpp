@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "core/ThreadPool.hpp"
+#include "gfx/FontAtlas.hpp"
+
+// CPU rasterizer for the HSI primitives (lines, triangles, glyphs).
+// Draws are recorded in NDC, binned into screen tiles on flush() and the
+// tiles are rasterized in parallel. Coverage is computed analytically from
+// edge distances; spans are blended with SSE2 when available. Output is
+// deterministic and independent of thread count.
+class SoftRasterizer {
+public:
+  SoftRasterizer(int width, int height, unsigned thread_count = 0);
+
+  void clear(float r, float g, float b);
+  void drawLines(const float* xy, int vertex_count, bool strip, bool closed, float width_px,
+                 float r, float g, float b, float alpha);
+  void fillTriangles(const float* xy, int vertex_count, float r, float g, float b, float alpha);
+  void drawGlyphs(const FontAtlas& atlas, const FontAtlas::GlyphQuad* quads, int count,
+                  float r, float g, float b);
+
+  void flush();
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+  const std::vector<uint32_t>& pixels() const { return pixels_; }   // RGBA8, row 0 at top
+
+  bool writePpm(const std::string& path) const;
+
+private:
+  enum class Kind { Clear, Triangles, Segments, Capsules, Glyphs };
+
+  struct Primitive {
+    Kind kind;
+    uint32_t color;
+    float alpha;
+    float half_width;
+    const FontAtlas* atlas;
+    int page;
+    std::vector<float> data;
+    int x0, y0, x1, y1;   // pixel bounds, exclusive max
+  };
+
+  void toPixel(float x_ndc, float y_ndc, float& px, float& py) const;
+  void addSegment(Primitive& prim, float ax, float ay, float bx, float by, float& minx,
+                  float& miny, float& maxx, float& maxy) const;
+  void finishPrimitive(Primitive& prim, float minx, float miny, float maxx, float maxy);
+  void rasterizeTile(int tile_index);
+
+  int width_;
+  int height_;
+  int tiles_x_;
+  int tiles_y_;
+
+  std::vector<uint32_t> pixels_;
+  std::vector<Primitive> prims_;
+  std::vector<std::vector<int>> bins_;
+
+  ThreadPool pool_;
+};
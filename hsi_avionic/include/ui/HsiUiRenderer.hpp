@@ -3,6 +3,7 @@
 
 #include "gfx/TtfTextRenderer.hpp"
 #include "data/HsiData.hpp"
+#include "ui/Readout.hpp"
 
 class HsiUiRenderer {
 public:
@@ -27,6 +28,34 @@ private:
   TtfTextRenderer& waypoint_info_font_;
   TtfTextRenderer& info_side_;
   TtfTextRenderer& info_label_side_;
+
+  //Readouts, reformatted only when the displayed value changes
+  Readout wind_readout_{ "WIND ", { 0, 3, "/" }, { 0, 1, "" } };
+  Readout cog_readout_{ "COG ", { 0, 1, "°" } };
+  Readout gs_readout_{ "GS ", { 0, 1, "" } };
+  Readout ias_readout_{ "", { 0, 1, "" } };
+  Readout alt_readout_{ "", { 0, 1, "" } };
+  Readout bug_readout_{ "", { 0, 1, "°" } };
+
+  Readout wp_left_bearing_{ "", { 0, 1, "°" } };
+  Readout wp_left_distance_{ "", { 1, 1, " km" } };
+  Readout wp_left_app_{ "(APP)", { 3, 1, "" } };
+  Readout wp_left_info_{ "(INF)", { 3, 1, "" } };
+
+  Readout wp_right_bearing_{ "", { 0, 1, "°" } };
+  Readout wp_right_distance_{ ">", { 0, 1, " km" } };
+  Readout wp_right_app_{ "(ACC)", { 3, 1, "" } };
+  Readout wp_right_info_{ "(ACC)", { 3, 1, "" } };
+
+  //Retained label meshes, created on first use
+  TtfTextRenderer::TextHandle gps_text_ = -1;
+  TtfTextRenderer::TextHandle ias_text_ = -1;
+  TtfTextRenderer::TextHandle alt_text_ = -1;
+  TtfTextRenderer::TextHandle bug_text_ = -1;
+  TtfTextRenderer::TextHandle wp_left_name_text_ = -1;
+  TtfTextRenderer::TextHandle wp_left_runway_text_ = -1;
+  TtfTextRenderer::TextHandle wp_right_name_text_ = -1;
+  TtfTextRenderer::TextHandle wp_right_runway_text_ = -1;
 };
 
 #endif
\ No newline at end of file
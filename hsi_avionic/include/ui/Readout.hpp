@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+// Fixed-template numeric readout, e.g. "WIND 053/180" or "861.9 km".
+// Values are quantized to the displayed precision and written with
+// std::to_chars into an internal buffer; the text is only rebuilt when a
+// quantized value changes. Prefix and suffixes must be string literals.
+class Readout {
+public:
+  struct Field {
+    int decimals = 0;          // digits after the point (0-6)
+    int min_digits = 1;        // integer part is zero-padded to this width
+    const char* suffix = "";
+  };
+
+  Readout(const char* prefix, Field field);
+  Readout(const char* prefix, Field first, Field second);
+
+  const char* format(double value);
+  const char* format(double first, double second);
+
+  const char* text() const { return buf_; }
+
+private:
+  static constexpr int kMaxAffix = 16;
+  static constexpr int64_t kUnset = INT64_MIN;
+
+  int64_t quantize(double value, const Field& field) const;
+  char* writeField(char* out, int64_t q, const Field& field) const;
+  void rebuild();
+
+  const char* prefix_;
+  Field fields_[2];
+  int field_count_;
+  int64_t last_[2] = { kUnset, kUnset };
+  char buf_[128] = {};
+};
@@ -0,0 +1,401 @@
+#include "capture/DeltaStreamer.hpp"
+#include "capture/TileDeltaProtocol.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+using namespace TileDeltaProtocol;
+
+namespace {
+  constexpr int MAX_TILE_SIZE = 64;
+  constexpr int MAX_BLOCKS = MAX_TILE_SIZE * 4 / 16;   // 16-byte blocks per tile row
+  constexpr uint64_t PRIME32 = 0x9E3779B1u;
+
+  //Per-block lane keys; distinct keys keep the sum of a row's blocks order-sensitive
+  struct HashKeys {
+    uint64_t block[MAX_BLOCKS][2];
+    uint64_t scramble[2];
+  };
+
+  uint64_t splitmix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+  }
+
+  const HashKeys& hashKeys() {
+    static const HashKeys keys = [] {
+      HashKeys k;
+      uint64_t state = 0x48534954u;
+      for (auto& b : k.block) {
+        b[0] = splitmix64(state);
+        b[1] = splitmix64(state);
+      }
+      k.scramble[0] = splitmix64(state);
+      k.scramble[1] = splitmix64(state);
+      return k;
+    }();
+    return keys;
+  }
+
+  uint64_t avalanche(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xC2B2AE3D27D4EB4Full;
+    h ^= h >> 29;
+    h *= 0x165667B19E3779F9ull;
+    return h ^ (h >> 32);
+  }
+
+  //Two 64-bit lanes, XXH3-style: each 16-byte block adds lo32 * hi32 of
+  //(data ^ key) plus the swapped data; lanes are scrambled after every row.
+  //The SSE2 and scalar paths give the same hash.
+  uint64_t hashTile(const unsigned char* row, std::ptrdiff_t stride, int width, int height) {
+    const HashKeys& keys = hashKeys();
+    const size_t row_bytes = (size_t)width * 4;
+    const size_t full_blocks = row_bytes / 16;
+    const size_t tail = row_bytes % 16;
+    uint64_t lanes[2] = { 0x27D4EB2F165667C5ull, 0x85EBCA77C2B2AE63ull };
+
+#if defined(__SSE2__)
+    __m128i acc = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lanes));
+    const __m128i prime = _mm_set1_epi32((int)PRIME32);
+    const __m128i scramble = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys.scramble));
+
+    auto accumulate = [&](__m128i d, size_t b) {
+      const __m128i dk = _mm_xor_si128(d, _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys.block[b])));
+      const __m128i product = _mm_mul_epu32(dk, _mm_shuffle_epi32(dk, _MM_SHUFFLE(3, 3, 1, 1)));
+      acc = _mm_add_epi64(acc, _mm_add_epi64(product, _mm_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2))));
+    };
+
+    for (int y = 0; y < height; ++y, row += stride) {
+      size_t b = 0;
+      for (; b < full_blocks; ++b) accumulate(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + b * 16)), b);
+      if (tail) {
+        unsigned char last[16] = {};
+        std::memcpy(last, row + b * 16, tail);
+        accumulate(_mm_loadu_si128(reinterpret_cast<const __m128i*>(last)), b);
+      }
+
+      const __m128i k = _mm_xor_si128(_mm_xor_si128(acc, _mm_srli_epi64(acc, 47)), scramble);
+      acc = _mm_add_epi64(_mm_mul_epu32(k, prime), _mm_slli_epi64(_mm_mul_epu32(_mm_srli_epi64(k, 32), prime), 32));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+#else
+    auto accumulate = [&](const unsigned char* p, size_t b) {
+      uint64_t d[2];
+      std::memcpy(d, p, 16);
+      for (int i = 0; i < 2; ++i) {
+        const uint64_t dk = d[i] ^ keys.block[b][i];
+        lanes[i] += (dk & 0xFFFFFFFFu) * (dk >> 32) + d[i ^ 1];
+      }
+    };
+
+    for (int y = 0; y < height; ++y, row += stride) {
+      size_t b = 0;
+      for (; b < full_blocks; ++b) accumulate(row + b * 16, b);
+      if (tail) {
+        unsigned char last[16] = {};
+        std::memcpy(last, row + b * 16, tail);
+        accumulate(last, b);
+      }
+
+      for (int i = 0; i < 2; ++i) {
+        lanes[i] = ((lanes[i] ^ (lanes[i] >> 47)) ^ keys.scramble[i]) * PRIME32;
+      }
+    }
+#endif
+
+    return avalanche(lanes[0] ^ ((lanes[1] << 29) | (lanes[1] >> 35)) ^
+                     ((uint64_t)width << 32 | (uint64_t)height));
+  }
+
+  //Run-length packets over RGB pixels, see TileDeltaProtocol
+  void encodeTile(const unsigned char* row, std::ptrdiff_t stride, int width, int height,
+                  std::vector<uint32_t>& pixels, std::vector<unsigned char>& out) {
+    pixels.clear();
+    for (int y = 0; y < height; ++y, row += stride) {
+      for (int x = 0; x < width; ++x) {
+        const unsigned char* p = row + x * 4;
+        pixels.push_back((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16));
+      }
+    }
+
+    auto putPixel = [&out](uint32_t c) {
+      out.push_back((unsigned char)c);
+      out.push_back((unsigned char)(c >> 8));
+      out.push_back((unsigned char)(c >> 16));
+    };
+
+    const size_t n = pixels.size();
+    for (size_t i = 0; i < n;) {
+      size_t run = 1;
+      while (i + run < n && run < 128 && pixels[i + run] == pixels[i]) ++run;
+      if (run >= 2) {
+        out.push_back((unsigned char)(0x80 | (run - 1)));
+        putPixel(pixels[i]);
+        i += run;
+        continue;
+      }
+
+      const size_t start = i++;
+      while (i < n && i - start < 128 && !(i + 1 < n && pixels[i + 1] == pixels[i])) ++i;
+      out.push_back((unsigned char)(i - start - 1));
+      for (size_t j = start; j < i; ++j) putPixel(pixels[j]);
+    }
+  }
+}
+
+DeltaStreamer::~DeltaStreamer() {
+  close();
+}
+
+#ifdef _WIN32
+
+bool DeltaStreamer::open(const char* address, int port, int, int, int, int) {
+  std::cerr << "Delta stream: sockets are not supported on this platform (" << address << ":" << port << ")\n";
+  return false;
+}
+
+void DeltaStreamer::close() {}
+void DeltaStreamer::workerLoop() {}
+void DeltaStreamer::acceptViewer() {}
+void DeltaStreamer::sendFrame(const Frame&) {}
+void DeltaStreamer::disconnect() {}
+
+#else
+
+bool DeltaStreamer::open(const char* address, int port, int width, int height, int tile_size, int max_queued) {
+  close();
+
+  if (tile_size < 4 || tile_size > MAX_TILE_SIZE || width <= 0 || height <= 0 || width > 65535 || height > 65535) {
+    std::cerr << "Delta stream: tile size must be 4.." << MAX_TILE_SIZE << "\n";
+    return false;
+  }
+
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons((uint16_t)port);
+  if (inet_pton(AF_INET, address, &addr.sin_addr) != 1) {
+    std::cerr << "Delta stream: bad address " << address << "\n";
+    return false;
+  }
+
+  listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+  const int on = 1;
+  if (listen_fd_ < 0 ||
+      setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) != 0 ||
+      bind(listen_fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      listen(listen_fd_, 1) != 0) {
+    std::cerr << "Delta stream: cannot listen on " << address << ":" << port << ": " << std::strerror(errno) << "\n";
+    if (listen_fd_ >= 0) ::close(listen_fd_);
+    listen_fd_ = -1;
+    return false;
+  }
+  fcntl(listen_fd_, F_SETFL, fcntl(listen_fd_, F_GETFL, 0) | O_NONBLOCK);
+
+  width_ = width;
+  height_ = height;
+  tile_size_ = tile_size;
+  tiles_x_ = (width + tile_size - 1) / tile_size;
+  tiles_y_ = (height + tile_size - 1) / tile_size;
+  sent_hashes_.assign((size_t)tiles_x_ * tiles_y_, 0);
+
+  frames_.clear();
+  free_.clear();
+  for (int i = 0; i < max_queued; ++i) {
+    frames_.push_back(std::make_unique<Frame>());
+    free_.push_back(frames_.back().get());
+  }
+
+  stopping_ = false;
+  worker_ = std::thread(&DeltaStreamer::workerLoop, this);
+  return true;
+}
+
+void DeltaStreamer::close() {
+  if (worker_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    cv_.notify_one();
+    worker_.join();
+  }
+  disconnect();
+  if (listen_fd_ >= 0) ::close(listen_fd_);
+  listen_fd_ = -1;
+}
+
+void DeltaStreamer::workerLoop() {
+  for (;;) {
+    Frame* frame = nullptr;
+    {
+      //Wakes up periodically to accept a viewer while no frames arrive
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait_for(lock, std::chrono::milliseconds(50), [this] { return stopping_ || !queue_.empty(); });
+      if (!queue_.empty()) {
+        frame = queue_.front();
+        queue_.pop_front();
+      } else if (stopping_) {
+        return;
+      }
+    }
+
+    acceptViewer();
+    if (!frame) continue;
+
+    if (client_fd_ >= 0) sendFrame(*frame);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.push_back(frame);
+  }
+}
+
+void DeltaStreamer::acceptViewer() {
+  const int fd = accept(listen_fd_, nullptr, nullptr);
+  if (fd < 0) return;
+
+  disconnect();
+  const int on = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  client_fd_ = fd;
+  keyframe_ = true;
+  ++viewers_;
+}
+
+void DeltaStreamer::disconnect() {
+  if (client_fd_ >= 0) ::close(client_fd_);
+  client_fd_ = -1;
+}
+
+void DeltaStreamer::sendFrame(const Frame& frame) {
+  using Clock = std::chrono::steady_clock;
+  const Clock::time_point start = Clock::now();
+
+  //Tiles are taken top-down straight from the bottom-up readback
+  const std::ptrdiff_t stride = -(std::ptrdiff_t)width_ * 4;
+  const unsigned char* top = frame.rgba.data() + (size_t)(height_ - 1) * width_ * 4;
+
+  std::vector<uint64_t> hashes(sent_hashes_.size());
+  for (int ty = 0; ty < tiles_y_; ++ty) {
+    for (int tx = 0; tx < tiles_x_; ++tx) {
+      const int tw = std::min(tile_size_, width_ - tx * tile_size_);
+      const int th = std::min(tile_size_, height_ - ty * tile_size_);
+      hashes[(size_t)ty * tiles_x_ + tx] =
+          hashTile(top + ty * tile_size_ * stride + tx * tile_size_ * 4, stride, tw, th);
+    }
+  }
+  const Clock::time_point hashed = Clock::now();
+
+  message_.assign(FRAME_HEADER_BYTES, 0);
+  std::vector<uint32_t> pixels;
+  uint32_t tile_count = 0;
+  for (int ty = 0; ty < tiles_y_; ++ty) {
+    for (int tx = 0; tx < tiles_x_; ++tx) {
+      const size_t index = (size_t)ty * tiles_x_ + tx;
+      if (!keyframe_ && hashes[index] == sent_hashes_[index]) continue;
+
+      const int tw = std::min(tile_size_, width_ - tx * tile_size_);
+      const int th = std::min(tile_size_, height_ - ty * tile_size_);
+      const size_t tile_start = message_.size();
+      message_.resize(tile_start + TILE_HEADER_BYTES);
+      encodeTile(top + ty * tile_size_ * stride + tx * tile_size_ * 4, stride, tw, th, pixels, message_);
+
+      putLe16(&message_[tile_start], (uint16_t)tx);
+      putLe16(&message_[tile_start + 2], (uint16_t)ty);
+      putLe32(&message_[tile_start + 4], (uint32_t)(message_.size() - tile_start - TILE_HEADER_BYTES));
+      ++tile_count;
+    }
+  }
+
+  unsigned char* header = message_.data();
+  putLe32(header, MAGIC);
+  putLe32(header + 4, ++frame_number_);
+  putLe16(header + 8, (uint16_t)width_);
+  putLe16(header + 10, (uint16_t)height_);
+  putLe16(header + 12, (uint16_t)tile_size_);
+  putLe16(header + 14, keyframe_ ? FLAG_KEYFRAME : 0);
+  putLe32(header + 16, tile_count);
+  putLe32(header + 20, (uint32_t)(message_.size() - FRAME_HEADER_BYTES));
+  const Clock::time_point encoded = Clock::now();
+
+  for (size_t sent = 0; sent < message_.size();) {
+    const ssize_t n = send(client_fd_, message_.data() + sent, message_.size() - sent, MSG_NOSIGNAL);
+    if (n <= 0) {
+      //Viewer went away; the next one starts with a keyframe
+      disconnect();
+      return;
+    }
+    sent += (size_t)n;
+  }
+
+  if (keyframe_) ++keyframes_;
+  keyframe_ = false;
+  sent_hashes_.swap(hashes);
+  ++frames_sent_;
+  tiles_sent_ += tile_count;
+  tiles_total_ += sent_hashes_.size();
+  bytes_sent_ += message_.size();
+  hash_ms_ += std::chrono::duration<double, std::milli>(hashed - start).count();
+  encode_ms_ += std::chrono::duration<double, std::milli>(encoded - hashed).count();
+}
+
+#endif
+
+void DeltaStreamer::submit(const unsigned char* rgba, int width, int height) {
+  if (width != width_ || height != height_) return;
+
+  Frame* frame = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_.empty()) {
+      ++dropped_;
+      return;
+    }
+    frame = free_.back();
+    free_.pop_back();
+  }
+
+  frame->rgba.assign(rgba, rgba + (size_t)width * height * 4);
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back(frame);
+  }
+  cv_.notify_one();
+}
+
+void DeltaStreamer::report(std::ostream& out) const {
+  const double raw = (double)frames_sent_ * width_ * height_ * 3;
+  char line[320];
+  std::snprintf(line, sizeof(line),
+                "Delta stream: %d frames sent to %d viewer(s) (%d keyframes), %d dropped; %.1f%% of tiles changed; "
+                "%llu bytes (%.1f:1 against raw RGB); hash %.3f ms, encode %.3f ms per frame\n",
+                frames_sent_, viewers_, keyframes_, dropped_,
+                tiles_total_ ? 100.0 * (double)tiles_sent_ / (double)tiles_total_ : 0.0,
+                (unsigned long long)bytes_sent_, bytes_sent_ ? raw / (double)bytes_sent_ : 0.0,
+                frames_sent_ ? hash_ms_ / frames_sent_ : 0.0, frames_sent_ ? encode_ms_ / frames_sent_ : 0.0);
+  out << line;
+}
@@ -0,0 +1,275 @@
+#include "capture/FrameEncoder.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+namespace {
+  bool endsWith(const std::string& s, const char* suffix) {
+    const size_t n = std::strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+  }
+
+  //Splits a pattern with exactly one %d or %0Nd into the text around it and
+  //the zero-padded width; any other % is rejected
+  bool splitPattern(const std::string& path, std::string& prefix, std::string& suffix, int& width) {
+    const size_t at = path.find('%');
+    if (at == std::string::npos) return false;
+
+    size_t i = at + 1;
+    width = 0;
+    if (i < path.size() && path[i] == '0') {
+      ++i;
+      while (i < path.size() && path[i] >= '0' && path[i] <= '9' && width < 100) width = width * 10 + (path[i++] - '0');
+      if (width == 0 || width >= 100) return false;
+    }
+    if (i >= path.size() || path[i] != 'd') return false;
+    if (path.find('%', i + 1) != std::string::npos) return false;
+
+    prefix = path.substr(0, at);
+    suffix = path.substr(i + 1);
+    return true;
+  }
+
+  //PNG without a compression library: zlib stream of stored deflate blocks
+  uint32_t crc32(uint32_t crc, const unsigned char* data, size_t size) {
+    static uint32_t table[256];
+    static bool built = false;
+    if (!built) {
+      for (uint32_t n = 0; n < 256; ++n) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        table[n] = c;
+      }
+      built = true;
+    }
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+  }
+
+  void putBe32(std::vector<unsigned char>& out, uint32_t v) {
+    out.push_back((unsigned char)(v >> 24));
+    out.push_back((unsigned char)(v >> 16));
+    out.push_back((unsigned char)(v >> 8));
+    out.push_back((unsigned char)v);
+  }
+
+  void putChunk(std::vector<unsigned char>& out, const char* type, const unsigned char* data, size_t size) {
+    putBe32(out, (uint32_t)size);
+    const size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data, data + size);
+    putBe32(out, crc32(0, &out[start], size + 4));
+  }
+
+  //rows: filter byte + RGB per row, top-down
+  void encodePng(const std::vector<unsigned char>& rows, int width, int height, std::vector<unsigned char>& out) {
+    static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    out.assign(signature, signature + 8);
+
+    std::vector<unsigned char> ihdr;
+    putBe32(ihdr, (uint32_t)width);
+    putBe32(ihdr, (uint32_t)height);
+    ihdr.insert(ihdr.end(), { 8, 2, 0, 0, 0 });   // 8-bit RGB, no interlace
+    putChunk(out, "IHDR", ihdr.data(), ihdr.size());
+
+    std::vector<unsigned char> z = { 0x78, 0x01 };
+    uint32_t a = 1, b = 0;
+    for (size_t pos = 0; pos < rows.size();) {
+      const size_t n = std::min<size_t>(65535, rows.size() - pos);
+      z.push_back(pos + n == rows.size() ? 1 : 0);
+      z.push_back((unsigned char)n);
+      z.push_back((unsigned char)(n >> 8));
+      z.push_back((unsigned char)~n);
+      z.push_back((unsigned char)(~n >> 8));
+      z.insert(z.end(), rows.begin() + (std::ptrdiff_t)pos, rows.begin() + (std::ptrdiff_t)(pos + n));
+      for (size_t i = pos; i < pos + n; ++i) {
+        a = (a + rows[i]) % 65521;
+        b = (b + a) % 65521;
+      }
+      pos += n;
+    }
+    putBe32(z, (b << 16) | a);
+    putChunk(out, "IDAT", z.data(), z.size());
+    putChunk(out, "IEND", nullptr, 0);
+  }
+}
+
+FrameEncoder::~FrameEncoder() {
+  close();
+}
+
+bool FrameEncoder::open(const std::string& path, int width, int height, double fps, int max_queued) {
+  close();
+
+  path_ = path;
+  width_ = width;
+  height_ = height;
+  fps_ = fps > 0.0 ? fps : 60.0;
+
+  if (endsWith(path, ".y4m")) format_ = Format::Y4M;
+  else if (endsWith(path, ".rgb")) format_ = Format::RawRgb;
+  else if (endsWith(path, ".png") && splitPattern(path, name_prefix_, name_suffix_, name_digits_)) {
+    format_ = Format::PngSequence;
+  } else {
+    std::cerr << "Recording: unknown format for " << path << " (use .y4m, .rgb or a .png pattern with one %d or %0Nd)\n";
+    return false;
+  }
+
+  if (format_ != Format::PngSequence) {
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+      std::cerr << "Recording: cannot open " << path << "\n";
+      return false;
+    }
+  }
+  if (format_ == Format::Y4M) {
+    std::fprintf(file_, "YUV4MPEG2 W%d H%d F%d:1000 Ip A1:1 C444\n", width_, height_, (int)(fps_ * 1000.0 + 0.5));
+  }
+
+  frames_.clear();
+  free_.clear();
+  for (int i = 0; i < max_queued; ++i) {
+    frames_.push_back(std::make_unique<Frame>());
+    free_.push_back(frames_.back().get());
+  }
+
+  stopping_ = false;
+  written_ = 0;
+  dropped_ = 0;
+  worker_ = std::thread(&FrameEncoder::workerLoop, this);
+  return true;
+}
+
+void FrameEncoder::submit(const unsigned char* rgba, int width, int height) {
+  Frame* frame = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_.empty()) {
+      ++dropped_;
+      return;
+    }
+    frame = free_.back();
+    free_.pop_back();
+  }
+
+  frame->width = width;
+  frame->height = height;
+  frame->rgba.assign(rgba, rgba + (size_t)width * height * 4);
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back(frame);
+  }
+  cv_.notify_one();
+}
+
+void FrameEncoder::close() {
+  if (worker_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    cv_.notify_one();
+    worker_.join();
+  }
+  if (file_) std::fclose(file_);
+  file_ = nullptr;
+}
+
+void FrameEncoder::workerLoop() {
+  for (;;) {
+    Frame* frame = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+      if (queue_.empty()) return;   // stopping and drained
+      frame = queue_.front();
+      queue_.pop_front();
+    }
+
+    if (write(*frame)) ++written_;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.push_back(frame);
+  }
+}
+
+bool FrameEncoder::write(const Frame& frame) {
+  if (frame.width != width_ || frame.height != height_) return false;
+
+  switch (format_) {
+    case Format::Y4M: return writeY4m(frame);
+    case Format::RawRgb: return writeRgb(frame);
+    case Format::PngSequence: return writePng(frame);
+  }
+  return false;
+}
+
+//BT.601 studio range, full-resolution chroma
+bool FrameEncoder::writeY4m(const Frame& frame) {
+  const size_t plane = (size_t)width_ * height_;
+  scratch_.resize(plane * 3);
+  unsigned char* y_plane = scratch_.data();
+  unsigned char* u_plane = y_plane + plane;
+  unsigned char* v_plane = u_plane + plane;
+
+  for (int y = 0; y < height_; ++y) {
+    const unsigned char* src = &frame.rgba[(size_t)(height_ - 1 - y) * width_ * 4];
+    const size_t row = (size_t)y * width_;
+    for (int x = 0; x < width_; ++x, src += 4) {
+      const int r = src[0], g = src[1], b = src[2];
+      y_plane[row + x] = (unsigned char)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+      u_plane[row + x] = (unsigned char)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+      v_plane[row + x] = (unsigned char)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+    }
+  }
+
+  std::fputs("FRAME\n", file_);
+  return std::fwrite(scratch_.data(), 1, scratch_.size(), file_) == scratch_.size();
+}
+
+bool FrameEncoder::writeRgb(const Frame& frame) {
+  scratch_.resize((size_t)width_ * height_ * 3);
+  unsigned char* dst = scratch_.data();
+  for (int y = 0; y < height_; ++y) {
+    const unsigned char* src = &frame.rgba[(size_t)(height_ - 1 - y) * width_ * 4];
+    for (int x = 0; x < width_; ++x, src += 4, dst += 3) {
+      dst[0] = src[0];
+      dst[1] = src[1];
+      dst[2] = src[2];
+    }
+  }
+  return std::fwrite(scratch_.data(), 1, scratch_.size(), file_) == scratch_.size();
+}
+
+bool FrameEncoder::writePng(const Frame& frame) {
+  const size_t stride = (size_t)width_ * 3 + 1;
+  std::vector<unsigned char> rows(stride * height_);
+  for (int y = 0; y < height_; ++y) {
+    const unsigned char* src = &frame.rgba[(size_t)(height_ - 1 - y) * width_ * 4];
+    unsigned char* dst = &rows[(size_t)y * stride];
+    *dst++ = 0;   // filter: none
+    for (int x = 0; x < width_; ++x, src += 4, dst += 3) {
+      dst[0] = src[0];
+      dst[1] = src[1];
+      dst[2] = src[2];
+    }
+  }
+  encodePng(rows, width_, height_, scratch_);
+
+  std::string number = std::to_string(written_);
+  if ((int)number.size() < name_digits_) number.insert(0, (size_t)name_digits_ - number.size(), '0');
+  const std::string name = name_prefix_ + number + name_suffix_;
+  std::FILE* f = std::fopen(name.c_str(), "wb");
+  if (!f) {
+    std::cerr << "Recording: cannot write " << name << "\n";
+    return false;
+  }
+  const bool ok = std::fwrite(scratch_.data(), 1, scratch_.size(), f) == scratch_.size();
+  std::fclose(f);
+  return ok;
+}
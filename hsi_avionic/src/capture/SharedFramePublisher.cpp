@@ -0,0 +1,176 @@
+#include "capture/SharedFramePublisher.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace SharedFrameLayout;
+
+namespace {
+  inline uint32_t loadPixel(const unsigned char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+  }
+}
+
+SharedFramePublisher::~SharedFramePublisher() {
+  close();
+}
+
+#ifdef _WIN32
+
+bool SharedFramePublisher::open(const std::string& name, int, int, int) {
+  std::cerr << "Shared frame output: POSIX shared memory is not available on this platform (" << name << ")\n";
+  return false;
+}
+
+void SharedFramePublisher::close() {}
+
+#else
+
+bool SharedFramePublisher::open(const std::string& name, int width, int height, int slot_count) {
+  close();
+
+  if (slot_count < 2 || slot_count > MAX_SLOTS || width <= 0 || height <= 0) {
+    std::cerr << "Shared frame output: need 2.." << MAX_SLOTS << " slots and a non-empty frame\n";
+    return false;
+  }
+
+  //A ring left behind by a crashed run is replaced, not reused
+  shm_unlink(name.c_str());
+  const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd < 0) {
+    std::cerr << "Shared frame output: shm_open(" << name << ") failed: " << std::strerror(errno) << "\n";
+    return false;
+  }
+
+  const size_t bytes = objectBytes((uint32_t)width, (uint32_t)height, (uint32_t)slot_count);
+  if (ftruncate(fd, (off_t)bytes) != 0) {
+    std::cerr << "Shared frame output: cannot size " << name << " to " << bytes << " bytes\n";
+    ::close(fd);
+    shm_unlink(name.c_str());
+    return false;
+  }
+
+  void* view = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (view == MAP_FAILED) {
+    std::cerr << "Shared frame output: mmap of " << name << " failed\n";
+    shm_unlink(name.c_str());
+    return false;
+  }
+
+  //A fresh object is zero-filled: latest = 0, every seq even
+  header_ = static_cast<RingHeader*>(view);
+  header_->version = VERSION;
+  header_->width = (uint32_t)width;
+  header_->height = (uint32_t)height;
+  header_->stride = (uint32_t)width * 4;
+  header_->slot_count = (uint32_t)slot_count;
+  header_->slot_bytes = (uint64_t)header_->stride * height;
+  header_->pixel_offset = pixelOffset();
+  std::atomic_thread_fence(std::memory_order_release);
+  header_->magic.store(MAGIC, std::memory_order_release);
+
+  name_ = name;
+  mapped_bytes_ = bytes;
+  frame_number_ = 0;
+  cost_total_ms_ = 0.0;
+  cost_max_ms_ = 0.0;
+  return true;
+}
+
+void SharedFramePublisher::close() {
+  if (!header_) return;
+  header_->closed.store(1, std::memory_order_release);
+  munmap(header_, mapped_bytes_);
+  shm_unlink(name_.c_str());
+  header_ = nullptr;
+  mapped_bytes_ = 0;
+}
+
+#endif
+
+unsigned char* SharedFramePublisher::slotPixels(uint64_t frame_number) const {
+  const uint64_t slot = (frame_number - 1) % header_->slot_count;
+  return reinterpret_cast<unsigned char*>(header_) + header_->pixel_offset + slot * header_->slot_bytes;
+}
+
+void SharedFramePublisher::publish(const unsigned char* rgba, int width, int height,
+                                   std::chrono::steady_clock::time_point drawn) {
+  if (!header_ || width != (int)header_->width || height != (int)header_->height) return;
+  using Clock = std::chrono::steady_clock;
+  const Clock::time_point start = Clock::now();
+
+  const uint64_t n = frame_number_ + 1;
+  SlotHeader& slot = header_->slots[(n - 1) % header_->slot_count];
+  const size_t stride = header_->stride;
+  unsigned char* dst = slotPixels(n);
+  const unsigned char* prev = n > 1 ? slotPixels(n - 1) : nullptr;
+
+  const uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+  slot.seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  //Flip to top-down while comparing each row against the previous frame
+  int x0 = width, y0 = height, x1 = -1, y1 = -1;
+  for (int y = 0; y < height; ++y) {
+    const unsigned char* src = rgba + (size_t)(height - 1 - y) * stride;
+    const size_t row = (size_t)y * stride;
+
+    if (!prev) {
+      x0 = y0 = 0;
+      x1 = width - 1;
+      y1 = height - 1;
+    } else if (std::memcmp(src, prev + row, stride) != 0) {
+      int first = 0;
+      while (loadPixel(src + first * 4) == loadPixel(prev + row + first * 4)) ++first;
+      int last = width - 1;
+      while (loadPixel(src + last * 4) == loadPixel(prev + row + last * 4)) --last;
+      x0 = std::min(x0, first);
+      x1 = std::max(x1, last);
+      y0 = std::min(y0, y);
+      y1 = y;
+    }
+    std::memcpy(dst + row, src, stride);
+  }
+
+  slot.frame_number = n;
+  slot.timestamp_ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+      drawn.time_since_epoch()).count();
+  if (y1 >= 0) {
+    slot.dirty_x = x0;
+    slot.dirty_y = y0;
+    slot.dirty_w = x1 - x0 + 1;
+    slot.dirty_h = y1 - y0 + 1;
+  } else {
+    slot.dirty_x = slot.dirty_y = slot.dirty_w = slot.dirty_h = 0;
+  }
+
+  slot.seq.store(seq + 2, std::memory_order_release);
+  header_->latest.store(n, std::memory_order_release);
+  frame_number_ = n;
+
+  const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  cost_total_ms_ += ms;
+  cost_max_ms_ = std::max(cost_max_ms_, ms);
+}
+
+void SharedFramePublisher::report(std::ostream& out) const {
+  char line[200];
+  std::snprintf(line, sizeof(line),
+                "Shared frame output: %llu frames published to %s; publish cost mean=%.3f max=%.3f ms/frame\n",
+                (unsigned long long)frame_number_, name_.c_str(),
+                frame_number_ ? cost_total_ms_ / frame_number_ : 0.0, cost_max_ms_);
+  out << line;
+}
@@ -1,4 +1,7 @@
 #include "compas/CompasRenderer.hpp"
+#include "gfx/Primitives.hpp"
+#include "gfx/SdfShapes.hpp"
+#include "core/StartupTrace.hpp"
 #include <vector>
 #include <cmath>
 
@@ -6,140 +9,30 @@ bool CompasRenderer::init(int width, int height) {
   width_ = width;
   height_ = height;
 
-  const char* vs = R"(
-    #version 330 core
-    layout (location = 0) in vec2 aPos;
-    void main() { gl_Position = vec4(aPos, 0.0, 1.0); }
-  )";
-
-  const char* fs = R"(
-    #version 330 core
-    out vec4 FragColor;
-    uniform vec3 uColor;
-    void main() { FragColor = vec4(uColor, 1.0); }
-  )";
-
-  if (!shader_.build(vs, fs)) return false;
-
-  glGenVertexArrays(1, &vao_);
-  glGenBuffers(1, &vbo_);
-
-  buildRingGeometry(0.70f, 200);
+  ring_radius_ = 0.70f;
   tick_outer_r_ = 0.70f;
   tick_inner_r_90_ = 0.10f;
   tick_inner_r_30_ = 0.08f;
   tick_inner_r_10_ = 0.06f;
   tick_inner_r_5_  = 0.04f;
-  
-  buildTicksGeometry(tick_outer_r_, tick_inner_r_90_, tick_inner_r_30_, tick_inner_r_10_, tick_inner_r_5_);
-  buildCardinalMarkersGeometry(0.70f, 0.06f);
-  buildHeadingIndicatorGeometry();
-
-  return true;
-}
-
-void CompasRenderer::buildRingGeometry(float radius_ndc, int segments) {
-  float aspect_fix = (float)height_ / (float)width_;
-
-  std::vector<float> verts;
-  verts.reserve((segments + 1) * 2);
-
-  for (int i = 0; i < segments; i++) {
-    float t = (float)i / (float)segments;
-    float a = t * 2.0f * 3.1415926535f;
-
-    float x = std::cos(a) * radius_ndc * aspect_fix;
-    float y = std::sin(a) * radius_ndc;
 
-    verts.push_back(x);
-    verts.push_back(y);
+  {
+    StartupTrace::Scope scope("compass_markers_geometry");
+    buildCardinalMarkersGeometry(0.70f, 0.06f);
   }
-
-  vertex_count_ = segments;
-
-  glBindVertexArray(vao_);
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-  glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(verts.size() * sizeof(float)), verts.data(), GL_STATIC_DRAW);
-
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-  glEnableVertexAttribArray(0);
-
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindVertexArray(0);
-}
-
-void CompasRenderer::buildTicksGeometry(float radius_ndc,
-                                        float len_cardinal,
-                                        float len_major, 
-                                        float len_medium, 
-                                        float len_minor) {
-  float aspect_fix = (float)height_ / (float)width_;
-
-  std::vector<float> v_cardinal, v_major, v_medium, v_minor;
-  v_cardinal.reserve(240);
-  v_major.reserve(360); 
-  v_medium.reserve(720); 
-  v_minor.reserve(1440);
-
-  auto push_tick = [&](std::vector<float>& v, int deg, float len) {
-    float angle = deg - heading_deg_;
-    float a = angle * 3.1415926535f / 180.0f;
-
-    float x0 = std::cos(a) * radius_ndc * aspect_fix;
-    float y0 = std::sin(a) * radius_ndc;
-
-    float x1 = std::cos(a) * (radius_ndc - len) * aspect_fix;
-    float y1 = std::sin(a) * (radius_ndc - len);
-
-    v.push_back(x0); v.push_back(y0);
-    v.push_back(x1); v.push_back(y1);
-  };
-
-  for (int deg = 0; deg < 360; ++deg) {
-    if (deg % 90 == 0) {
-      push_tick(v_cardinal, deg, len_cardinal);
-    } else if (deg % 30 == 0) {
-      push_tick(v_major, deg, len_major);
-    } else if (deg % 10 == 0) {
-      push_tick(v_medium, deg, len_medium);
-    } else if (deg % 5 == 0) {
-      push_tick(v_minor, deg, len_minor);
-    }
+  {
+    StartupTrace::Scope scope("compass_heading_indicator_geometry");
+    buildHeadingIndicatorGeometry();
   }
 
-  cardinal_count_ = (int)(v_cardinal.size() / 2);
-  major_count_  = (int)(v_major.size() / 2);
-  medium_count_ = (int)(v_medium.size() / 2);
-  minor_count_  = (int)(v_minor.size() / 2);
-
-  auto upload = [](GLuint& vao, GLuint& vbo, const std::vector<float>& v) {
-    if (vao != 0) glDeleteBuffers(1, &vbo);
-    if (vao != 0) glDeleteVertexArrays(1, &vao);
-    
-    glGenVertexArrays(1, &vao);
-    glGenBuffers(1, &vbo);
-
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(v.size() * sizeof(float)), v.data(), GL_DYNAMIC_DRAW);
-
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-  };
-
-  upload(cardinal_vao_, cardinal_vbo_, v_cardinal);
-  upload(major_vao_, major_vbo_, v_major);
-  upload(medium_vao_, medium_vbo_, v_medium);
-  upload(minor_vao_, minor_vbo_, v_minor);
+  return true;
 }
 
 void CompasRenderer::buildCardinalMarkersGeometry(float radius_ndc, float size_ndc) {
   float aspect_fix = (float)height_ / (float)width_;
 
-  std::vector<float> verts;
+  std::vector<float>& verts = markers_verts_;
+  verts.clear();
   verts.reserve(4 * 3 * 2);
 
   auto add_triangle_inward = [&](float bearing_deg) {
@@ -176,30 +69,13 @@ void CompasRenderer::buildCardinalMarkersGeometry(float radius_ndc, float size_n
   add_triangle_inward(90.0f);
   add_triangle_inward(180.0f);
   add_triangle_inward(270.0f);
-
-  markers_vertex_count_ = (int)(verts.size() / 2);
-
-  if (markers_vao_ != 0) glDeleteBuffers(1, &markers_vbo_);
-  if (markers_vao_ != 0) glDeleteVertexArrays(1, &markers_vao_);
-
-  glGenVertexArrays(1, &markers_vao_);
-  glGenBuffers(1, &markers_vbo_);
-
-  glBindVertexArray(markers_vao_);
-  glBindBuffer(GL_ARRAY_BUFFER, markers_vbo_);
-  glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(verts.size() * sizeof(float)), verts.data(), GL_DYNAMIC_DRAW);
-
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-  glEnableVertexAttribArray(0);
-
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindVertexArray(0);
 }
 
 void CompasRenderer::buildHeadingIndicatorGeometry() {
   float aspect_fix = (float)height_ / (float)width_;
   
-  std::vector<float> verts;
+  std::vector<float>& verts = heading_indicator_verts_;
+  verts.clear();
   
   float indicator_y = 0.77f;
   float arrow_height = 0.12f;
@@ -218,89 +94,31 @@ void CompasRenderer::buildHeadingIndicatorGeometry() {
   verts.push_back(y_top);
   verts.push_back(x_right);
   verts.push_back(y_top);
-  
-  heading_indicator_vertex_count_ = 3;
-  
-  if (heading_indicator_vao_ != 0) glDeleteBuffers(1, &heading_indicator_vbo_);
-  if (heading_indicator_vao_ != 0) glDeleteVertexArrays(1, &heading_indicator_vao_);
-  
-  glGenVertexArrays(1, &heading_indicator_vao_);
-  glGenBuffers(1, &heading_indicator_vbo_);
-  
-  glBindVertexArray(heading_indicator_vao_);
-  glBindBuffer(GL_ARRAY_BUFFER, heading_indicator_vbo_);
-  glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(verts.size() * sizeof(float)), verts.data(), GL_STATIC_DRAW);
-  
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-  glEnableVertexAttribArray(0);
-  
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindVertexArray(0);
 }
 
 void CompasRenderer::drawRing() {
-  shader_.use();
-  glBindVertexArray(vao_);
-
-  GLint loc = glGetUniformLocation(shader_.id(), "uColor");
-  glUniform3f(loc, 1.0f, 1.0f, 1.0f);
-
-  glLineWidth(10.0f);
-  glDrawArrays(GL_LINE_LOOP, 0, vertex_count_);
-
-  glBindVertexArray(0);
+  SdfShapes::ring(0.0f, 0.0f, ring_radius_, 10.0f, 1.0f, 1.0f, 1.0f);
 }
 
 void CompasRenderer::drawTicks() {
-  buildTicksGeometry(tick_outer_r_, tick_inner_r_90_, tick_inner_r_30_, tick_inner_r_10_, tick_inner_r_5_);
-
-  shader_.use();
-  GLint loc = glGetUniformLocation(shader_.id(), "uColor");
-  glUniform3f(loc, 1.0f, 1.0f, 1.0f);
-
-  glBindVertexArray(cardinal_vao_);
-  glLineWidth(5.0f);
-  glDrawArrays(GL_LINES, 0, cardinal_count_);
-
-  glBindVertexArray(major_vao_);
-  glLineWidth(3.5f);
-  glDrawArrays(GL_LINES, 0, major_count_);
-
-  glBindVertexArray(medium_vao_);
-  glLineWidth(2.0f);
-  glDrawArrays(GL_LINES, 0, medium_count_);
-
-  glBindVertexArray(minor_vao_);
-  glLineWidth(1.0f);
-  glDrawArrays(GL_LINES, 0, minor_count_);
+  const float lengths[SdfShapes::TICK_CLASS_COUNT] = {
+    tick_inner_r_90_, tick_inner_r_30_, tick_inner_r_10_, tick_inner_r_5_
+  };
+  const float widths[SdfShapes::TICK_CLASS_COUNT] = { 5.0f, 3.5f, 2.0f, 1.0f };
 
-  glBindVertexArray(0);
+  SdfShapes::ticks(0.0f, 0.0f, tick_outer_r_, lengths, widths, heading_deg_, 1.0f, 1.0f, 1.0f);
 }
 
 void CompasRenderer::drawCardinalMarkers() {
   buildCardinalMarkersGeometry(0.70f, 0.06f);
 
-  shader_.use();
-  glBindVertexArray(markers_vao_);
-
-  GLint loc = glGetUniformLocation(shader_.id(), "uColor");
-  glUniform3f(loc, 1.0f, 1.0f, 1.0f);
-
-  glDrawArrays(GL_TRIANGLES, 0, markers_vertex_count_);
-
-  glBindVertexArray(0);
+  Primitives::draw(markers_verts_.data(), (int)(markers_verts_.size() / 2),
+                   Primitives::Mode::Triangles, 1.0f, 1.0f, 1.0f);
 }
 
 void CompasRenderer::drawHeadingIndicator() {
-  shader_.use();
-  glBindVertexArray(heading_indicator_vao_);
-
-  GLint loc = glGetUniformLocation(shader_.id(), "uColor");
-  glUniform3f(loc, 1.0f, 1.0f, 0.0f);
-
-  glDrawArrays(GL_TRIANGLES, 0, heading_indicator_vertex_count_);
-
-  glBindVertexArray(0);
+  Primitives::draw(heading_indicator_verts_.data(), (int)(heading_indicator_verts_.size() / 2),
+                   Primitives::Mode::Triangles, 1.0f, 1.0f, 0.0f);
 }
 
 void CompasRenderer::drawBugTriangle(float bearing_deg, float heading_deg, float aspect_fix, float radius) {
@@ -331,26 +149,8 @@ void CompasRenderer::drawBugTriangle(float bearing_deg, float heading_deg, float
 
   float vertices[] = {x0, y0, x1, y1, x2, y2};
 
-  GLuint VAO, VBO;
-  glGenVertexArrays(1, &VAO);
-  glGenBuffers(1, &VBO);
-  
-  glBindVertexArray(VAO);
-  glBindBuffer(GL_ARRAY_BUFFER, VBO);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-  
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-  glEnableVertexAttribArray(0);
-
-  shader_.use();
-  GLint loc = glGetUniformLocation(shader_.id(), "uColor");
-  glUniform3f(loc, 1.0f, 0.0f, 1.0f);
-
-  glLineWidth(5.0f);
-  glDrawArrays(GL_LINE_LOOP, 0, 3);
-  
-  glDeleteBuffers(1, &VBO);
-  glDeleteVertexArrays(1, &VAO);
+  Primitives::draw(vertices, 3,
+                   Primitives::Mode::LineLoop, 1.0f, 0.0f, 1.0f, 1.0f, 5.0f);
 }
 
 void CompasRenderer::drawWaypointArrowDouble(float bearing_deg, float heading_deg, float aspect_fix, float radius) {
@@ -405,27 +205,8 @@ void CompasRenderer::drawWaypointArrowDouble(float bearing_deg, float heading_de
     sx2, sy2, ex2, ey2
   };
 
-  GLuint line_VAO, line_VBO;
-  glGenVertexArrays(1, &line_VAO);
-  glGenBuffers(1, &line_VBO);
-  
-  glBindVertexArray(line_VAO);
-  glBindBuffer(GL_ARRAY_BUFFER, line_VBO);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(line_vertices), line_vertices, GL_STATIC_DRAW);
-  
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-  glEnableVertexAttribArray(0);
-
-  shader_.use();
-  GLint loc = glGetUniformLocation(shader_.id(), "uColor");
-  glUniform3f(loc, 0.0f, 1.0f, 0.0f);
-
-  glLineWidth(3.5f);
-  glDrawArrays(GL_LINES, 0, 4);
-  
-  glBindVertexArray(0);
-  glDeleteBuffers(1, &line_VBO);
-  glDeleteVertexArrays(1, &line_VAO);
+  Primitives::draw(line_vertices, 4,
+                   Primitives::Mode::Lines, 0.0f, 1.0f, 0.0f, 1.0f, 3.5f);
 
   float arrow_vertices[] = {
     base_x, base_y,
@@ -437,25 +218,8 @@ void CompasRenderer::drawWaypointArrowDouble(float bearing_deg, float heading_de
     right_x, right_y
   };
 
-  GLuint arrow_VAO, arrow_VBO;
-  glGenVertexArrays(1, &arrow_VAO);
-  glGenBuffers(1, &arrow_VBO);
-  
-  glBindVertexArray(arrow_VAO);
-  glBindBuffer(GL_ARRAY_BUFFER, arrow_VBO);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(arrow_vertices), arrow_vertices, GL_STATIC_DRAW);
-  
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-  glEnableVertexAttribArray(0);
-
-  shader_.use();
-  loc = glGetUniformLocation(shader_.id(), "uColor");
-  glUniform3f(loc, 0.0f, 1.0f, 0.0f);
-
-  glDrawArrays(GL_TRIANGLES, 0, 6);
-  glBindVertexArray(0);
-  glDeleteBuffers(1, &arrow_VBO);
-  glDeleteVertexArrays(1, &arrow_VAO);
+  Primitives::draw(arrow_vertices, 6,
+                   Primitives::Mode::Triangles, 0.0f, 1.0f, 0.0f);
 }
 
 void CompasRenderer::drawWaypointArrowSingle(float bearing_deg, float heading_deg, float aspect_fix, float radius) {
@@ -497,27 +261,8 @@ void CompasRenderer::drawWaypointArrowSingle(float bearing_deg, float heading_de
     sx, sy, base_x, base_y
   };
 
-  GLuint line_VAO, line_VBO;
-  glGenVertexArrays(1, &line_VAO);
-  glGenBuffers(1, &line_VBO);
-  
-  glBindVertexArray(line_VAO);
-  glBindBuffer(GL_ARRAY_BUFFER, line_VBO);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(line_vertices), line_vertices, GL_STATIC_DRAW);
-  
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-  glEnableVertexAttribArray(0);
-
-  shader_.use();
-  GLint loc = glGetUniformLocation(shader_.id(), "uColor");
-  glUniform3f(loc, 1.0f, 1.0f, 0.0f);
-
-  glLineWidth(8.0f);
-  glDrawArrays(GL_LINES, 0, 2);
-  
-  glBindVertexArray(0);
-  glDeleteBuffers(1, &line_VBO);
-  glDeleteVertexArrays(1, &line_VAO);
+  Primitives::draw(line_vertices, 2,
+                   Primitives::Mode::Lines, 1.0f, 1.0f, 0.0f, 1.0f, 8.0f);
 
   float arrow_vertices[] = {
     base_x, base_y,
@@ -529,26 +274,8 @@ void CompasRenderer::drawWaypointArrowSingle(float bearing_deg, float heading_de
     right_x, right_y
   };
 
-  GLuint arrow_VAO, arrow_VBO;
-  glGenVertexArrays(1, &arrow_VAO);
-  glGenBuffers(1, &arrow_VBO);
-  
-  glBindVertexArray(arrow_VAO);
-  glBindBuffer(GL_ARRAY_BUFFER, arrow_VBO);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(arrow_vertices), arrow_vertices, GL_STATIC_DRAW);
-  
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-  glEnableVertexAttribArray(0);
-
-  shader_.use();
-  loc = glGetUniformLocation(shader_.id(), "uColor");
-  glUniform3f(loc, 1.0f, 1.0f, 0.0f);
-
-  glDrawArrays(GL_TRIANGLES, 0, 6);
-  
-  glBindVertexArray(0);
-  glDeleteBuffers(1, &arrow_VBO);
-  glDeleteVertexArrays(1, &arrow_VAO);
+  Primitives::draw(arrow_vertices, 6,
+                   Primitives::Mode::Triangles, 1.0f, 1.0f, 0.0f);
 }
 
 void CompasRenderer::drawWaypointCircles(float bearing_deg, float heading_deg, float aspect_fix, 
@@ -569,7 +296,6 @@ void CompasRenderer::drawWaypointCircles(float bearing_deg, float heading_deg, f
   cx *= aspect_fix;
 
   const int NUM_CIRCLES = 7;
-  const int CIRCLE_SEGMENTS = 12;
 
   for (int i = -(NUM_CIRCLES / 2); i <= (NUM_CIRCLES / 2); ++i) {
     float offset = (float)i * circle_spacing;
@@ -577,41 +303,7 @@ void CompasRenderer::drawWaypointCircles(float bearing_deg, float heading_deg, f
     float circle_x = cx + perpx * offset * aspect_fix;
     float circle_y = cy + perpy * offset;
 
-    std::vector<float> circle_verts;
-    circle_verts.reserve((CIRCLE_SEGMENTS + 1) * 2);
-
-    for (int j = 0; j < CIRCLE_SEGMENTS; ++j) {
-      float angle = (float)j / (float)CIRCLE_SEGMENTS * 2.0f * 3.1415926535f;
-      float x = circle_x + std::cos(angle) * circle_radius * aspect_fix;
-      float y = circle_y + std::sin(angle) * circle_radius;
-      circle_verts.push_back(x);
-      circle_verts.push_back(y);
-    }
-
-    GLuint VAO, VBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(circle_verts.size() * sizeof(float)), 
-                 circle_verts.data(), GL_STATIC_DRAW);
-    
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    shader_.use();
-    GLint loc = glGetUniformLocation(shader_.id(), "uColor");
-    glUniform3f(loc, 1.0f, 1.0f, 0.0f);
-    
-    GLint loc_alpha = glGetUniformLocation(shader_.id(), "uAlpha");
-    glUniform1f(loc_alpha, circle_opacity);
-
-    glLineWidth(line_width);
-    glDrawArrays(GL_LINE_LOOP, 0, CIRCLE_SEGMENTS);
-    
-    glDeleteBuffers(1, &VBO);
-    glDeleteVertexArrays(1, &VAO);
+    SdfShapes::ring(circle_x, circle_y, circle_radius, line_width, 1.0f, 1.0f, 0.0f, circle_opacity);
   }
 }
 
@@ -656,26 +348,8 @@ void CompasRenderer::drawPerpendicularLine(float bearing_deg, float heading_deg,
     end_x, end_y
   };
 
-  GLuint VAO, VBO;
-  glGenVertexArrays(1, &VAO);
-  glGenBuffers(1, &VBO);
-  
-  glBindVertexArray(VAO);
-  glBindBuffer(GL_ARRAY_BUFFER, VBO);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-  
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-  glEnableVertexAttribArray(0);
-
-  shader_.use();
-  GLint loc = glGetUniformLocation(shader_.id(), "uColor");
-  glUniform3f(loc, 1.0f, 1.0f, 0.0f);
-
-  glLineWidth(line_width);
-  glDrawArrays(GL_LINES, 0, 2);
-  
-  glDeleteBuffers(1, &VBO);
-  glDeleteVertexArrays(1, &VAO);
+  Primitives::draw(vertices, 2,
+                   Primitives::Mode::Lines, 1.0f, 1.0f, 0.0f, 1.0f, line_width);
 }
 
 void CompasRenderer::updatePerpLineOffset(float delta) {
@@ -760,26 +434,8 @@ void CompasRenderer::drawAircraftSymbol(float aspect_fix) {
     0.0f, nose_y
   };
 
-  GLuint VAO, VBO;
-  glGenVertexArrays(1, &VAO);
-  glGenBuffers(1, &VBO);
-  
-  glBindVertexArray(VAO);
-  glBindBuffer(GL_ARRAY_BUFFER, VBO);
-  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-  
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-  glEnableVertexAttribArray(0);
-
-  shader_.use();
-  GLint loc = glGetUniformLocation(shader_.id(), "uColor");
-  glUniform3f(loc, 0.55f, 0.55f, 0.55f);
-
-  glLineWidth(3.5f);
-  glDrawArrays(GL_LINE_STRIP, 0, vertices.size() / 2);
-  
-  glDeleteBuffers(1, &VBO);
-  glDeleteVertexArrays(1, &VAO);
+  Primitives::draw(vertices.data(), (int)(vertices.size() / 2),
+                   Primitives::Mode::LineStrip, 0.55f, 0.55f, 0.55f, 1.0f, 3.5f);
 }
 
 void CompasRenderer::drawToFromFlag(float bearing_deg, float heading_deg, float aspect_fix,
@@ -840,24 +496,6 @@ void CompasRenderer::drawToFromFlag(float bearing_deg, float heading_deg, float
     x3, y3
   };
   
-  GLuint vao, vbo;
-  glGenVertexArrays(1, &vao);
-  glGenBuffers(1, &vbo);
-  
-  glBindVertexArray(vao);
-  glBindBuffer(GL_ARRAY_BUFFER, vbo);
-  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_DYNAMIC_DRAW);
-  
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-  glEnableVertexAttribArray(0);
-
-  shader_.use();
-  GLint loc = glGetUniformLocation(shader_.id(), "uColor");
-  glUniform3f(loc, 1.0f, 1.0f, 0.0f);
-
-  glLineWidth(5.5f);
-  glDrawArrays(GL_LINES, 0, 4);
-  
-  glDeleteBuffers(1, &vbo);
-  glDeleteVertexArrays(1, &vao);
+  Primitives::draw(vertices.data(), 4,
+                   Primitives::Mode::Lines, 1.0f, 1.0f, 0.0f, 1.0f, 5.5f);
 }
\ No newline at end of file
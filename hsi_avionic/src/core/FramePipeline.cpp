@@ -0,0 +1,67 @@
+#include "core/FramePipeline.hpp"
+
+FramePipeline::FramePipeline(int max_queued, BuildFn build)
+    : max_queued_(max_queued > 0 ? max_queued : 0), build_(std::move(build)) {
+  if (max_queued_ > 0) builder_ = std::thread(&FramePipeline::builderLoop, this);
+}
+
+FramePipeline::~FramePipeline() {
+  stop();
+}
+
+BuiltFrame FramePipeline::advance(const FrameInput& input) {
+  //Minimum latency: build and hand over in one go
+  if (!builder_.joinable()) {
+    const double input_time_s = build_(input);
+    return { CommandList::finish(), input_time_s };
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  inputs_.push_back(input);
+  ++in_flight_;
+  cv_.notify_all();
+
+  if (in_flight_ <= max_queued_) return { nullptr, -1.0 };
+
+  cv_.wait(lock, [this] { return !finished_.empty(); });
+  const BuiltFrame frame = finished_.front();
+  finished_.pop_front();
+  --in_flight_;
+  return frame;
+}
+
+void FramePipeline::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  if (builder_.joinable()) builder_.join();
+
+  for (const BuiltFrame& frame : finished_) CommandList::discard(frame.commands);
+  finished_.clear();
+  inputs_.clear();
+  in_flight_ = 0;
+}
+
+void FramePipeline::builderLoop() {
+  for (;;) {
+    FrameInput input;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return stopping_ || !inputs_.empty(); });
+      if (stopping_) return;
+      input = inputs_.front();
+      inputs_.pop_front();
+    }
+
+    const double input_time_s = build_(input);
+    CommandList::Frame* frame = CommandList::finish();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      finished_.push_back({ frame, input_time_s });
+    }
+    cv_.notify_all();
+  }
+}
@@ -1,88 +1,125 @@
 #include "core/InputHandler.hpp"
 #include "config/AppConfig.hpp"
 
-void InputHandler::processInput(GLFWwindow* window, float& heading_deg, float& bug_heading,
-                                 float& wp_left_bearing, float& wp_right_bearing,
-                                 CompasRenderer& compas, float delta_time) {
-  handleHeadingAdjustment(window, heading_deg, compas, delta_time);
-  handleBugHeadingAdjustment(window, bug_heading, delta_time);
-  handleWaypointAdjustment(window, wp_left_bearing, wp_right_bearing, delta_time);
-  handlePerpLineControl(window, compas);
-  handleToFromToggle(window, compas);
-
-  if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
-    glfwSetWindowShouldClose(window, GLFW_TRUE);
+#include <algorithm>
+
+namespace {
+  //Filled by the key callback, drained by the main loop; both on the GLFW thread
+  std::vector<InputHandler::KeyEvent> g_events;
+
+  void keyCallback(GLFWwindow* window, int key, int, int action, int) {
+    if (action == GLFW_REPEAT) return;
+
+    if (key == GLFW_KEY_ESCAPE) {
+      if (action == GLFW_PRESS) glfwSetWindowShouldClose(window, GLFW_TRUE);
+      return;
+    }
+
+    InputHandler::Key k;
+    switch (key) {
+      case GLFW_KEY_LEFT:  k = InputHandler::KEY_HEADING_LEFT; break;
+      case GLFW_KEY_RIGHT: k = InputHandler::KEY_HEADING_RIGHT; break;
+      case GLFW_KEY_UP:    k = InputHandler::KEY_BUG_UP; break;
+      case GLFW_KEY_DOWN:  k = InputHandler::KEY_BUG_DOWN; break;
+      case GLFW_KEY_D:     k = InputHandler::KEY_WP_LEFT_UP; break;
+      case GLFW_KEY_A:     k = InputHandler::KEY_WP_LEFT_DOWN; break;
+      case GLFW_KEY_W:     k = InputHandler::KEY_WP_RIGHT_UP; break;
+      case GLFW_KEY_S:     k = InputHandler::KEY_WP_RIGHT_DOWN; break;
+      case GLFW_KEY_1:     k = InputHandler::KEY_CDI_LEFT; break;
+      case GLFW_KEY_2:     k = InputHandler::KEY_CDI_RIGHT; break;
+      case GLFW_KEY_3:     k = InputHandler::KEY_TO_FROM; break;
+      default: return;
+    }
+    g_events.push_back({ k, action == GLFW_PRESS, glfwGetTime() });
   }
 }
 
-void InputHandler::handleHeadingAdjustment(GLFWwindow* window, float& heading_deg,
-                                           CompasRenderer& compas, float delta_time) {
-  if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS) {
-    heading_deg += 90.0f * delta_time;
-    if (heading_deg >= 360.0f) heading_deg -= 360.0f;
-    compas.setHeadingDeg(heading_deg);
-  }
-  if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS) {
-    heading_deg -= 90.0f * delta_time;
-    if (heading_deg < 0.0f) heading_deg += 360.0f;
-    compas.setHeadingDeg(heading_deg);
+void InputHandler::install(GLFWwindow* window) {
+  glfwSetKeyCallback(window, keyCallback);
+}
+
+void InputHandler::drainEvents(std::vector<KeyEvent>& out) {
+  out.insert(out.end(), g_events.begin(), g_events.end());
+  g_events.clear();
+}
+
+void InputHandler::queue(const std::vector<KeyEvent>& events) {
+  pending_.insert(pending_.end(), events.begin(), events.end());
+}
+
+void InputHandler::processInput(SimulationState& sim, double tick_time_s, float dt) {
+  while (!pending_.empty() && pending_.front().time_s <= tick_time_s) {
+    applyEvent(pending_.front(), sim);
+    pending_.pop_front();
   }
+
+  handleHeadingAdjustment(sim, dt);
+  handleBugHeadingAdjustment(sim, dt);
+  handleWaypointAdjustment(sim, dt);
+  handlePerpLineControl(sim, dt);
+}
+
+double InputHandler::takeAppliedInputTime() {
+  const double t = applied_time_s_;
+  applied_time_s_ = -1.0;
+  return t;
 }
 
-void InputHandler::handleBugHeadingAdjustment(GLFWwindow* window, float& bug_heading, float delta_time) {
-  if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) {
-    bug_heading += 90.0f * delta_time;
-    if (bug_heading >= 360.0f) bug_heading -= 360.0f;
+void InputHandler::applyEvent(const KeyEvent& e, SimulationState& sim) {
+  if (applied_time_s_ < 0.0 || e.time_s < applied_time_s_) applied_time_s_ = e.time_s;
+
+  //TO/FROM flips on the press itself; everything else slews while held
+  if (e.key == KEY_TO_FROM && e.pressed && !held_[KEY_TO_FROM]) sim.to_flag = !sim.to_flag;
+  held_[e.key] = e.pressed;
+}
+
+void InputHandler::handleHeadingAdjustment(SimulationState& sim, float dt) {
+  if (held_[KEY_HEADING_LEFT]) {
+    sim.heading_deg += 90.0f * dt;
+    if (sim.heading_deg >= 360.0f) sim.heading_deg -= 360.0f;
   }
-  if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) {
-    bug_heading -= 90.0f * delta_time;
-    if (bug_heading < 0.0f) bug_heading += 360.0f;
+  if (held_[KEY_HEADING_RIGHT]) {
+    sim.heading_deg -= 90.0f * dt;
+    if (sim.heading_deg < 0.0f) sim.heading_deg += 360.0f;
   }
 }
 
-void InputHandler::handleWaypointAdjustment(GLFWwindow* window, float& wp_left_bearing,
-                                            float& wp_right_bearing, float delta_time) {
-  if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
-    wp_left_bearing += 90.0f * delta_time;
-    if (wp_left_bearing >= 360.0f) wp_left_bearing -= 360.0f;
+void InputHandler::handleBugHeadingAdjustment(SimulationState& sim, float dt) {
+  if (held_[KEY_BUG_UP]) {
+    sim.bug_heading += 90.0f * dt;
+    if (sim.bug_heading >= 360.0f) sim.bug_heading -= 360.0f;
   }
-  if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
-    wp_left_bearing -= 90.0f * delta_time;
-    if (wp_left_bearing < 0.0f) wp_left_bearing += 360.0f;
+  if (held_[KEY_BUG_DOWN]) {
+    sim.bug_heading -= 90.0f * dt;
+    if (sim.bug_heading < 0.0f) sim.bug_heading += 360.0f;
   }
+}
 
-  if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
-    wp_right_bearing += 90.0f * delta_time;
-    if (wp_right_bearing >= 360.0f) wp_right_bearing -= 360.0f;
+void InputHandler::handleWaypointAdjustment(SimulationState& sim, float dt) {
+  if (held_[KEY_WP_LEFT_UP]) {
+    sim.wp_left_bearing += 90.0f * dt;
+    if (sim.wp_left_bearing >= 360.0f) sim.wp_left_bearing -= 360.0f;
   }
-  if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
-    wp_right_bearing -= 90.0f * delta_time;
-    if (wp_right_bearing < 0.0f) wp_right_bearing += 360.0f;
+  if (held_[KEY_WP_LEFT_DOWN]) {
+    sim.wp_left_bearing -= 90.0f * dt;
+    if (sim.wp_left_bearing < 0.0f) sim.wp_left_bearing += 360.0f;
   }
-}
 
-void InputHandler::handlePerpLineControl(GLFWwindow* window, CompasRenderer& compas) {
-  if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS) {
-    float new_offset = compas.getPerpLineOffset() - PerpLineConfig::SENSITIVITY;
-    if (new_offset >= PerpLineConfig::MAX_OFFSET_LEFT) {
-      compas.updatePerpLineOffset(-PerpLineConfig::SENSITIVITY);
-    }
+  if (held_[KEY_WP_RIGHT_UP]) {
+    sim.wp_right_bearing += 90.0f * dt;
+    if (sim.wp_right_bearing >= 360.0f) sim.wp_right_bearing -= 360.0f;
   }
-  if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS) {
-    float new_offset = compas.getPerpLineOffset() + PerpLineConfig::SENSITIVITY;
-    if (new_offset <= PerpLineConfig::MAX_OFFSET_RIGHT) {
-      compas.updatePerpLineOffset(PerpLineConfig::SENSITIVITY);
-    }
+  if (held_[KEY_WP_RIGHT_DOWN]) {
+    sim.wp_right_bearing -= 90.0f * dt;
+    if (sim.wp_right_bearing < 0.0f) sim.wp_right_bearing += 360.0f;
   }
 }
 
-void InputHandler::handleToFromToggle(GLFWwindow* window, CompasRenderer& compas) {
-  if (glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS) {
-    if (!key3_pressed_) {
-      compas.toggleToFromFlag();
-      key3_pressed_ = true;
-    }
-  } else {
-    key3_pressed_ = false;
+void InputHandler::handlePerpLineControl(SimulationState& sim, float dt) {
+  if (held_[KEY_CDI_LEFT]) {
+    sim.cdi_offset = std::max(sim.cdi_offset - PerpLineConfig::SLEW_RATE * dt, PerpLineConfig::MAX_OFFSET_LEFT);
+  }
+  if (held_[KEY_CDI_RIGHT]) {
+    sim.cdi_offset = std::min(sim.cdi_offset + PerpLineConfig::SLEW_RATE * dt, PerpLineConfig::MAX_OFFSET_RIGHT);
   }
-}
\ No newline at end of file
+}
@@ -0,0 +1,102 @@
+#include "core/LatencyMonitor.hpp"
+
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+  //Nearest-rank percentile of a sorted sample
+  double percentile(const std::vector<double>& sorted, double p) {
+    const size_t rank = (size_t)(p * (double)(sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+  }
+
+  void printDistribution(std::ostream& out, const char* name, std::vector<double>& ms) {
+    char line[160];
+    if (ms.empty()) {
+      std::snprintf(line, sizeof(line), "  %-17s no samples\n", name);
+      out << line;
+      return;
+    }
+
+    std::sort(ms.begin(), ms.end());
+    double sum = 0.0;
+    for (double v : ms) sum += v;
+    std::snprintf(line, sizeof(line),
+                  "  %-17s n=%zu mean=%.2f p50=%.2f p95=%.2f p99=%.2f max=%.2f ms\n",
+                  name, ms.size(), sum / (double)ms.size(), percentile(ms, 0.50),
+                  percentile(ms, 0.95), percentile(ms, 0.99), ms.back());
+    out << line;
+  }
+}
+
+void LatencyMonitor::init() {
+  calibrate();
+  ready_ = true;
+}
+
+void LatencyMonitor::shutdown() {
+  for (const Pending& p : pending_) {
+    glDeleteSync(p.fence);
+    free_queries_.push_back(p.query);
+  }
+  pending_.clear();
+
+  if (!free_queries_.empty()) glDeleteQueries((GLsizei)free_queries_.size(), free_queries_.data());
+  free_queries_.clear();
+  ready_ = false;
+}
+
+void LatencyMonitor::calibrate() {
+  GLint64 gpu_ns = 0;
+  glGetInteger64v(GL_TIMESTAMP, &gpu_ns);
+  gpu_to_cpu_s_ = glfwGetTime() - (double)gpu_ns * 1e-9;
+}
+
+void LatencyMonitor::frameSwapped(double input_time_s, double swap_time_s) {
+  if (!ready_ || input_time_s < 0.0) return;
+
+  to_swap_ms_.push_back((swap_time_s - input_time_s) * 1000.0);
+
+  Pending p;
+  if (free_queries_.empty()) {
+    glGenQueries(1, &p.query);
+  } else {
+    p.query = free_queries_.back();
+    free_queries_.pop_back();
+  }
+  glQueryCounter(p.query, GL_TIMESTAMP);
+  p.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  p.input_time_s = input_time_s;
+  pending_.push_back(p);
+}
+
+void LatencyMonitor::poll() {
+  while (!pending_.empty()) {
+    Pending& p = pending_.front();
+    const GLenum status = glClientWaitSync(p.fence, 0, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+
+    GLuint64 gpu_ns = 0;
+    glGetQueryObjectui64v(p.query, GL_QUERY_RESULT, &gpu_ns);
+    const double present_s = (double)gpu_ns * 1e-9 + gpu_to_cpu_s_;
+    to_present_ms_.push_back((present_s - p.input_time_s) * 1000.0);
+
+    glDeleteSync(p.fence);
+    free_queries_.push_back(p.query);
+    pending_.pop_front();
+  }
+}
+
+void LatencyMonitor::report(std::ostream& out) {
+  if (!ready_) return;
+
+  out << "Input latency:\n";
+  printDistribution(out, "input-to-swap", to_swap_ms_);
+  printDistribution(out, "input-to-present", to_present_ms_);
+  to_swap_ms_.clear();
+  to_present_ms_.clear();
+
+  //GPU and CPU clocks drift apart over a long run
+  calibrate();
+}
@@ -0,0 +1,130 @@
+#include "core/QualityGovernor.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include "config/AppConfig.hpp"
+
+using namespace QualityConfig;
+
+void QualityGovernor::init(double budget_ms) {
+  budget_ms_ = budget_ms;
+  level_ = 0;
+  up_windows_.assign(LEVEL_COUNT, UP_WINDOWS);
+  frames_.assign(LEVEL_COUNT, 0);
+  frame_ms_.assign(LEVEL_COUNT, 0.0);
+  //The first window holds shader warm-up; some drivers also report a bogus first query
+  settling_ = true;
+  active_ = true;
+}
+
+void QualityGovernor::shutdown() {
+  if (running_) {
+    glEndQuery(GL_TIME_ELAPSED);
+    free_queries_.push_back(running_);
+    running_ = 0;
+  }
+  for (const Pending& p : pending_) free_queries_.push_back(p.query);
+  pending_.clear();
+
+  if (!free_queries_.empty()) glDeleteQueries((GLsizei)free_queries_.size(), free_queries_.data());
+  free_queries_.clear();
+  active_ = false;
+}
+
+int QualityGovernor::samples() const {
+  return SAMPLES[level_];
+}
+
+float QualityGovernor::resolutionScale() const {
+  return RESOLUTION_SCALE[level_];
+}
+
+void QualityGovernor::beginFrame() {
+  //A driver that falls far behind skips timing frames rather than queueing more
+  if (!active_ || pending_.size() >= (size_t)MAX_PENDING_QUERIES) return;
+
+  if (free_queries_.empty()) {
+    GLuint q = 0;
+    glGenQueries(1, &q);
+    free_queries_.push_back(q);
+  }
+  running_ = free_queries_.back();
+  free_queries_.pop_back();
+  glBeginQuery(GL_TIME_ELAPSED, running_);
+  started_ = std::chrono::steady_clock::now();
+}
+
+void QualityGovernor::endFrame() {
+  if (!running_) return;
+  glEndQuery(GL_TIME_ELAPSED);
+  const double cpu_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started_).count();
+  pending_.push_back({ running_, cpu_ms });
+  running_ = 0;
+}
+
+bool QualityGovernor::poll() {
+  const int before = level_;
+  while (!pending_.empty()) {
+    const Pending p = pending_.front();
+    GLint available = 0;
+    glGetQueryObjectiv(p.query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) break;
+
+    GLuint64 ns = 0;
+    glGetQueryObjectui64v(p.query, GL_QUERY_RESULT, &ns);
+    free_queries_.push_back(p.query);
+    pending_.pop_front();
+    sample(std::max((double)ns * 1e-6, p.cpu_ms));
+  }
+  return level_ != before;
+}
+
+void QualityGovernor::sample(double ms) {
+  window_sum_ += ms;
+  if (++window_frames_ < WINDOW_FRAMES) return;
+  const double mean = window_sum_ / window_frames_;
+  const double sum = window_sum_;
+  window_sum_ = 0.0;
+  window_frames_ = 0;
+
+  //Queries still in flight at a step measured the old level
+  if (settling_) {
+    settling_ = false;
+    return;
+  }
+  frames_[level_] += WINDOW_FRAMES;
+  frame_ms_[level_] += sum;
+
+  if (mean > budget_ms_ && level_ + 1 < LEVEL_COUNT) {
+    if (entered_from_below_) up_windows_[level_] = std::min(up_windows_[level_] * 2, MAX_UP_WINDOWS);
+    ++level_;
+    ++steps_down_;
+    entered_from_below_ = false;
+    calm_windows_ = 0;
+    settling_ = true;
+  } else if (mean < budget_ms_ * HEADROOM && level_ > 0) {
+    if (++calm_windows_ < up_windows_[level_ - 1]) return;
+    --level_;
+    ++steps_up_;
+    entered_from_below_ = true;
+    calm_windows_ = 0;
+    settling_ = true;
+  } else {
+    calm_windows_ = 0;
+  }
+}
+
+void QualityGovernor::report(std::ostream& out) const {
+  char line[160];
+  std::snprintf(line, sizeof(line), "Quality: ended at level %d, %d steps down, %d up, budget %.2f ms\n",
+                level_, steps_down_, steps_up_, budget_ms_);
+  out << line;
+
+  for (int i = 0; i < LEVEL_COUNT; ++i) {
+    if (!frames_[i]) continue;
+    std::snprintf(line, sizeof(line), "  level %d (MSAA %dx, %3.0f%% resolution): %d frames, %.2f ms/frame\n",
+                  i, SAMPLES[i], RESOLUTION_SCALE[i] * 100.0f, frames_[i], frame_ms_[i] / frames_[i]);
+    out << line;
+  }
+}
@@ -1,17 +1,29 @@
 #include "core/RenderEngine.hpp"
 #include "config/AppConfig.hpp"
 #include "gfx/HsiRenderer.hpp"
-#include <cstdio>
-
-RenderEngine::RenderEngine(Shader& shader) : shader_(shader) {}
+#include "gfx/CommandList.hpp"
+#include "gfx/Primitives.hpp"
+#include "gfx/FrameUniforms.hpp"
+#include "gfx/FontAtlas.hpp"
 
 void RenderEngine::renderFrame(CompasRenderer& compas,
                                TtfTextRenderer fonts[],
                                HsiUiRenderer& ui,
                                ApplicationState& state) {
-  glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-  glClear(GL_COLOR_BUFFER_BIT);
+  beginFrame();
+  renderInstrument(compas, fonts, ui, state);
+}
+
+void RenderEngine::beginFrame() {
+  FrameUniforms::update();
+  FontAtlas::beginFrame();
+  Primitives::clear(0.0f, 0.0f, 0.0f);
+}
 
+void RenderEngine::renderInstrument(CompasRenderer& compas,
+                                    TtfTextRenderer fonts[],
+                                    HsiUiRenderer& ui,
+                                    ApplicationState& state) {
   //Render compass
   renderCompass(compas, fonts[FontConfig::CARDINAL], fonts[FontConfig::NUMBERS], state.heading_deg);
 
@@ -19,6 +31,7 @@ void RenderEngine::renderFrame(CompasRenderer& compas,
   renderHeadingDisplay(fonts[FontConfig::HEADING_VALUE], fonts[FontConfig::HEADING_LABEL], state.heading_deg);
 
   //Render IAS/ALT frames
+  beginLayer(LAYER_SYMBOLS);
   HsiRenderer::drawIasAltFrame(
       DataConfig::IAS_FRAME_X, DataConfig::IAS_FRAME_Y,
       DataConfig::IAS_FRAME_WIDTH, DataConfig::IAS_FRAME_HEIGHT,
@@ -30,6 +43,7 @@ void RenderEngine::renderFrame(CompasRenderer& compas,
       ColorRGB::WHITE.r, ColorRGB::WHITE.g, ColorRGB::WHITE.b, false);
 
   //Render side panels
+  beginLayer(LAYER_TEXT);
   ui.renderWindGroup(state.wind, DisplayLayout::LEFT_OFFSET);
   ui.renderGpsGroup(state.gps, DisplayLayout::LEFT_OFFSET);
   ui.renderIasGroup(state.ias, DisplayLayout::LEFT_OFFSET);
@@ -46,33 +60,47 @@ void RenderEngine::renderFrame(CompasRenderer& compas,
   renderNavigationOverlays(compas, state);
 }
 
+void RenderEngine::beginLayer(FrameLayer layer) {
+  //Shapes, lines and text are queued per layer and drawn together on finish
+  CommandList::setLayer(layer);
+}
+
 void RenderEngine::renderCompass(CompasRenderer& compas,
                                  TtfTextRenderer& ttf_cardinal,
                                  TtfTextRenderer& ttf_numbers,
                                  float heading_deg) {
+  beginLayer(LAYER_DIAL);
   compas.drawRing();
   compas.drawTicks();
+
+  beginLayer(LAYER_SYMBOLS);
   compas.drawCardinalMarkers();
   compas.drawHeadingIndicator();
   compas.drawAircraftSymbol(WindowConfig::ASPECT_FIX);
 
-  //Cardinal letters
-  HsiRenderer::drawTextAtBearingRadial(ttf_cardinal, "N",   0.0f, DisplayLayout::CARDINAL_RADIUS, WindowConfig::ASPECT_FIX, heading_deg,
-                                       ColorRGB::YELLOW.r, ColorRGB::YELLOW.g, ColorRGB::YELLOW.b);
-  HsiRenderer::drawTextAtBearingRadial(ttf_cardinal, "E",  90.0f, DisplayLayout::CARDINAL_RADIUS, WindowConfig::ASPECT_FIX, heading_deg,
-                                       ColorRGB::YELLOW.r, ColorRGB::YELLOW.g, ColorRGB::YELLOW.b);
-  HsiRenderer::drawTextAtBearingRadial(ttf_cardinal, "S", 180.0f, DisplayLayout::CARDINAL_RADIUS, WindowConfig::ASPECT_FIX, heading_deg,
-                                       ColorRGB::YELLOW.r, ColorRGB::YELLOW.g, ColorRGB::YELLOW.b);
-  HsiRenderer::drawTextAtBearingRadial(ttf_cardinal, "W", 270.0f, DisplayLayout::CARDINAL_RADIUS, WindowConfig::ASPECT_FIX, heading_deg,
-                                       ColorRGB::YELLOW.r, ColorRGB::YELLOW.g, ColorRGB::YELLOW.b);
-
-  //Heading numbers
+  //Cardinal letters and heading numbers are retained meshes rotated in the shader
+  static constexpr const char* kCardinals[] = {"N", "E", "S", "W"};
   static constexpr int kBearings[] = {30, 60, 120, 150, 210, 240, 300, 330};
-  for (int bearing : kBearings) {
-    char label[16];
-    std::snprintf(label, sizeof(label), "%d", bearing / 10);
+  static constexpr const char* kLabels[] = {"3", "6", "12", "15", "21", "24", "30", "33"};
+
+  beginLayer(LAYER_TEXT);
+  if (cardinal_text_[0] < 0) {
+    for (int i = 0; i < 4; ++i) {
+      cardinal_text_[i] = ttf_cardinal.createText(kCardinals[i], TtfTextRenderer::Align::Pivot, 0.0f, 0.0f);
+    }
+    for (int i = 0; i < 8; ++i) {
+      number_text_[i] = ttf_numbers.createText(kLabels[i], TtfTextRenderer::Align::Pivot, 0.0f, 0.0f);
+    }
+  }
+
+  for (int i = 0; i < 4; ++i) {
+    HsiRenderer::drawTextAtBearingRadial(ttf_cardinal, cardinal_text_[i], 90.0f * i, DisplayLayout::CARDINAL_RADIUS,
+                                         WindowConfig::ASPECT_FIX, heading_deg,
+                                         ColorRGB::YELLOW.r, ColorRGB::YELLOW.g, ColorRGB::YELLOW.b);
+  }
 
-    HsiRenderer::drawTextAtBearingRadial(ttf_numbers, label, (float)bearing,
+  for (int i = 0; i < 8; ++i) {
+    HsiRenderer::drawTextAtBearingRadial(ttf_numbers, number_text_[i], (float)kBearings[i],
                                          DisplayLayout::NUMBER_RADIUS, WindowConfig::ASPECT_FIX, heading_deg,
                                          ColorRGB::WHITE.r, ColorRGB::WHITE.g, ColorRGB::WHITE.b);
   }
@@ -84,33 +112,35 @@ void RenderEngine::renderHeadingDisplay(TtfTextRenderer& ttf_heading,
   float display_heading = 360.0f - static_cast<int>(heading_deg);
   if (display_heading >= 360.0f) display_heading -= 360.0f;
 
-  char heading_str[8];
-  std::snprintf(heading_str, sizeof(heading_str), "%03d", static_cast<int>(display_heading));
+  const char* heading_str = heading_readout_.format(static_cast<int>(display_heading));
 
   ttf_heading.drawTextCenteredNDC(heading_str, 0.0f, 0.82f,
                                  ColorRGB::YELLOW.r, ColorRGB::YELLOW.g, ColorRGB::YELLOW.b);
 
-  ttf_label.drawTextCenteredNDC("HDG", -0.20f, 0.85f,
-                               ColorRGB::WHITE.r, ColorRGB::WHITE.g, ColorRGB::WHITE.b);
+  if (hdg_text_ < 0) {
+    hdg_text_ = ttf_label.createText("HDG", TtfTextRenderer::Align::Center, -0.20f, 0.85f);
+    mag_text_ = ttf_label.createText("°M", TtfTextRenderer::Align::Center, 0.17f, 0.85f);
+  }
 
-  ttf_label.drawTextCenteredNDC("°M", 0.17f, 0.85f,
-                               ColorRGB::WHITE.r, ColorRGB::WHITE.g, ColorRGB::WHITE.b);
+  ttf_label.drawText(hdg_text_, ColorRGB::WHITE.r, ColorRGB::WHITE.g, ColorRGB::WHITE.b);
+  ttf_label.drawText(mag_text_, ColorRGB::WHITE.r, ColorRGB::WHITE.g, ColorRGB::WHITE.b);
 }
 
 void RenderEngine::renderNavigationOverlays(CompasRenderer& compas,
                                             const ApplicationState& state) {
-  shader_.use();
-
   //Right waypoint
+  beginLayer(LAYER_NAV);
   compas.drawWaypointArrowDouble(state.wp_right_bearing, state.heading_deg, WindowConfig::ASPECT_FIX, 0.50f);
 
   //Left waypoint
   compas.drawWaypointArrowSingle(state.wp_left_bearing, state.heading_deg, WindowConfig::ASPECT_FIX, 0.50f);
 
+  beginLayer(LAYER_CDI);
   compas.drawWaypointCircles(state.wp_left_bearing, state.heading_deg, WindowConfig::ASPECT_FIX, 0.50f,
                              CircleConfig::SPACING, CircleConfig::RADIUS,
                              CircleConfig::OPACITY, CircleConfig::LINE_WIDTH);
 
+  beginLayer(LAYER_OVERLAY);
   compas.drawPerpendicularLine(state.wp_left_bearing, state.heading_deg, WindowConfig::ASPECT_FIX,
                                PerpLineConfig::SPACING, PerpLineConfig::LINE_LENGTH, PerpLineConfig::LINE_WIDTH);
 
@@ -0,0 +1,125 @@
+#include "core/StartupTrace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+  using Clock = std::chrono::steady_clock;
+
+  struct Event {
+    std::string name;
+    std::string detail;
+    int thread;
+    double start_ms;
+    double duration_ms;
+  };
+
+  Clock::time_point g_origin = Clock::now();
+  std::mutex g_mutex;
+  std::vector<Event> g_events;
+  std::vector<std::thread::id> g_threads;   // index 0 is the thread that called begin()
+  bool g_recording = true;
+  double g_first_frame_ms = -1.0;
+
+  //Caller holds g_mutex
+  int threadIndex() {
+    const std::thread::id id = std::this_thread::get_id();
+    for (size_t i = 0; i < g_threads.size(); ++i) {
+      if (g_threads[i] == id) return (int)i;
+    }
+    g_threads.push_back(id);
+    return (int)g_threads.size() - 1;
+  }
+
+  void writeString(std::ostream& out, const std::string& s) {
+    out << '"';
+    for (char c : s) {
+      if (c == '"' || c == '\\') out << '\\';
+      out << c;
+    }
+    out << '"';
+  }
+
+  void writeReport(std::ostream& out) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+
+    //Scopes are recorded as they close; report them in start order
+    std::stable_sort(g_events.begin(), g_events.end(),
+                     [](const Event& a, const Event& b) { return a.start_ms < b.start_ms; });
+
+    out << "{\n  \"time_to_first_frame_ms\": " << g_first_frame_ms
+        << ",\n  \"threads\": " << g_threads.size()
+        << ",\n  \"phases\": [";
+
+    for (size_t i = 0; i < g_events.size(); ++i) {
+      const Event& e = g_events[i];
+      out << (i ? ",\n" : "\n") << "    {\"name\": ";
+      writeString(out, e.name);
+      out << ", \"detail\": ";
+      writeString(out, e.detail);
+      out << ", \"thread\": " << e.thread
+          << ", \"start_ms\": " << e.start_ms
+          << ", \"duration_ms\": " << e.duration_ms << "}";
+    }
+    out << "\n  ]\n}\n";
+  }
+}
+
+void StartupTrace::begin() {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  g_origin = Clock::now();
+  g_events.clear();
+  g_threads.assign(1, std::this_thread::get_id());
+  g_recording = true;
+  g_first_frame_ms = -1.0;
+}
+
+double StartupTrace::elapsedMs() {
+  return std::chrono::duration<double, std::milli>(Clock::now() - g_origin).count();
+}
+
+void StartupTrace::record(const char* name, const std::string& detail, double start_ms, double end_ms) {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  if (!g_recording) return;
+  g_events.push_back({ name, detail, threadIndex(), start_ms, end_ms - start_ms });
+}
+
+void StartupTrace::firstFrame() {
+  const double now = elapsedMs();
+  std::lock_guard<std::mutex> lock(g_mutex);
+  if (!g_recording) return;
+  g_first_frame_ms = now;
+  g_recording = false;
+}
+
+double StartupTrace::timeToFirstFrameMs() {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  return g_first_frame_ms;
+}
+
+bool StartupTrace::writeJson(const std::string& path) {
+  if (path == "-") {
+    writeReport(std::cerr);
+    return true;
+  }
+
+  std::ofstream out(path);
+  if (!out) {
+    std::cerr << "Failed to write startup report: " << path << "\n";
+    return false;
+  }
+  writeReport(out);
+  return (bool)out;
+}
+
+StartupTrace::Scope::Scope(const char* name, std::string detail)
+  : name_(name), detail_(std::move(detail)), start_ms_(elapsedMs()) {}
+
+StartupTrace::Scope::~Scope() {
+  record(name_, detail_, start_ms_, elapsedMs());
+}
@@ -0,0 +1,103 @@
+#include "core/TaskGraph.hpp"
+#include "core/StartupTrace.hpp"
+#include "core/ThreadPool.hpp"
+
+TaskGraph::TaskId TaskGraph::add(const char* name, Affinity affinity, std::function<bool()> fn,
+                                 std::vector<TaskId> deps) {
+  const TaskId id = (TaskId)tasks_.size();
+
+  Task task;
+  task.name = name;
+  task.affinity = affinity;
+  task.fn = std::move(fn);
+  task.pending_deps = (int)deps.size();
+  tasks_.push_back(std::move(task));
+
+  for (TaskId dep : deps) tasks_[dep].dependents.push_back(id);
+  return id;
+}
+
+bool TaskGraph::run(ThreadPool& pool) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    remaining_ = (int)tasks_.size();
+    all_ok_ = true;
+  }
+
+  //Collect roots first: scheduling may complete tasks and touch pending_deps
+  std::vector<TaskId> roots;
+  for (TaskId id = 0; id < (TaskId)tasks_.size(); ++id) {
+    if (tasks_[id].pending_deps == 0) roots.push_back(id);
+  }
+  for (TaskId id : roots) schedule(pool, id);
+
+  //Pump Main tasks on this thread until the graph drains
+  for (;;) {
+    TaskId next = -1;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return remaining_ == 0 || !main_queue_.empty(); });
+      if (main_queue_.empty()) break;
+      next = main_queue_.front();
+      main_queue_.pop_front();
+    }
+    execute(pool, next);
+  }
+
+  return all_ok_;
+}
+
+void TaskGraph::schedule(ThreadPool& pool, TaskId id) {
+  if (tasks_[id].affinity == Affinity::Worker) {
+    pool.submit([this, &pool, id] { execute(pool, id); });
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    main_queue_.push_back(id);
+  }
+  cv_.notify_all();
+}
+
+void TaskGraph::execute(ThreadPool& pool, TaskId id) {
+  Task& task = tasks_[id];
+
+  bool skip;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    skip = task.failed_dep;
+  }
+
+  bool ok = false;
+  {
+    StartupTrace::Scope scope(task.name.c_str(),
+                              task.affinity == Affinity::Main ? "task:main" : "task:worker");
+    if (skip) {
+      scope.setDetail("task:skipped");
+    } else {
+      ok = task.fn();
+      if (!ok) scope.setDetail("task:failed");
+    }
+  }
+
+  finish(pool, id, ok);
+}
+
+void TaskGraph::finish(ThreadPool& pool, TaskId id, bool ok) {
+  std::vector<TaskId> ready;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!ok) all_ok_ = false;
+
+    for (TaskId dep : tasks_[id].dependents) {
+      Task& t = tasks_[dep];
+      if (!ok) t.failed_dep = true;
+      if (--t.pending_deps == 0) ready.push_back(dep);
+    }
+    --remaining_;
+  }
+
+  for (TaskId dep : ready) schedule(pool, dep);
+  cv_.notify_all();
+}
@@ -0,0 +1,82 @@
+#include "core/ThreadPool.hpp"
+
+#include <algorithm>
+#include <memory>
+
+ThreadPool::ThreadPool(unsigned thread_count) {
+  if (thread_count == 0) {
+    thread_count = std::thread::hardware_concurrency();
+    if (thread_count > 1) thread_count -= 1;   // caller participates in parallelFor
+    if (thread_count == 0) thread_count = 1;
+  }
+
+  workers_.reserve(thread_count);
+  for (unsigned i = 0; i < thread_count; ++i) {
+    workers_.emplace_back([this] { workerLoop(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  for (std::thread& t : workers_) t.join();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(std::move(task));
+  }
+  cv_.notify_one();
+}
+
+void ThreadPool::workerLoop() {
+  for (;;) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+      if (stopping_ && tasks_.empty()) return;
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    task();
+  }
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)>& fn) {
+  if (count <= 0) return;
+
+  struct Shared {
+    std::atomic<int> next{0};
+    int pending = 0;
+    std::mutex mutex;
+    std::condition_variable done;
+  };
+  auto shared = std::make_shared<Shared>();
+
+  auto run = [shared, count, &fn] {
+    for (int i = shared->next.fetch_add(1); i < count; i = shared->next.fetch_add(1)) {
+      fn(i);
+    }
+  };
+
+  const int helpers = std::min<int>((int)workers_.size(), count - 1);
+  shared->pending = helpers;
+
+  for (int h = 0; h < helpers; ++h) {
+    submit([shared, run] {
+      run();
+      std::lock_guard<std::mutex> lock(shared->mutex);
+      if (--shared->pending == 0) shared->done.notify_one();
+    });
+  }
+
+  run();
+
+  std::unique_lock<std::mutex> lock(shared->mutex);
+  shared->done.wait(lock, [&] { return shared->pending == 0; });
+}
@@ -0,0 +1,107 @@
+#include "gfx/BakedFontFile.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+  constexpr char kMagic[8] = { 'H', 'S', 'I', 'F', 'O', 'N', 'T', 'S' };
+
+  uint64_t alignUp(uint64_t v) {
+    return (v + 15u) & ~uint64_t(15u);
+  }
+}
+
+bool BakedFontFile::write(const std::string& out_path, const std::vector<Source>& sources) {
+  Header header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = VERSION;
+  header.count = (uint32_t)sources.size();
+
+  std::vector<Entry> entries(sources.size());
+  uint64_t offset = alignUp(sizeof(Header) + entries.size() * sizeof(Entry));
+
+  for (size_t i = 0; i < sources.size(); ++i) {
+    const Source& src = sources[i];
+    Entry& e = entries[i];
+
+    if (src.path.size() >= sizeof(e.path)) {
+      std::cerr << "Font path too long for baked atlas: " << src.path << "\n";
+      return false;
+    }
+
+    std::memset(&e, 0, sizeof(e));
+    std::memcpy(e.path, src.path.c_str(), src.path.size());
+    e.pixel_height = src.pixel_height;
+    e.glyph_set = FontAtlas::GLYPH_SET;
+    e.width = (uint32_t)src.atlas->width();
+    e.height = (uint32_t)src.atlas->height();
+    e.pixels_offset = offset;
+    std::memcpy(e.chars, src.atlas->charTable(), sizeof(e.chars));
+
+    offset = alignUp(offset + (uint64_t)e.width * e.height);
+  }
+
+  std::ofstream out(out_path, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    std::cerr << "Cannot write baked atlas: " << out_path << "\n";
+    return false;
+  }
+
+  out.write((const char*)&header, sizeof(header));
+  out.write((const char*)entries.data(), (std::streamsize)(entries.size() * sizeof(Entry)));
+
+  static const char kZeros[16] = {};
+  for (size_t i = 0; i < sources.size(); ++i) {
+    const uint64_t pos = (uint64_t)out.tellp();
+    out.write(kZeros, (std::streamsize)(entries[i].pixels_offset - pos));
+    out.write((const char*)sources[i].atlas->pixels(),
+              (std::streamsize)((uint64_t)entries[i].width * entries[i].height));
+  }
+
+  return (bool)out;
+}
+
+bool BakedFontFile::open(const std::string& path) {
+  entries_ = nullptr;
+  count_ = 0;
+  if (!file_.open(path)) return false;
+
+  const unsigned char* data = file_.data();
+  const size_t size = file_.size();
+
+  Header header;
+  if (size < sizeof(header)) {
+    file_.close();
+    return false;
+  }
+  std::memcpy(&header, data, sizeof(header));
+
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != VERSION ||
+      sizeof(Header) + (uint64_t)header.count * sizeof(Entry) > size) {
+    std::cerr << "Ignoring incompatible baked atlas: " << path << "\n";
+    file_.close();
+    return false;
+  }
+
+  entries_ = reinterpret_cast<const Entry*>(data + sizeof(Header));
+  count_ = header.count;
+  return true;
+}
+
+bool BakedFontFile::find(const std::string& ttf_path, float pixel_height, FontAtlas& atlas) const {
+  for (uint32_t i = 0; i < count_; ++i) {
+    const Entry& e = entries_[i];
+    if (e.pixel_height != pixel_height || e.glyph_set != FontAtlas::GLYPH_SET) continue;
+    if (std::strncmp(e.path, ttf_path.c_str(), sizeof(e.path)) != 0) continue;
+
+    if (e.width != (uint32_t)FontAtlas::atlas_w || e.height == 0 ||
+        e.pixels_offset + (uint64_t)e.width * e.height > file_.size()) {
+      return false;
+    }
+
+    atlas.adopt(e.chars, file_.data() + e.pixels_offset, (int)e.height, ttf_path, pixel_height);
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,639 @@
+#include "gfx/CommandList.hpp"
+#include "gfx/Shader.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+  enum UniformType : uint8_t { U_1I, U_2F, U_3F, U_4F, U_4I, U_4FV };
+
+  struct Uniform {
+    GLint location;
+    UniformType type;
+    uint16_t count;                  // vec4 elements for U_4FV
+    uint32_t offset;                 // into Frame::words
+  };
+}
+
+struct CommandList::Frame {
+  std::vector<Command> commands;
+  std::vector<Uniform> uniforms;
+  std::vector<uint32_t> words;       // raw float / int uniform values
+  std::vector<std::vector<unsigned char>> streams;
+  std::vector<bool> restarted;       // by stream id, see restartStream()
+  bool clear = false;
+  float clear_color[3] = {};
+
+  void reset() {
+    commands.clear();
+    uniforms.clear();
+    words.clear();
+    for (std::vector<unsigned char>& s : streams) s.clear();
+    restarted.clear();
+    clear = false;
+  }
+};
+
+namespace {
+  using Frame = CommandList::Frame;
+  using StreamUpload = std::function<void(const unsigned char*, size_t)>;
+
+  //Recording side
+  uint8_t g_layer = 0;
+  Frame* g_frame = nullptr;
+  std::vector<std::function<void()>> g_finish_hooks;
+
+  //Shared: registered streams and recycled frames
+  std::vector<StreamUpload> g_streams;
+  std::vector<std::unique_ptr<Frame>> g_all;
+  std::vector<Frame*> g_free;
+  std::mutex g_free_mutex;
+
+  //Submitting side
+  std::vector<uint64_t> g_order;     // sort keys; the low 20 bits are the command index
+  CommandList::Stats g_stats = {};
+
+  //Remote replay: exported handles in both directions
+  using Binder = void (*)(GLuint, int);
+  constexpr int OBJECT_KINDS = 3;
+
+  struct RemoteRegistry {
+    std::unordered_map<const void*, uint16_t> shader_keys;
+    std::unordered_map<uint16_t, const Shader*> shaders;
+    std::unordered_map<GLuint, uint16_t> object_keys[OBJECT_KINDS];
+    std::unordered_map<uint16_t, GLuint> objects[OBJECT_KINDS];
+    std::unordered_map<Binder, uint16_t> binder_keys;
+    std::unordered_map<uint16_t, Binder> binders;
+    std::vector<uint16_t> stream_keys;                 // by stream id; 0 = not exported
+    std::vector<bool> stream_cumulative;
+    std::unordered_map<uint16_t, int> streams;
+    //Sender's uniform location -> ours, per shader key (from applySetup)
+    std::unordered_map<uint16_t, std::unordered_map<GLint, GLint>> locations;
+  };
+  RemoteRegistry g_remote;
+
+  Frame* acquireFrame() {
+    std::lock_guard<std::mutex> lock(g_free_mutex);
+    Frame* f;
+    if (!g_free.empty()) {
+      f = g_free.back();
+      g_free.pop_back();
+    } else {
+      g_all.push_back(std::make_unique<Frame>());
+      f = g_all.back().get();
+    }
+    f->streams.resize(g_streams.size());
+    return f;
+  }
+
+  void releaseFrame(Frame* f) {
+    f->reset();
+    std::lock_guard<std::mutex> lock(g_free_mutex);
+    g_free.push_back(f);
+  }
+
+  Frame& recording() {
+    if (!g_frame) g_frame = acquireFrame();
+    return *g_frame;
+  }
+
+  uint32_t wordCount(const Uniform& u) {
+    switch (u.type) {
+      case U_1I: return 1;
+      case U_2F: return 2;
+      case U_3F: return 3;
+      case U_4FV: return 4u * u.count;
+      default: return 4;
+    }
+  }
+
+  template <typename T>
+  void pushUniform(GLint location, UniformType type, int count, const T* values, int n) {
+    Frame& f = recording();
+    if (f.commands.empty() || location < 0) return;
+
+    f.uniforms.push_back({ location, type, (uint16_t)count, (uint32_t)f.words.size() });
+    const size_t at = f.words.size();
+    f.words.resize(at + (size_t)n);
+    std::memcpy(&f.words[at], values, (size_t)n * sizeof(uint32_t));
+    ++f.commands.back().uniform_count;
+  }
+
+  //Program, VAO and texture 0 in the key; the sequence number keeps order within equal state
+  uint64_t sortKey(const CommandList::Command& c) {
+    return ((uint64_t)c.layer << 56) |
+           ((uint64_t)(c.shader->id() & 0xFF) << 48) |
+           ((uint64_t)(c.vao & 0xFF) << 40) |
+           ((uint64_t)(c.textures[0].name & 0xFFFF) << 24) |
+           (uint64_t)(c.seq & 0xFFFFF);
+  }
+
+  bool sameUniforms(const Frame& f, const CommandList::Command& a, const CommandList::Command& b) {
+    if (a.uniform_count != b.uniform_count) return false;
+    for (uint32_t i = 0; i < a.uniform_count; ++i) {
+      const Uniform& ua = f.uniforms[a.uniform_first + i];
+      const Uniform& ub = f.uniforms[b.uniform_first + i];
+      if (ua.location != ub.location || ua.type != ub.type || ua.count != ub.count) return false;
+      if (std::memcmp(&f.words[ua.offset], &f.words[ub.offset], wordCount(ua) * sizeof(uint32_t)) != 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  //b continues a: same state and the next range in the same buffer
+  bool canMerge(const Frame& f, const CommandList::Command& a, const CommandList::Command& b) {
+    if (a.layer != b.layer || a.shader != b.shader || a.vao != b.vao || a.blend != b.blend) return false;
+    if (a.primitive != b.primitive || a.primitive != GL_TRIANGLES) return false;
+    if (a.index_count != b.index_count || a.instance_buffer != b.instance_buffer) return false;
+    if (a.first + a.count != b.first) return false;
+    for (int u = 0; u < CommandList::TEXTURE_UNITS; ++u) {
+      if (a.textures[u].target != b.textures[u].target || a.textures[u].name != b.textures[u].name) return false;
+    }
+    return sameUniforms(f, a, b);
+  }
+
+  void applyUniforms(const Frame& f, const CommandList::Command& c) {
+    for (uint32_t i = 0; i < c.uniform_count; ++i) {
+      const Uniform& u = f.uniforms[c.uniform_first + i];
+      const void* p = &f.words[u.offset];
+      switch (u.type) {
+        case U_1I:  glUniform1iv(u.location, 1, (const GLint*)p); break;
+        case U_2F:  glUniform2fv(u.location, 1, (const GLfloat*)p); break;
+        case U_3F:  glUniform3fv(u.location, 1, (const GLfloat*)p); break;
+        case U_4F:  glUniform4fv(u.location, 1, (const GLfloat*)p); break;
+        case U_4I:  glUniform4iv(u.location, 1, (const GLint*)p); break;
+        case U_4FV: glUniform4fv(u.location, u.count, (const GLfloat*)p); break;
+      }
+    }
+  }
+}
+
+void CommandList::setLayer(uint8_t layer) {
+  g_layer = layer;
+}
+
+uint8_t CommandList::layer() {
+  return g_layer;
+}
+
+CommandList::Command& CommandList::record(const Shader& shader, GLuint vao, GLenum primitive, int first, int count) {
+  Frame& f = recording();
+  Command c = {};
+  c.layer = g_layer;
+  c.seq = (uint32_t)f.commands.size();
+  c.shader = &shader;
+  c.vao = vao;
+  c.blend = true;
+  c.primitive = primitive;
+  c.first = first;
+  c.count = count;
+  c.uniform_first = (uint32_t)f.uniforms.size();
+  f.commands.push_back(c);
+  return f.commands.back();
+}
+
+void CommandList::uniform1i(GLint location, int v) {
+  pushUniform(location, U_1I, 1, &v, 1);
+}
+
+void CommandList::uniform2f(GLint location, float x, float y) {
+  const float v[2] = { x, y };
+  pushUniform(location, U_2F, 1, v, 2);
+}
+
+void CommandList::uniform3f(GLint location, float x, float y, float z) {
+  const float v[3] = { x, y, z };
+  pushUniform(location, U_3F, 1, v, 3);
+}
+
+void CommandList::uniform4f(GLint location, float x, float y, float z, float w) {
+  const float v[4] = { x, y, z, w };
+  pushUniform(location, U_4F, 1, v, 4);
+}
+
+void CommandList::uniform4i(GLint location, int x, int y, int z, int w) {
+  const int v[4] = { x, y, z, w };
+  pushUniform(location, U_4I, 1, v, 4);
+}
+
+void CommandList::uniform4fv(GLint location, int count, const float* v) {
+  if (count <= 0) return;
+  pushUniform(location, U_4FV, count, v, count * 4);
+}
+
+size_t CommandList::size() {
+  return recording().commands.size();
+}
+
+CommandList::Command& CommandList::at(size_t index) {
+  return recording().commands[index];
+}
+
+void CommandList::setClearColor(float r, float g, float b) {
+  Frame& f = recording();
+  f.clear = true;
+  f.clear_color[0] = r;
+  f.clear_color[1] = g;
+  f.clear_color[2] = b;
+}
+
+int CommandList::addStream(std::function<void(const unsigned char* data, size_t bytes)> upload) {
+  g_streams.push_back(std::move(upload));
+  return (int)g_streams.size() - 1;
+}
+
+std::vector<unsigned char>& CommandList::stream(int id) {
+  Frame& f = recording();
+  if (f.streams.size() < g_streams.size()) f.streams.resize(g_streams.size());
+  return f.streams[(size_t)id];
+}
+
+void CommandList::restartStream(int id) {
+  Frame& f = recording();
+  if (f.restarted.size() <= (size_t)id) f.restarted.resize((size_t)id + 1, false);
+  f.restarted[(size_t)id] = true;
+}
+
+void CommandList::addFinishHook(std::function<void()> hook) {
+  g_finish_hooks.push_back(std::move(hook));
+}
+
+CommandList::Frame* CommandList::finish() {
+  for (const std::function<void()>& hook : g_finish_hooks) hook();
+
+  Frame* f = &recording();
+  g_frame = nullptr;
+  g_layer = 0;
+  return f;
+}
+
+void CommandList::discard(Frame* frame) {
+  if (frame) releaseFrame(frame);
+}
+
+void CommandList::submit(Frame* frame) {
+  if (!frame) return;
+  Frame& f = *frame;
+
+  if (f.clear) {
+    glClearColor(f.clear_color[0], f.clear_color[1], f.clear_color[2], 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+  }
+  for (size_t s = 0; s < f.streams.size(); ++s) {
+    if (!f.streams[s].empty()) g_streams[s](f.streams[s].data(), f.streams[s].size());
+  }
+
+  g_stats = {};
+  g_stats.commands = (int)f.commands.size();
+  if (f.commands.empty()) {
+    releaseFrame(frame);
+    return;
+  }
+
+  g_order.clear();
+  for (size_t i = 0; i < f.commands.size(); ++i) {
+    g_order.push_back(sortKey(f.commands[i]));
+  }
+  std::sort(g_order.begin(), g_order.end());
+
+  //Tracked state; only changes are sent
+  const Shader* shader = nullptr;
+  GLuint vao = 0;
+  bool blend = false;
+  Texture bound[TEXTURE_UNITS] = {};
+  int active_unit = 0;
+
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glActiveTexture(GL_TEXTURE0);
+
+  for (size_t k = 0; k < g_order.size();) {
+    Command c = f.commands[g_order[k] & 0xFFFFF];
+    for (++k; k < g_order.size() && canMerge(f, c, f.commands[g_order[k] & 0xFFFFF]); ++k) {
+      c.count += f.commands[g_order[k] & 0xFFFFF].count;
+    }
+    if (c.shader != shader) {
+      c.shader->use();
+      shader = c.shader;
+      ++g_stats.program_changes;
+    }
+    if (c.vao != vao) {
+      glBindVertexArray(c.vao);
+      vao = c.vao;
+    }
+    if (c.blend != blend) {
+      if (c.blend) glEnable(GL_BLEND);
+      else glDisable(GL_BLEND);
+      blend = c.blend;
+    }
+    for (int u = 0; u < TEXTURE_UNITS; ++u) {
+      const Texture& t = c.textures[u];
+      if (!t.name || (t.target == bound[u].target && t.name == bound[u].name)) continue;
+      if (active_unit != u) {
+        glActiveTexture(GL_TEXTURE0 + u);
+        active_unit = u;
+      }
+      glBindTexture(t.target, t.name);
+      bound[u] = t;
+      ++g_stats.texture_changes;
+    }
+
+    applyUniforms(f, c);
+
+    if (c.index_count > 0) {
+      if (c.bind_instances) c.bind_instances(c.instance_buffer, c.first);
+      glDrawElementsInstanced(c.primitive, c.index_count, GL_UNSIGNED_BYTE, nullptr, c.count);
+    } else {
+      glDrawArrays(c.primitive, c.first, c.count);
+    }
+    ++g_stats.draws;
+  }
+
+  //Leave the defaults the rest of the code expects
+  for (int u = TEXTURE_UNITS - 1; u >= 0; --u) {
+    if (!bound[u].name) continue;
+    glActiveTexture(GL_TEXTURE0 + u);
+    glBindTexture(bound[u].target, 0);
+  }
+  glActiveTexture(GL_TEXTURE0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+  glDisable(GL_BLEND);
+
+  releaseFrame(frame);
+}
+
+void CommandList::shutdown() {
+  g_frame = nullptr;
+  g_layer = 0;
+  g_finish_hooks.clear();
+  g_streams.clear();
+  g_free.clear();
+  g_all.clear();
+  g_remote = RemoteRegistry();
+}
+
+const CommandList::Stats& CommandList::lastStats() {
+  return g_stats;
+}
+
+//Remote replay
+
+void CommandList::exportShader(uint16_t key, const Shader* shader) {
+  g_remote.shader_keys.emplace(shader, key);   // shaders shared by several owners keep their first key
+  g_remote.shaders[key] = shader;
+}
+
+void CommandList::exportObject(ObjectKind kind, uint16_t key, GLuint name) {
+  g_remote.object_keys[(int)kind].emplace(name, key);
+  g_remote.objects[(int)kind][key] = name;
+}
+
+void CommandList::exportBinder(uint16_t key, void (*bind)(GLuint buffer, int first)) {
+  g_remote.binder_keys.emplace(bind, key);
+  g_remote.binders[key] = bind;
+}
+
+void CommandList::exportStream(uint16_t key, int stream, bool cumulative) {
+  if (g_remote.stream_keys.size() <= (size_t)stream) {
+    g_remote.stream_keys.resize((size_t)stream + 1, 0);
+    g_remote.stream_cumulative.resize((size_t)stream + 1, false);
+  }
+  g_remote.stream_keys[(size_t)stream] = key;
+  g_remote.stream_cumulative[(size_t)stream] = cumulative;
+  g_remote.streams[key] = stream;
+}
+
+namespace {
+  //Host byte order: heads run on the same architecture as the sender
+  template <typename T>
+  void put(std::vector<unsigned char>& out, T v) {
+    const size_t at = out.size();
+    out.resize(at + sizeof(T));
+    std::memcpy(&out[at], &v, sizeof(T));
+  }
+
+  struct Reader {
+    const unsigned char* p;
+    const unsigned char* end;
+
+    template <typename T>
+    bool get(T& v) {
+      if ((size_t)(end - p) < sizeof(T)) return false;
+      std::memcpy(&v, p, sizeof(T));
+      p += sizeof(T);
+      return true;
+    }
+
+    bool skip(size_t n, const unsigned char*& at) {
+      if ((size_t)(end - p) < n) return false;
+      at = p;
+      p += n;
+      return true;
+    }
+  };
+
+  template <typename Map, typename Key>
+  uint16_t keyOf(const Map& map, Key k) {
+    auto it = map.find(k);
+    return it == map.end() ? 0 : it->second;
+  }
+
+  //false when a non-zero key was not exported here
+  template <typename Map, typename Value>
+  bool resolve(const Map& map, uint16_t key, Value& out) {
+    if (key == 0) {
+      out = Value();
+      return true;
+    }
+    auto it = map.find(key);
+    if (it == map.end()) return false;
+    out = it->second;
+    return true;
+  }
+}
+
+void CommandList::encode(const Frame* frame, EncodedFrame& out) {
+  out.streams.clear();
+  out.body.clear();
+  if (!frame) return;
+  const Frame& f = *frame;
+
+  for (size_t s = 0; s < f.streams.size(); ++s) {
+    if (f.streams[s].empty() || s >= g_remote.stream_keys.size() || !g_remote.stream_keys[s]) continue;
+    const bool restart = s < f.restarted.size() && f.restarted[s];
+    out.streams.push_back({ g_remote.stream_keys[s], (bool)g_remote.stream_cumulative[s], restart, f.streams[s] });
+  }
+
+  std::vector<unsigned char>& b = out.body;
+  put<uint8_t>(b, f.clear ? 1 : 0);
+  for (int i = 0; i < 3; ++i) put<float>(b, f.clear_color[i]);
+
+  put<uint32_t>(b, (uint32_t)f.commands.size());
+  for (const Command& c : f.commands) {
+    put<uint8_t>(b, c.layer);
+    put<uint8_t>(b, c.blend ? 1 : 0);
+    put<uint16_t>(b, (uint16_t)c.primitive);
+    put<uint16_t>(b, keyOf(g_remote.shader_keys, (const void*)c.shader));
+    put<uint16_t>(b, keyOf(g_remote.object_keys[(int)ObjectKind::VertexArray], c.vao));
+    for (const Texture& t : c.textures) {
+      put<uint16_t>(b, (uint16_t)t.target);
+      put<uint16_t>(b, t.name ? keyOf(g_remote.object_keys[(int)ObjectKind::Texture], t.name) : 0);
+    }
+    put<int32_t>(b, c.first);
+    put<int32_t>(b, c.count);
+    put<int32_t>(b, c.index_count);
+    put<uint16_t>(b, c.instance_buffer ? keyOf(g_remote.object_keys[(int)ObjectKind::Buffer], c.instance_buffer) : 0);
+    put<uint16_t>(b, c.bind_instances ? keyOf(g_remote.binder_keys, c.bind_instances) : 0);
+    put<uint16_t>(b, (uint16_t)c.uniform_count);
+
+    for (uint32_t i = 0; i < c.uniform_count; ++i) {
+      const Uniform& u = f.uniforms[c.uniform_first + i];
+      put<int16_t>(b, (int16_t)u.location);
+      put<uint8_t>(b, u.type);
+      put<uint8_t>(b, 0);
+      put<uint16_t>(b, u.count);
+      const size_t at = b.size();
+      b.resize(at + wordCount(u) * sizeof(uint32_t));
+      std::memcpy(&b[at], &f.words[u.offset], wordCount(u) * sizeof(uint32_t));
+    }
+  }
+}
+
+void CommandList::encodeSetup(std::vector<unsigned char>& out) {
+  out.clear();
+  put<uint32_t>(out, (uint32_t)g_remote.shaders.size());
+  for (const auto& entry : g_remote.shaders) {
+    const Shader* shader = entry.second;
+    put<uint16_t>(out, entry.first);
+    put<uint16_t>(out, (uint16_t)shader->uniformCount());
+    for (size_t i = 0; i < shader->uniformCount(); ++i) {
+      const std::string& name = shader->uniformName(i);
+      put<int32_t>(out, shader->uniformLocation(i));
+      put<uint16_t>(out, (uint16_t)name.size());
+      out.insert(out.end(), name.begin(), name.end());
+    }
+  }
+}
+
+bool CommandList::applySetup(const unsigned char* data, size_t bytes) {
+  Reader r = { data, data + bytes };
+  uint32_t shader_count = 0;
+  if (!r.get(shader_count)) return false;
+
+  g_remote.locations.clear();
+  for (uint32_t s = 0; s < shader_count; ++s) {
+    uint16_t key = 0, uniform_count = 0;
+    if (!r.get(key) || !r.get(uniform_count)) return false;
+
+    auto shader = g_remote.shaders.find(key);
+    std::unordered_map<GLint, GLint>& map = g_remote.locations[key];
+    for (uint16_t i = 0; i < uniform_count; ++i) {
+      int32_t location = 0;
+      uint16_t length = 0;
+      const unsigned char* name = nullptr;
+      if (!r.get(location) || !r.get(length) || !r.skip(length, name)) return false;
+
+      const std::string uniform_name((const char*)name, length);
+      map[location] = shader == g_remote.shaders.end() ? -1 : shader->second->uniform(uniform_name.c_str());
+    }
+  }
+  return true;
+}
+
+CommandList::Frame* CommandList::decode(const unsigned char* data, size_t bytes) {
+  Reader r = { data, data + bytes };
+  Frame* f = acquireFrame();
+  auto fail = [f](const char* what) -> Frame* {
+    std::cerr << "Remote frame rejected: " << what << "\n";
+    releaseFrame(f);
+    return nullptr;
+  };
+
+  uint32_t stream_count = 0;
+  if (!r.get(stream_count)) return fail("truncated");
+  for (uint32_t i = 0; i < stream_count; ++i) {
+    uint16_t key = 0, pad = 0;
+    uint32_t size = 0;
+    const unsigned char* payload = nullptr;
+    int stream = -1;
+    if (!r.get(key) || !r.get(pad) || !r.get(size) || !r.skip(size, payload)) return fail("truncated stream");
+    if (!resolve(g_remote.streams, key, stream) || stream < 0) return fail("unknown stream");
+    f->streams[(size_t)stream].assign(payload, payload + size);
+  }
+
+  //A sync message carries streams only
+  if (r.p == r.end) return f;
+
+  uint8_t clear = 0;
+  if (!r.get(clear) || !r.get(f->clear_color[0]) || !r.get(f->clear_color[1]) || !r.get(f->clear_color[2])) {
+    return fail("truncated header");
+  }
+  f->clear = clear != 0;
+
+  uint32_t command_count = 0;
+  if (!r.get(command_count)) return fail("truncated header");
+  for (uint32_t n = 0; n < command_count; ++n) {
+    Command c = {};
+    uint8_t blend = 0;
+    uint16_t primitive = 0, shader = 0, vao = 0, buffer = 0, binder = 0, uniform_count = 0;
+    if (!r.get(c.layer) || !r.get(blend) || !r.get(primitive) || !r.get(shader) || !r.get(vao)) {
+      return fail("truncated command");
+    }
+    if (!resolve(g_remote.shaders, shader, c.shader) || !c.shader ||
+        !resolve(g_remote.objects[(int)ObjectKind::VertexArray], vao, c.vao)) {
+      return fail("unknown shader or vertex array");
+    }
+    for (Texture& t : c.textures) {
+      uint16_t target = 0, key = 0;
+      if (!r.get(target) || !r.get(key)) return fail("truncated command");
+      if (!resolve(g_remote.objects[(int)ObjectKind::Texture], key, t.name)) return fail("unknown texture");
+      t.target = target;
+    }
+    if (!r.get(c.first) || !r.get(c.count) || !r.get(c.index_count) ||
+        !r.get(buffer) || !r.get(binder) || !r.get(uniform_count)) {
+      return fail("truncated command");
+    }
+    if (!resolve(g_remote.objects[(int)ObjectKind::Buffer], buffer, c.instance_buffer) ||
+        !resolve(g_remote.binders, binder, c.bind_instances)) {
+      return fail("unknown instance buffer");
+    }
+    c.seq = n;
+    c.blend = blend != 0;
+    c.primitive = primitive;
+    c.uniform_first = (uint32_t)f->uniforms.size();
+    c.uniform_count = uniform_count;
+
+    const auto locations = g_remote.locations.find(shader);
+    for (uint16_t i = 0; i < uniform_count; ++i) {
+      int16_t location = 0;
+      uint8_t type = 0, pad = 0;
+      uint16_t count = 0;
+      if (!r.get(location) || !r.get(type) || !r.get(pad) || !r.get(count) || type > U_4FV) {
+        return fail("truncated uniform");
+      }
+
+      Uniform u = { location, (UniformType)type, count, (uint32_t)f->words.size() };
+      if (locations != g_remote.locations.end()) {
+        auto it = locations->second.find(location);
+        u.location = it == locations->second.end() ? -1 : it->second;
+      }
+
+      const unsigned char* values = nullptr;
+      if (!r.skip(wordCount(u) * sizeof(uint32_t), values)) return fail("truncated uniform");
+      f->words.resize(u.offset + wordCount(u));
+      std::memcpy(&f->words[u.offset], values, wordCount(u) * sizeof(uint32_t));
+      f->uniforms.push_back(u);
+    }
+    f->commands.push_back(c);
+  }
+
+  if (r.p != r.end) return fail("trailing bytes");
+  return f;
+}
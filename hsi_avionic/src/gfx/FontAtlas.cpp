@@ -0,0 +1,455 @@
+#include "gfx/FontAtlas.hpp"
+
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "stb/stb_truetype.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+  uint32_t g_frame = 1;
+}
+
+static bool readFileBytes(const std::string& path, std::vector<unsigned char>& out) {
+  std::ifstream f(path, std::ios::binary);
+  if (!f) return false;
+
+  f.seekg(0, std::ios::end);
+  const auto size = static_cast<size_t>(f.tellg());
+  f.seekg(0, std::ios::beg);
+
+  out.resize(size);
+  f.read(reinterpret_cast<char*>(out.data()), static_cast<std::streamsize>(size));
+  return true;
+}
+
+static FontAtlas::BakedChar toBakedChar(const stbtt_packedchar& pc) {
+  return {
+    static_cast<float>(pc.x0),
+    static_cast<float>(pc.y0),
+    static_cast<float>(pc.x1),
+    static_cast<float>(pc.y1),
+    pc.xoff,
+    pc.yoff,
+    pc.xadvance
+  };
+}
+
+FontAtlas::FontAtlas() = default;
+FontAtlas::~FontAtlas() = default;
+
+//Dynamic glyphs were rasterized at the previous size
+void FontAtlas::resetDynamic() {
+  font_.reset();
+  font_failed_ = false;
+  full_warned_ = false;
+  pages_.clear();
+  glyphs_.clear();
+  dirty_.clear();
+}
+
+bool FontAtlas::build(const std::string& ttf_path, float pixel_height) {
+  if (ttf_path != ttf_path_) ttf_.clear();
+  ttf_path_ = ttf_path;
+  pixel_height_ = pixel_height;
+  resetDynamic();
+
+  std::vector<unsigned char>& ttf = ttf_;
+  if (ttf.empty() && !readFileBytes(ttf_path, ttf)) {
+    std::cerr << "Failed to read TTF: " << ttf_path << "\n";
+    font_failed_ = true;
+    return false;
+  }
+
+  stbtt_packedchar baked_ascii[95];
+  stbtt_packedchar baked_degree[1];
+
+  //Large sizes get a taller packing area
+  int pack_h = atlas_h;
+  for (;;) {
+    bitmap_.assign((size_t)atlas_w * pack_h, 0);
+
+    stbtt_pack_context pc{};
+    if (!stbtt_PackBegin(&pc, bitmap_.data(), atlas_w, pack_h, 0, 1, nullptr)) {
+      std::cerr << "stbtt_PackBegin failed\n";
+      return false;
+    }
+
+    stbtt_PackSetOversampling(&pc, 1, 1);
+
+    const bool packed = stbtt_PackFontRange(&pc, ttf.data(), 0, pixel_height, 32, 95, baked_ascii) &&
+                        stbtt_PackFontRange(&pc, ttf.data(), 0, pixel_height, 176, 1, baked_degree);
+    stbtt_PackEnd(&pc);
+
+    if (packed || pack_h >= MAX_ATLAS_H) break;
+    pack_h *= 2;
+  }
+
+  for (int i = 0; i < 95; ++i) {
+    chars_[i] = toBakedChar(baked_ascii[i]);
+  }
+  chars_[144] = toBakedChar(baked_degree[0]);
+
+  //Keep only the rows the packer used (+1 so bilinear taps stay in range)
+  float used = 0.0f;
+  for (const BakedChar& bc : chars_) used = std::max(used, bc.y1);
+  height_ = std::min(pack_h, (int)used + 1);
+  bitmap_.resize((size_t)atlas_w * height_);
+  pixels_ = bitmap_.data();
+
+  return true;
+}
+
+void FontAtlas::adopt(const BakedChar chars[CHAR_COUNT], const unsigned char* pixels, int height,
+                      const std::string& ttf_path, float pixel_height) {
+  resetDynamic();
+  std::copy(chars, chars + CHAR_COUNT, chars_);
+  bitmap_.clear();
+  bitmap_.shrink_to_fit();
+  pixels_ = pixels;
+  height_ = height;
+
+  if (ttf_path != ttf_path_) ttf_.clear();
+  ttf_path_ = ttf_path;
+  pixel_height_ = pixel_height;
+}
+
+void FontAtlas::beginFrame() {
+  ++g_frame;
+}
+
+uint32_t FontAtlas::decodeUtf8(const char*& p) {
+  const unsigned char* s = (const unsigned char*)p;
+  const unsigned char c = s[0];
+
+  if (c < 0x80) {
+    p += 1;
+    return c;
+  }
+
+  int extra;
+  uint32_t cp;
+  if ((c & 0xE0) == 0xC0)      { extra = 1; cp = c & 0x1F; }
+  else if ((c & 0xF0) == 0xE0) { extra = 2; cp = c & 0x0F; }
+  else if ((c & 0xF8) == 0xF0) { extra = 3; cp = c & 0x07; }
+  else { p += 1; return 0xFFFD; }
+
+  for (int i = 1; i <= extra; ++i) {
+    if ((s[i] & 0xC0) != 0x80) { p += 1; return 0xFFFD; }   // also stops at the terminator
+    cp = (cp << 6) | (s[i] & 0x3F);
+  }
+
+  //Overlong forms, surrogates and out-of-range values
+  static const uint32_t kMin[4] = { 0, 0x80, 0x800, 0x10000 };
+  if (cp < kMin[extra] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+    p += 1;
+    return 0xFFFD;
+  }
+
+  p += 1 + extra;
+  return cp;
+}
+
+const unsigned char* FontAtlas::pagePixels(int page) const {
+  return page == 0 ? pixels_ : pages_[page - 1].pixels.data();
+}
+
+void FontAtlas::setUvs(const BakedChar* bc, int page, GlyphQuad& q) const {
+  const float w = (float)pageWidth(page);
+  const float h = (float)pageHeight(page);
+  q.u0 = bc->x0 / w;
+  q.v0 = bc->y0 / h;
+  q.u1 = bc->x1 / w;
+  q.v1 = bc->y1 / h;
+  q.page = page;
+}
+
+const FontAtlas::BakedChar* FontAtlas::getCharMetrics(uint32_t codepoint, int* page) {
+  if (page) *page = 0;
+  if (codepoint >= 32 && codepoint <= 126) return &chars_[codepoint - 32];
+  if (codepoint == 176) return &chars_[144];
+
+  const Glyph* glyph = cacheGlyph(codepoint);
+  if (!glyph) return nullptr;
+
+  if (page) *page = glyph->page;
+  return &glyph->bc;
+}
+
+bool FontAtlas::loadFont() {
+  if (font_) return true;
+  if (font_failed_) return false;
+
+  if (ttf_.empty() && !readFileBytes(ttf_path_, ttf_)) {
+    std::cerr << "Failed to read TTF: " << ttf_path_ << "\n";
+    font_failed_ = true;
+    return false;
+  }
+
+  std::unique_ptr<stbtt_fontinfo> font(new stbtt_fontinfo());
+  if (!stbtt_InitFont(font.get(), ttf_.data(), stbtt_GetFontOffsetForIndex(ttf_.data(), 0))) {
+    std::cerr << "stbtt_InitFont failed: " << ttf_path_ << "\n";
+    font_failed_ = true;
+    return false;
+  }
+
+  //Same scale as stbtt_PackFontRange; shelves fit the tallest glyph plus a padding row
+  scale_ = stbtt_ScaleForPixelHeight(font.get(), pixel_height_);
+  int bx0, by0, bx1, by1;
+  stbtt_GetFontBoundingBox(font.get(), &bx0, &by0, &bx1, &by1);
+  shelf_height_ = std::min(PAGE_SIZE, (int)std::ceil((by1 - by0) * scale_) + 2);
+
+  font_ = std::move(font);
+  return true;
+}
+
+bool FontAtlas::allocate(int w, int& page, int& shelf) {
+  //First fit in an open shelf
+  for (int p = 0; p < (int)pages_.size(); ++p) {
+    std::vector<Shelf>& shelves = pages_[p].shelves;
+    for (int s = 0; s < (int)shelves.size(); ++s) {
+      if (shelves[s].x + w <= PAGE_SIZE) {
+        page = p; shelf = s;
+        return true;
+      }
+    }
+  }
+
+  //New shelf, then new page
+  for (int p = 0; p < (int)pages_.size(); ++p) {
+    std::vector<Shelf>& shelves = pages_[p].shelves;
+    const int y = (int)shelves.size() * shelf_height_;
+    if (y + shelf_height_ <= PAGE_SIZE) {
+      shelves.push_back({ y, 0, g_frame, {} });
+      page = p; shelf = (int)shelves.size() - 1;
+      return true;
+    }
+  }
+
+  if ((int)pages_.size() < MAX_PAGES) {
+    pages_.emplace_back();
+    pages_.back().pixels.assign((size_t)PAGE_SIZE * PAGE_SIZE, 0);
+    pages_.back().shelves.push_back({ 0, 0, g_frame, {} });
+    page = (int)pages_.size() - 1; shelf = 0;
+    return true;
+  }
+
+  //Evict the least recently used shelf that was not touched this frame
+  int best_page = -1, best_shelf = -1;
+  uint32_t best_used = g_frame;
+  for (int p = 0; p < (int)pages_.size(); ++p) {
+    const std::vector<Shelf>& shelves = pages_[p].shelves;
+    for (int s = 0; s < (int)shelves.size(); ++s) {
+      if (shelves[s].last_used < best_used) {
+        best_used = shelves[s].last_used;
+        best_page = p; best_shelf = s;
+      }
+    }
+  }
+  if (best_page < 0) return false;
+
+  Shelf& victim = pages_[best_page].shelves[best_shelf];
+  for (uint32_t cp : victim.codepoints) glyphs_.erase(cp);
+  victim.codepoints.clear();
+  victim.x = 0;
+
+  page = best_page; shelf = best_shelf;
+  return true;
+}
+
+const FontAtlas::Glyph* FontAtlas::cacheGlyph(uint32_t codepoint) {
+  auto it = glyphs_.find(codepoint);
+  if (it != glyphs_.end()) {
+    if (it->second.page > 0) pages_[it->second.page - 1].shelves[it->second.shelf].last_used = g_frame;
+    return &it->second;
+  }
+
+  if (!loadFont()) return nullptr;
+
+  //Missing code points render the font's .notdef glyph
+  const int index = stbtt_FindGlyphIndex(font_.get(), (int)codepoint);
+
+  int advance, lsb;
+  stbtt_GetGlyphHMetrics(font_.get(), index, &advance, &lsb);
+
+  int gx0, gy0, gx1, gy1;
+  stbtt_GetGlyphBitmapBox(font_.get(), index, scale_, scale_, &gx0, &gy0, &gx1, &gy1);
+  const int w = std::min(gx1 - gx0, PAGE_SIZE - 1);
+  const int h = std::min(gy1 - gy0, shelf_height_ - 1);
+
+  Glyph glyph;
+  glyph.bc = { 0.0f, 0.0f, 0.0f, 0.0f, (float)gx0, (float)gy0, advance * scale_ };
+  glyph.page = 0;
+  glyph.shelf = 0;
+
+  //Blank glyphs (spaces) only need metrics
+  if (w > 0 && h > 0) {
+    int page, shelf;
+    if (!allocate(w + 1, page, shelf)) {
+      if (!full_warned_) {
+        std::cerr << "Glyph cache full for " << ttf_path_ << ", dropping U+" << std::hex << codepoint << std::dec << "\n";
+        full_warned_ = true;
+      }
+      return nullptr;
+    }
+
+    Page& pg = pages_[page];
+    Shelf& sh = pg.shelves[shelf];
+    const int x = sh.x;
+    const int y = sh.y;
+
+    //Clear the slot including its padding, then rasterize into it
+    for (int row = 0; row < shelf_height_; ++row) {
+      std::memset(&pg.pixels[(size_t)(y + row) * PAGE_SIZE + x], 0, (size_t)w + 1);
+    }
+    stbtt_MakeGlyphBitmap(font_.get(), &pg.pixels[(size_t)y * PAGE_SIZE + x], w, h, PAGE_SIZE,
+                          scale_, scale_, index);
+
+    sh.x += w + 1;
+    sh.last_used = g_frame;
+    sh.codepoints.push_back(codepoint);
+    dirty_.push_back({ page + 1, x, y, w + 1, shelf_height_ });
+
+    glyph.bc.x0 = (float)x;
+    glyph.bc.y0 = (float)y;
+    glyph.bc.x1 = (float)(x + w);
+    glyph.bc.y1 = (float)(y + h);
+    glyph.page = page + 1;
+    glyph.shelf = shelf;
+  }
+
+  return &glyphs_.emplace(codepoint, glyph).first->second;
+}
+
+bool FontAtlas::measure(const char* text, float& minx, float& miny, float& maxx, float& maxy) {
+  float pen_x = 0.0f;
+  minx = 1e9f; miny = 1e9f;
+  maxx = -1e9f; maxy = -1e9f;
+
+  for (const char* pc = text; *pc;) {
+    const BakedChar* bc = getCharMetrics(decodeUtf8(pc));
+    if (!bc) continue;
+
+    const float gx0 = pen_x + bc->xoff;
+    const float gy0 = -bc->yoff;
+    const float gx1 = gx0 + (bc->x1 - bc->x0);
+    const float gy1 = gy0 - (bc->y1 - bc->y0);
+
+    minx = std::min(minx, gx0);
+    miny = std::min(miny, gy1);
+    maxx = std::max(maxx, gx1);
+    maxy = std::max(maxy, gy0);
+
+    pen_x += bc->xadvance;
+  }
+
+  return minx <= maxx;
+}
+
+void FontAtlas::layoutNDC(const char* text, float x_ndc, float y_ndc,
+                          std::vector<GlyphQuad>& out) {
+  const float anchor_px = kScale / glyph_scale_;
+  float pen_x = 0.0f;
+  int page = 0;
+
+  for (const char* pc = text; *pc;) {
+    const BakedChar* bc = getCharMetrics(decodeUtf8(pc), &page);
+    if (!bc) continue;
+
+    //Rows are offset by the anchor in design pixels as well
+    const float x0 = pen_x + bc->xoff;
+    const float y0 = y_ndc * anchor_px - bc->yoff;
+    const float x1 = x0 + (bc->x1 - bc->x0);
+    const float y1 = y0 - (bc->y1 - bc->y0);
+
+    const float X0 = x_ndc + x0 * glyph_scale_;
+    const float Y0 = y_ndc + y0 * glyph_scale_;
+    const float X1 = x_ndc + x1 * glyph_scale_;
+    const float Y1 = y_ndc + y1 * glyph_scale_;
+
+    GlyphQuad q;
+    q.px[0] = X0; q.py[0] = Y0;
+    q.px[1] = X1; q.py[1] = Y0;
+    q.px[2] = X1; q.py[2] = Y1;
+    q.px[3] = X0; q.py[3] = Y1;
+    setUvs(bc, page, q);
+    out.push_back(q);
+
+    pen_x += bc->xadvance;
+  }
+}
+
+void FontAtlas::layoutCentered(const char* text, float cx_ndc, float cy_ndc,
+                               std::vector<GlyphQuad>& out) {
+  float minx, miny, maxx, maxy;
+  if (!measure(text, minx, miny, maxx, maxy)) return;
+
+  const float w_ndc = (maxx - minx) * glyph_scale_;
+  const float h_ndc = (maxy - miny) * glyph_scale_;
+
+  const float x_ndc = cx_ndc - 0.5f * w_ndc - (minx * glyph_scale_);
+  const float y_ndc = cy_ndc - 0.5f * h_ndc - (miny * glyph_scale_);
+
+  layoutNDC(text, x_ndc, y_ndc, out);
+}
+
+void FontAtlas::layoutCenteredRotated(const char* text, float cx_ndc, float cy_ndc,
+                                      float rotation_deg, std::vector<GlyphQuad>& out) {
+  float minx, miny, maxx, maxy;
+  if (!measure(text, minx, miny, maxx, maxy)) return;
+
+  const float angle_rad = rotation_deg * 3.14159265359f / 180.0f;
+  const float cos_a = std::cos(angle_rad);
+  const float sin_a = std::sin(angle_rad);
+
+  const float offset_x = -(minx + maxx) * 0.5f;
+  const float offset_y = -(miny + maxy) * 0.5f;
+
+  float pen_x = 0.0f;
+  int page = 0;
+  for (const char* pc = text; *pc;) {
+    const BakedChar* bc = getCharMetrics(decodeUtf8(pc), &page);
+    if (!bc) continue;
+
+    const float x0 = pen_x + bc->xoff + offset_x;
+    const float y0 = -bc->yoff + offset_y;
+    const float x1 = x0 + (bc->x1 - bc->x0);
+    const float y1 = y0 - (bc->y1 - bc->y0);
+
+    const float corners[4][2] = {
+      { x0, y0 }, { x1, y0 }, { x1, y1 }, { x0, y1 }
+    };
+
+    GlyphQuad q;
+    for (int i = 0; i < 4; ++i) {
+      const float fx = corners[i][0] * glyph_scale_;
+      const float fy = corners[i][1] * glyph_scale_;
+
+      q.px[i] = fx * cos_a - fy * sin_a + cx_ndc;
+      q.py[i] = fx * sin_a + fy * cos_a + cy_ndc;
+    }
+    setUvs(bc, page, q);
+    out.push_back(q);
+
+    pen_x += bc->xadvance;
+  }
+}
+
+void FontAtlas::layoutLeftAligned(const char* text, float x, float y,
+                                  std::vector<GlyphQuad>& out) {
+  float minx, miny, maxx, maxy;
+  if (!measure(text, minx, miny, maxx, maxy)) return;
+
+  layoutNDC(text, x - (minx * glyph_scale_), y, out);
+}
+
+void FontAtlas::layoutRightAligned(const char* text, float x, float y,
+                                   std::vector<GlyphQuad>& out) {
+  float minx, miny, maxx, maxy;
+  if (!measure(text, minx, miny, maxx, maxy)) return;
+
+  layoutNDC(text, x - (maxx * glyph_scale_), y, out);
+}
@@ -0,0 +1,61 @@
+#include "gfx/FrameUniforms.hpp"
+#include "gfx/CommandList.hpp"
+#include "gfx/Primitives.hpp"
+
+#include <cstring>
+
+static_assert(sizeof(FrameUniforms::Data) == 16, "FrameUniforms::Data must match the std140 FrameBlock layout");
+
+namespace {
+  GLuint g_ubo = 0;
+  int g_stream = -1;
+  FrameUniforms::Data g_data = {};
+
+  //GL thread, on submit of the frame that recorded the values
+  void upload(const unsigned char* data, size_t bytes) {
+    glBindBuffer(GL_UNIFORM_BUFFER, g_ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, (GLsizeiptr)bytes, data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FrameUniforms::BINDING, g_ubo);
+  }
+}
+
+bool FrameUniforms::init(int width, int height) {
+  setViewport(width, height);
+
+  if (Primitives::softwareTarget()) return true;
+
+  glGenBuffers(1, &g_ubo);
+  glBindBuffer(GL_UNIFORM_BUFFER, g_ubo);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(Data), &g_data, GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+  g_stream = CommandList::addStream(upload);
+  CommandList::exportStream(CommandList::remoteKey(CommandList::REMOTE_FRAME_UNIFORMS, 1), g_stream);
+  return true;
+}
+
+void FrameUniforms::shutdown() {
+  if (g_ubo) glDeleteBuffers(1, &g_ubo);
+  g_ubo = 0;
+  g_stream = -1;
+}
+
+void FrameUniforms::setViewport(int width, int height) {
+  g_data.viewport[0] = (float)width;
+  g_data.viewport[1] = (float)height;
+  g_data.viewport[2] = 1.0f / (float)width;
+  g_data.viewport[3] = 1.0f / (float)height;
+}
+
+void FrameUniforms::update() {
+  if (g_stream < 0) return;
+
+  std::vector<unsigned char>& out = CommandList::stream(g_stream);
+  out.resize(sizeof(Data));
+  std::memcpy(out.data(), &g_data, sizeof(Data));
+}
+
+const FrameUniforms::Data& FrameUniforms::current() {
+  return g_data;
+}
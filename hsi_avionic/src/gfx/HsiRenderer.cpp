@@ -1,10 +1,9 @@
 #include "gfx/HsiRenderer.hpp"
+#include "gfx/Primitives.hpp"
 #include <cmath>
-#include <glad/glad.h>
-#include <vector> 
 
 void HsiRenderer::drawTextAtBearingRadial(TtfTextRenderer& ttf,
-                                          const char* label,
+                                          TtfTextRenderer::TextHandle label,
                                           float bearing_deg,
                                           float radius,
                                           float aspect_fix,
@@ -19,7 +18,7 @@ void HsiRenderer::drawTextAtBearingRadial(TtfTextRenderer& ttf,
 
   float text_rotation = -rotated_bearing;
   
-  ttf.drawTextCenteredNDCRotated(label, x, y, text_rotation, r, g, b);
+  ttf.drawTextTransformed(label, x, y, text_rotation, r, g, b);
 }
 
 void HsiRenderer::drawHeadingBox(float x, float y, float width, float height, 
@@ -31,24 +30,7 @@ void HsiRenderer::drawHeadingBox(float x, float y, float width, float height,
     x - width/2, y + height/2
   };
   
-  GLuint VAO, VBO;
-  glGenVertexArrays(1, &VAO);
-  glGenBuffers(1, &VBO);
-  
-  glBindVertexArray(VAO);
-  glBindBuffer(GL_ARRAY_BUFFER, VBO);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-  
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-  glEnableVertexAttribArray(0);
-  
-  glColor3f(r, g, b);
-  glLineWidth(4.0f);
-  glDrawArrays(GL_LINE_LOOP, 0, 4);
-  
-  glBindVertexArray(0); 
-  glDeleteBuffers(1, &VBO);
-  glDeleteVertexArrays(1, &VAO);
+  Primitives::draw(vertices, 4, Primitives::Mode::LineLoop, r, g, b, 1.0f, 4.0f);
 }
 
 void HsiRenderer::drawIasAltFrame(float x, float y, float width, float height,
@@ -74,40 +56,6 @@ void HsiRenderer::drawIasAltFrame(float x, float y, float width, float height,
     (is_left) ? x1 : x0, y1
   };
   
-  GLuint rect_VAO, rect_VBO;
-  glGenVertexArrays(1, &rect_VAO);
-  glGenBuffers(1, &rect_VBO);
-  
-  glBindVertexArray(rect_VAO);
-  glBindBuffer(GL_ARRAY_BUFFER, rect_VBO);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(rect_vertices), rect_vertices, GL_STATIC_DRAW);
-  
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-  glEnableVertexAttribArray(0);
-  
-  glLineWidth(2.0f);
-  glDrawArrays(GL_LINE_LOOP, 0, 4);
-  
-  glBindVertexArray(0); 
-  glDeleteBuffers(1, &rect_VBO);
-  glDeleteVertexArrays(1, &rect_VAO);
-  
-  GLuint tri_VAO, tri_VBO;
-  glGenVertexArrays(1, &tri_VAO);
-  glGenBuffers(1, &tri_VBO);
-  
-  glBindVertexArray(tri_VAO);
-  glBindBuffer(GL_ARRAY_BUFFER, tri_VBO);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(tri_vertices), tri_vertices, GL_STATIC_DRAW);
-  
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-  glEnableVertexAttribArray(0);
-  
-  glDrawArrays(GL_TRIANGLES, 0, 3);
-  
-  glBindVertexArray(0); 
-  glDeleteBuffers(1, &tri_VBO);
-  glDeleteVertexArrays(1, &tri_VAO);
-  
-  glLineWidth(1.0f);
-}
\ No newline at end of file
+  Primitives::draw(rect_vertices, 4, Primitives::Mode::LineLoop, r, g, b, 1.0f, 2.0f);
+  Primitives::draw(tri_vertices, 3, Primitives::Mode::Triangles, r, g, b);
+}
@@ -0,0 +1,56 @@
+#include "gfx/InstrumentView.hpp"
+
+#include <algorithm>
+
+namespace {
+  InstrumentView::Placement g_placement;
+}
+
+void InstrumentView::set(const Placement& placement) {
+  g_placement = placement;
+}
+
+void InstrumentView::reset() {
+  g_placement = Placement();
+}
+
+const InstrumentView::Placement& InstrumentView::current() {
+  return g_placement;
+}
+
+InstrumentView::Placement InstrumentView::cell(int index, int count, int window_width, int window_height,
+                                               int instrument_width, int instrument_height) {
+  count = std::max(count, 1);
+
+  //Largest scale at which count cells fit, over every column count
+  int columns = 1;
+  float scale = 0.0f;
+  for (int c = 1; c <= count; ++c) {
+    const int rows = (count + c - 1) / c;
+    const float s = std::min((float)window_width / (float)(c * instrument_width),
+                             (float)window_height / (float)(rows * instrument_height));
+    if (s > scale) {
+      scale = s;
+      columns = c;
+    }
+  }
+  const int rows = (count + columns - 1) / columns;
+
+  //Grid centred in the window, first cell top left
+  const float cell_w = instrument_width * scale;
+  const float cell_h = instrument_height * scale;
+  const float left = 0.5f * ((float)window_width - columns * cell_w);
+  const float top = 0.5f * ((float)window_height - rows * cell_h);
+  const int col = index % columns;
+  const int row = index / columns;
+  const float cx = left + (col + 0.5f) * cell_w;
+  const float cy = (float)window_height - (top + (row + 0.5f) * cell_h);
+
+  Placement p;
+  p.scale_x = cell_w / (float)window_width;
+  p.scale_y = cell_h / (float)window_height;
+  p.offset_x = cx / (float)window_width * 2.0f - 1.0f;
+  p.offset_y = cy / (float)window_height * 2.0f - 1.0f;
+  p.pixel_scale = scale;
+  return p;
+}
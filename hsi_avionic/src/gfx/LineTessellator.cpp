@@ -0,0 +1,191 @@
+#include "gfx/LineTessellator.hpp"
+
+#include <cmath>
+
+namespace {
+  constexpr float kPi = 3.1415926535f;
+
+  //AA fringe added outside the stroke, in pixels
+  constexpr float kFringe = 1.0f;
+
+  //"Uncapped" along/length values: the cap term in the shader saturates to 1
+  constexpr float kNoCapAlong = 1.0e4f;
+  constexpr float kNoCapLength = 1.0e6f;
+}
+
+void LineTessellator::setViewport(int width, int height) {
+  half_w_ = (float)width * 0.5f;
+  half_h_ = (float)height * 0.5f;
+}
+
+void LineTessellator::emit(std::vector<Vertex>& out, Point p, const uint8_t rgba[4],
+                           float side, float half_width, float along, float length) const {
+  out.push_back({ p.x / half_w_, p.y / half_h_, rgba[0], rgba[1], rgba[2], rgba[3],
+                  side, half_width, along, length });
+}
+
+void LineTessellator::segment(Point a, Point b, float half_width, bool cap_start, bool cap_end,
+                              const uint8_t rgba[4], std::vector<Vertex>& out) const {
+  const float dx = b.x - a.x;
+  const float dy = b.y - a.y;
+  const float len = std::sqrt(dx * dx + dy * dy);
+  if (len < 1e-4f) return;
+
+  const float ux = dx / len, uy = dy / len;
+  const float nx = -uy, ny = ux;
+  const float e = half_width + kFringe;
+
+  const float ext_a = cap_start ? kFringe : 0.0f;
+  const float ext_b = cap_end ? kFringe : 0.0f;
+
+  const float along_a = cap_start ? -ext_a : kNoCapAlong;
+  const float along_b = along_a + ext_a + len + ext_b;
+  const float length = cap_end ? along_b - ext_b : kNoCapLength;
+
+  const Point a0 = { a.x - ux * ext_a + nx * e, a.y - uy * ext_a + ny * e };
+  const Point a1 = { a.x - ux * ext_a - nx * e, a.y - uy * ext_a - ny * e };
+  const Point b0 = { b.x + ux * ext_b + nx * e, b.y + uy * ext_b + ny * e };
+  const Point b1 = { b.x + ux * ext_b - nx * e, b.y + uy * ext_b - ny * e };
+
+  emit(out, a0, rgba,  e, half_width, along_a, length);
+  emit(out, a1, rgba, -e, half_width, along_a, length);
+  emit(out, b0, rgba,  e, half_width, along_b, length);
+
+  emit(out, b0, rgba,  e, half_width, along_b, length);
+  emit(out, a1, rgba, -e, half_width, along_a, length);
+  emit(out, b1, rgba, -e, half_width, along_b, length);
+}
+
+void LineTessellator::fan(Point c, float angle0, float angle1, float half_width,
+                          const uint8_t rgba[4], std::vector<Vertex>& out) const {
+  const float e = half_width + kFringe;
+  const float sweep = angle1 - angle0;
+
+  //Keep the chord error under a quarter pixel
+  const float step = 2.0f * std::acos(std::fmax(0.0f, 1.0f - 0.25f / e));
+  int n = (int)std::ceil(std::fabs(sweep) / std::fmax(step, 0.05f));
+  if (n < 1) n = 1;
+
+  Point prev = { c.x + std::cos(angle0) * e, c.y + std::sin(angle0) * e };
+  for (int i = 1; i <= n; ++i) {
+    const float a = angle0 + sweep * (float)i / (float)n;
+    const Point p = { c.x + std::cos(a) * e, c.y + std::sin(a) * e };
+
+    emit(out, c, rgba, 0.0f, half_width, kNoCapAlong, kNoCapLength);
+    emit(out, prev, rgba, e, half_width, kNoCapAlong, kNoCapLength);
+    emit(out, p, rgba, e, half_width, kNoCapAlong, kNoCapLength);
+    prev = p;
+  }
+}
+
+void LineTessellator::join(Point c, Point dir_in, Point dir_out, float half_width, const Style& style,
+                           const uint8_t rgba[4], std::vector<Vertex>& out) const {
+  if ((dir_in.x == 0.0f && dir_in.y == 0.0f) || (dir_out.x == 0.0f && dir_out.y == 0.0f)) return;
+
+  const float cross = dir_in.x * dir_out.y - dir_in.y * dir_out.x;
+  const float dot = dir_in.x * dir_out.x + dir_in.y * dir_out.y;
+  if (std::fabs(cross) < 1e-4f && dot > 0.0f) return;   // collinear
+
+  //Outer side of the turn (left normal is (-y, x))
+  const float s = cross > 0.0f ? -1.0f : 1.0f;
+  const Point n_in = { -dir_in.y * s, dir_in.x * s };
+  const Point n_out = { -dir_out.y * s, dir_out.x * s };
+  const float e = half_width + kFringe;
+
+  if (style.join == Join::Round) {
+    float a0 = std::atan2(n_in.y, n_in.x);
+    float a1 = std::atan2(n_out.y, n_out.x);
+    float sweep = a1 - a0;
+    if (sweep > kPi) sweep -= 2.0f * kPi;
+    if (sweep < -kPi) sweep += 2.0f * kPi;
+    fan(c, a0, a0 + sweep, half_width, rgba, out);
+    return;
+  }
+
+  const Point p_in = { c.x + n_in.x * e, c.y + n_in.y * e };
+  const Point p_out = { c.x + n_out.x * e, c.y + n_out.y * e };
+
+  float mx = n_in.x + n_out.x;
+  float my = n_in.y + n_out.y;
+  const float mlen = std::sqrt(mx * mx + my * my);
+
+  bool miter = style.join == Join::Miter && mlen > 1e-4f;
+  float miter_scale = 0.0f;
+  if (miter) {
+    mx /= mlen;
+    my /= mlen;
+    miter_scale = 1.0f / (mx * n_in.x + my * n_in.y);
+    miter = miter_scale <= style.miter_limit;
+  }
+
+  if (miter) {
+    const Point m = { c.x + mx * e * miter_scale, c.y + my * e * miter_scale };
+    emit(out, c, rgba, 0.0f, half_width, kNoCapAlong, kNoCapLength);
+    emit(out, p_in, rgba, e, half_width, kNoCapAlong, kNoCapLength);
+    emit(out, m, rgba, e, half_width, kNoCapAlong, kNoCapLength);
+
+    emit(out, c, rgba, 0.0f, half_width, kNoCapAlong, kNoCapLength);
+    emit(out, m, rgba, e, half_width, kNoCapAlong, kNoCapLength);
+    emit(out, p_out, rgba, e, half_width, kNoCapAlong, kNoCapLength);
+  } else {
+    emit(out, c, rgba, 0.0f, half_width, kNoCapAlong, kNoCapLength);
+    emit(out, p_in, rgba, e, half_width, kNoCapAlong, kNoCapLength);
+    emit(out, p_out, rgba, e, half_width, kNoCapAlong, kNoCapLength);
+  }
+}
+
+void LineTessellator::polyline(const float* xy, int count, bool closed, const Style& style,
+                               const uint8_t rgba[4], std::vector<Vertex>& out) const {
+  if (count < 2) return;
+
+  const float hw = style.width_px * 0.5f;
+  const bool round_caps = style.cap == Cap::Round && !closed;
+  const int seg_count = closed ? count : count - 1;
+
+  auto point = [&](int i) { return toPixel(xy + 2 * (i % count)); };
+  auto direction = [&](int i) {
+    const Point a = point(i), b = point(i + 1);
+    const float dx = b.x - a.x, dy = b.y - a.y;
+    const float len = std::sqrt(dx * dx + dy * dy);
+    return len > 1e-4f ? Point{ dx / len, dy / len } : Point{ 0.0f, 0.0f };
+  };
+
+  for (int i = 0; i < seg_count; ++i) {
+    const bool cap_start = !closed && i == 0 && !round_caps;
+    const bool cap_end = !closed && i == seg_count - 1 && !round_caps;
+    segment(point(i), point(i + 1), hw, cap_start, cap_end, rgba, out);
+  }
+
+  const int first_join = closed ? 0 : 1;
+  const int last_join = closed ? count - 1 : count - 2;
+  for (int i = first_join; i <= last_join; ++i) {
+    const int prev = (i - 1 + count) % count;
+    join(point(i), direction(prev), direction(i), hw, style, rgba, out);
+  }
+
+  if (round_caps) {
+    const Point d0 = direction(0);
+    const Point d1 = direction(count - 2);
+    const float a0 = std::atan2(d0.x, -d0.y);       // left normal of first segment
+    const float a1 = std::atan2(-d1.x, d1.y);       // right normal of last segment
+    fan(point(0), a0, a0 + kPi, hw, rgba, out);
+    fan(point(count - 1), a1, a1 + kPi, hw, rgba, out);
+  }
+}
+
+void LineTessellator::lines(const float* xy, int count, const Style& style,
+                            const uint8_t rgba[4], std::vector<Vertex>& out) const {
+  for (int i = 0; i + 1 < count; i += 2) {
+    polyline(xy + 2 * i, 2, false, style, rgba, out);
+  }
+}
+
+void LineTessellator::triangles(const float* xy, int count, const uint8_t rgba[4],
+                                std::vector<Vertex>& out) const {
+  for (int i = 0; i + 2 < count; i += 3) {
+    for (int k = 0; k < 3; ++k) {
+      out.push_back({ xy[2 * (i + k)], xy[2 * (i + k) + 1], rgba[0], rgba[1], rgba[2], rgba[3],
+                      0.0f, kNoCapLength, kNoCapAlong, kNoCapLength });
+    }
+  }
+}
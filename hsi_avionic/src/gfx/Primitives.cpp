@@ -0,0 +1,227 @@
+#include "gfx/Primitives.hpp"
+#include "gfx/CommandList.hpp"
+#include "gfx/InstrumentView.hpp"
+#include "gfx/LineTessellator.hpp"
+#include "gfx/Shader.hpp"
+#include "swr/SoftRasterizer.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace {
+  SoftRasterizer* g_soft_target = nullptr;
+
+  std::unique_ptr<Shader> g_shader;
+  GLuint g_vao = 0;
+  GLuint g_vbo = 0;
+  GLsizeiptr g_vbo_capacity = 0;
+
+  int g_stream = -1;
+
+  LineTessellator g_tessellator;
+  std::vector<std::vector<LineTessellator::Vertex>> g_layers;   // whole frame, one batch per CommandList layer
+  std::vector<float> g_placed;                                  // input mapped by the instrument placement
+
+  //Recording thread: one draw per layer, vertices go out with the command list
+  void finishBatch() {
+    size_t total = 0;
+    for (const std::vector<LineTessellator::Vertex>& batch : g_layers) total += batch.size();
+    if (total == 0 || !g_shader) {
+      for (std::vector<LineTessellator::Vertex>& batch : g_layers) batch.clear();
+      return;
+    }
+
+    std::vector<unsigned char>& out = CommandList::stream(g_stream);
+    out.resize(total * sizeof(LineTessellator::Vertex));
+
+    const uint8_t current = CommandList::layer();
+    size_t first = 0;
+    for (size_t layer = 0; layer < g_layers.size(); ++layer) {
+      std::vector<LineTessellator::Vertex>& batch = g_layers[layer];
+      if (batch.empty()) continue;
+      std::memcpy(&out[first * sizeof(LineTessellator::Vertex)], batch.data(),
+                  batch.size() * sizeof(LineTessellator::Vertex));
+      CommandList::setLayer((uint8_t)layer);
+      CommandList::record(*g_shader, g_vao, GL_TRIANGLES, (int)first, (int)batch.size());
+      first += batch.size();
+      batch.clear();
+    }
+    CommandList::setLayer(current);
+  }
+
+  //GL thread: orphan the previous frame's storage; grow only when the batch outgrows it
+  void uploadBatch(const unsigned char* data, size_t size) {
+    if (!g_vbo) return;
+    const GLsizeiptr bytes = (GLsizeiptr)size;
+    if (bytes > g_vbo_capacity) g_vbo_capacity = bytes * 2;
+
+    glBindBuffer(GL_ARRAY_BUFFER, g_vbo);
+    glBufferData(GL_ARRAY_BUFFER, g_vbo_capacity, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, data);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+
+  uint8_t toByte(float v) {
+    if (v <= 0.0f) return 0;
+    if (v >= 1.0f) return 255;
+    return (uint8_t)(v * 255.0f + 0.5f);
+  }
+}
+
+bool Primitives::init(int width, int height) {
+  g_tessellator.setViewport(width, height);
+
+  const char* vs = R"(
+    #version 330 core
+    layout (location = 0) in vec2 aPos;
+    layout (location = 1) in vec4 aColor;
+    layout (location = 2) in vec4 aEdge;
+    out vec4 vColor;
+    out vec4 vEdge;
+    void main() {
+      vColor = aColor;
+      vEdge = aEdge;
+      gl_Position = vec4(aPos, 0.0, 1.0);
+    }
+  )";
+
+  //vEdge: x = distance from centerline, y = half width,
+  //       z = distance along the segment, w = segment length (px)
+  const char* fs = R"(
+    #version 330 core
+    in vec4 vColor;
+    in vec4 vEdge;
+    out vec4 FragColor;
+    void main() {
+      float side = clamp(vEdge.y - abs(vEdge.x) + 0.5, 0.0, 1.0);
+      float cap = clamp(min(vEdge.z, vEdge.w - vEdge.z) + 0.5, 0.0, 1.0);
+      FragColor = vec4(vColor.rgb, vColor.a * side * cap);
+    }
+  )";
+
+  g_shader.reset(new Shader());
+  if (!g_shader->build(vs, fs)) {
+    g_shader.reset();
+    return false;
+  }
+
+  glGenVertexArrays(1, &g_vao);
+  glGenBuffers(1, &g_vbo);
+
+  glBindVertexArray(g_vao);
+  glBindBuffer(GL_ARRAY_BUFFER, g_vbo);
+
+  const GLsizei stride = sizeof(LineTessellator::Vertex);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(LineTessellator::Vertex, x));
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(LineTessellator::Vertex, r));
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(LineTessellator::Vertex, side));
+  glEnableVertexAttribArray(2);
+
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+
+
+  g_stream = CommandList::addStream(uploadBatch);
+  CommandList::addFinishHook(finishBatch);
+
+  const uint16_t owner = CommandList::REMOTE_PRIMITIVES;
+  CommandList::exportShader(CommandList::remoteKey(owner, 1), g_shader.get());
+  CommandList::exportObject(CommandList::ObjectKind::VertexArray, CommandList::remoteKey(owner, 1), g_vao);
+  CommandList::exportStream(CommandList::remoteKey(owner, 1), g_stream);
+  return true;
+}
+
+void Primitives::shutdown() {
+  if (g_vbo) glDeleteBuffers(1, &g_vbo);
+  if (g_vao) glDeleteVertexArrays(1, &g_vao);
+  g_vbo = g_vao = 0;
+  g_vbo_capacity = 0;
+  g_shader.reset();
+  g_layers.clear();
+  g_stream = -1;
+}
+
+void Primitives::setViewport(int width, int height) {
+  g_tessellator.setViewport(width, height);
+}
+
+void Primitives::bindSoftwareTarget(SoftRasterizer* target) {
+  g_soft_target = target;
+}
+
+SoftRasterizer* Primitives::softwareTarget() {
+  return g_soft_target;
+}
+
+void Primitives::clear(float r, float g, float b) {
+  if (g_soft_target) {
+    g_soft_target->clear(r, g, b);
+    return;
+  }
+
+  for (std::vector<LineTessellator::Vertex>& batch : g_layers) batch.clear();
+  CommandList::setClearColor(r, g, b);
+}
+
+void Primitives::draw(const float* xy, int vertex_count, Mode mode,
+                      float r, float g, float b, float alpha, float line_width) {
+  if (vertex_count <= 0) return;
+
+  if (g_soft_target) {
+    switch (mode) {
+      case Mode::Lines:
+        g_soft_target->drawLines(xy, vertex_count, false, false, line_width, r, g, b, alpha);
+        break;
+      case Mode::LineStrip:
+        g_soft_target->drawLines(xy, vertex_count, true, false, line_width, r, g, b, alpha);
+        break;
+      case Mode::LineLoop:
+        g_soft_target->drawLines(xy, vertex_count, true, true, line_width, r, g, b, alpha);
+        break;
+      case Mode::Triangles:
+        g_soft_target->fillTriangles(xy, vertex_count, r, g, b, alpha);
+        break;
+    }
+    return;
+  }
+
+  //Placed into the instrument's cell of the window
+  const InstrumentView::Placement& view = InstrumentView::current();
+  if (!view.identity()) {
+    g_placed.resize((size_t)vertex_count * 2);
+    for (int i = 0; i < vertex_count; ++i) {
+      g_placed[i * 2] = view.x(xy[i * 2]);
+      g_placed[i * 2 + 1] = view.y(xy[i * 2 + 1]);
+    }
+    xy = g_placed.data();
+    line_width *= view.pixel_scale;
+  }
+
+  const uint8_t layer = CommandList::layer();
+  if (layer >= g_layers.size()) g_layers.resize((size_t)layer + 1);
+  std::vector<LineTessellator::Vertex>& batch = g_layers[layer];
+
+  const uint8_t rgba[4] = { toByte(r), toByte(g), toByte(b), toByte(alpha) };
+
+  LineTessellator::Style style;
+  style.width_px = line_width;
+
+  switch (mode) {
+    case Mode::Lines:
+      g_tessellator.lines(xy, vertex_count, style, rgba, batch);
+      break;
+    case Mode::LineStrip:
+      g_tessellator.polyline(xy, vertex_count, false, style, rgba, batch);
+      break;
+    case Mode::LineLoop:
+      g_tessellator.polyline(xy, vertex_count, true, style, rgba, batch);
+      break;
+    case Mode::Triangles:
+      g_tessellator.triangles(xy, vertex_count, rgba, batch);
+      break;
+  }
+}
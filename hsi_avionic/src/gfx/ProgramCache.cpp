@@ -0,0 +1,206 @@
+#include "gfx/ProgramCache.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+//ARB_get_program_binary (core in 4.1); the bundled glad is a plain 3.3 build
+#define HSI_GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define HSI_GL_PROGRAM_BINARY_LENGTH           0x8741
+#define HSI_GL_NUM_PROGRAM_BINARY_FORMATS      0x87FE
+
+namespace {
+  typedef void (APIENTRYP GetProgramBinaryProc)(GLuint, GLsizei, GLsizei*, GLenum*, void*);
+  typedef void (APIENTRYP ProgramBinaryProc)(GLuint, GLenum, const void*, GLsizei);
+  typedef void (APIENTRYP ProgramParameteriProc)(GLuint, GLenum, GLint);
+
+  GetProgramBinaryProc g_get_program_binary = nullptr;
+  ProgramBinaryProc g_program_binary = nullptr;
+  ProgramParameteriProc g_program_parameteri = nullptr;
+
+  bool g_enabled = false;
+  std::string g_directory;
+  std::string g_driver;
+
+  int g_hits = 0;
+  int g_misses = 0;
+  int g_rejected = 0;
+  int g_stored = 0;
+
+  constexpr uint32_t kMagic = 0x42505348;   // "HSPB"
+  constexpr uint32_t kFileVersion = 1;
+
+  struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;
+    uint32_t length;
+  };
+
+  uint64_t fnv1a(uint64_t h, const char* s) {
+    for (; *s; ++s) {
+      h ^= (unsigned char)*s;
+      h *= 0x100000001b3ull;
+    }
+    h ^= 0xff;   // separator so "ab"+"c" != "a"+"bc"
+    h *= 0x100000001b3ull;
+    return h;
+  }
+
+  uint64_t cacheKey(const char* vs_src, const char* fs_src) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    h = fnv1a(h, vs_src);
+    h = fnv1a(h, fs_src);
+    h = fnv1a(h, g_driver.c_str());
+    return h;
+  }
+
+  std::string cachePath(uint64_t key) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+    return g_directory + "/" + name;
+  }
+
+  const char* glString(GLenum name) {
+    const GLubyte* s = glGetString(name);
+    return s ? (const char*)s : "";
+  }
+
+  bool hasExtension(const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i) {
+      const GLubyte* ext = glGetStringi(GL_EXTENSIONS, (GLuint)i);
+      if (ext && std::strcmp((const char*)ext, name) == 0) return true;
+    }
+    return false;
+  }
+}
+
+void ProgramCache::init(GLADloadproc load, const std::string& directory) {
+  g_enabled = false;
+  g_directory = directory;
+
+  GLint major = 0, minor = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &major);
+  glGetIntegerv(GL_MINOR_VERSION, &minor);
+  const bool core41 = major > 4 || (major == 4 && minor >= 1);
+  if (!core41 && !hasExtension("GL_ARB_get_program_binary")) return;
+
+  g_get_program_binary = (GetProgramBinaryProc)load("glGetProgramBinary");
+  g_program_binary = (ProgramBinaryProc)load("glProgramBinary");
+  g_program_parameteri = (ProgramParameteriProc)load("glProgramParameteri");
+  if (!g_get_program_binary || !g_program_binary || !g_program_parameteri) return;
+
+  GLint formats = 0;
+  glGetIntegerv(HSI_GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+  if (formats <= 0) return;
+
+  std::error_code ec;
+  std::filesystem::create_directories(g_directory, ec);
+  if (ec) {
+    std::cerr << "Program cache disabled, cannot create " << g_directory << ": " << ec.message() << "\n";
+    return;
+  }
+
+  g_driver = std::string(glString(GL_VENDOR)) + "|" + glString(GL_RENDERER) + "|" + glString(GL_VERSION);
+  g_enabled = true;
+}
+
+bool ProgramCache::enabled() {
+  return g_enabled;
+}
+
+GLuint ProgramCache::load(const char* vs_src, const char* fs_src) {
+  if (!g_enabled) return 0;
+
+  const uint64_t key = cacheKey(vs_src, fs_src);
+  std::ifstream in(cachePath(key), std::ios::binary);
+  if (!in) {
+    ++g_misses;
+    return 0;
+  }
+
+  FileHeader header{};
+  in.read((char*)&header, sizeof(header));
+  if (!in || header.magic != kMagic || header.version != kFileVersion ||
+      header.key != key || header.length == 0) {
+    ++g_rejected;
+    return 0;
+  }
+
+  std::vector<char> binary(header.length);
+  in.read(binary.data(), (std::streamsize)binary.size());
+  if (!in) {
+    ++g_rejected;
+    return 0;
+  }
+
+  const GLuint program = glCreateProgram();
+  g_program_binary(program, (GLenum)header.format, binary.data(), (GLsizei)binary.size());
+
+  //Drivers reject binaries from other builds; fall back to source
+  GLint ok = 0;
+  glGetProgramiv(program, GL_LINK_STATUS, &ok);
+  if (!ok) {
+    glDeleteProgram(program);
+    ++g_rejected;
+    return 0;
+  }
+
+  ++g_hits;
+  return program;
+}
+
+void ProgramCache::prepare(GLuint program) {
+  if (g_enabled) g_program_parameteri(program, HSI_GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+void ProgramCache::store(GLuint program, const char* vs_src, const char* fs_src) {
+  if (!g_enabled) return;
+
+  GLint length = 0;
+  glGetProgramiv(program, HSI_GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) return;
+
+  std::vector<char> binary((size_t)length);
+  GLenum format = 0;
+  GLsizei written = 0;
+  g_get_program_binary(program, length, &written, &format, binary.data());
+  if (written <= 0) return;
+
+  FileHeader header{ kMagic, kFileVersion, cacheKey(vs_src, fs_src), (uint32_t)format, (uint32_t)written };
+
+  //Write beside the target and rename so a crash never leaves a torn entry
+  const std::string path = cachePath(header.key);
+  const std::string tmp = path + ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (!out) return;
+    out.write((const char*)&header, sizeof(header));
+    out.write(binary.data(), written);
+    if (!out) return;
+  }
+
+  std::error_code ec;
+  std::filesystem::rename(tmp, path, ec);
+  if (ec) {
+    std::filesystem::remove(tmp, ec);
+    return;
+  }
+  ++g_stored;
+}
+
+void ProgramCache::report() {
+  if (!g_enabled) {
+    std::cout << "Program cache: unavailable (no program binary formats)\n";
+    return;
+  }
+  std::cout << "Program cache: " << g_hits << " hits, " << g_misses << " misses, "
+            << g_rejected << " rejected, " << g_stored << " stored (" << g_directory << ")\n";
+}
@@ -0,0 +1,70 @@
+#include "gfx/RenderTarget.hpp"
+
+#include <iostream>
+
+void RenderTarget::bind(const Format& format, int window_width, int window_height) {
+  window_width_ = window_width;
+  window_height_ = window_height;
+  offscreen_ = true;
+
+  if (format != format_) allocate(format);
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo_[0]);
+  glViewport(0, 0, format_.width, format_.height);
+}
+
+void RenderTarget::allocate(const Format& format) {
+  format_ = format;
+  if (!fbo_[0]) {
+    glGenFramebuffers(2, fbo_);
+    glGenRenderbuffers(2, color_);
+  }
+
+  for (int i = 0; i < 2; ++i) {
+    //MSAA frames are resolved here when they are scaled
+    if (i == 1 && format.samples == 0) break;
+
+    glBindRenderbuffer(GL_RENDERBUFFER, color_[i]);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, i == 0 ? format.samples : 0, GL_RGBA8,
+                                     format.width, format.height);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_[i]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_[i]);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+      std::cerr << "Render target " << format.width << "x" << format.height << " with "
+                << format.samples << " samples is incomplete\n";
+    }
+  }
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+}
+
+void RenderTarget::present() {
+  if (!offscreen_) return;
+
+  const int w = format_.width;
+  const int h = format_.height;
+  const bool scaled = w != window_width_ || h != window_height_;
+
+  //Multisampled blits cannot scale: resolve at the internal size first
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo_[0]);
+  if (format_.samples > 0 && scaled) {
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo_[1]);
+    glBlitFramebuffer(0, 0, w, h, 0, 0, w, h, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo_[1]);
+  }
+
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+  glBlitFramebuffer(0, 0, w, h, 0, 0, window_width_, window_height_, GL_COLOR_BUFFER_BIT,
+                    scaled ? GL_LINEAR : GL_NEAREST);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glViewport(0, 0, window_width_, window_height_);
+}
+
+void RenderTarget::shutdown() {
+  if (fbo_[0]) {
+    glDeleteFramebuffers(2, fbo_);
+    glDeleteRenderbuffers(2, color_);
+  }
+  fbo_[0] = fbo_[1] = 0;
+  color_[0] = color_[1] = 0;
+  format_ = Format();
+  offscreen_ = false;
+}
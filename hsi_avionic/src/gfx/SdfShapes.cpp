@@ -0,0 +1,312 @@
+#include "gfx/SdfShapes.hpp"
+#include "gfx/CommandList.hpp"
+#include "gfx/FrameUniforms.hpp"
+#include "gfx/InstrumentView.hpp"
+#include "gfx/Primitives.hpp"
+#include "gfx/Shader.hpp"
+#include "swr/SoftRasterizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+  constexpr float kPi = 3.1415926535f;
+
+  enum ShapeKind { KIND_RING = 0, KIND_TICKS = 1 };
+
+  //One quad per shape, window pixels
+  struct Instance {
+    float shape[4];           // centre xy, radius (outer for ticks), ring half line width
+    float color[4];
+    float tick_len[4];        // per tick class
+    float tick_half_width[4];
+    float extra[4];           // heading deg, kind, quad half extent, -
+  };
+
+  std::unique_ptr<Shader> g_shader;
+  GLuint g_vao = 0;
+  GLuint g_vbo = 0;
+  GLuint g_ibo = 0;
+
+  float g_width = 800.0f;
+  float g_height = 600.0f;
+
+  //Whole frame, one queue per CommandList layer, handed to the frame's stream on finish
+  std::vector<std::vector<Instance>> g_layers;
+  int g_stream = -1;
+
+  void bindInstances(GLuint buffer, int first) {
+    const size_t base = (size_t)first * sizeof(Instance);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    for (GLuint i = 0; i < 5; ++i) {
+      glVertexAttribPointer(i, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(base + i * 4 * sizeof(float)));
+    }
+  }
+
+  //Recording thread: one instanced draw per layer
+  void finishInstances() {
+    size_t total = 0;
+    for (const std::vector<Instance>& queue : g_layers) total += queue.size();
+    if (total == 0 || !g_shader) {
+      for (std::vector<Instance>& queue : g_layers) queue.clear();
+      return;
+    }
+
+    std::vector<unsigned char>& out = CommandList::stream(g_stream);
+    out.resize(total * sizeof(Instance));
+
+    const uint8_t current = CommandList::layer();
+    size_t first = 0;
+    for (size_t layer = 0; layer < g_layers.size(); ++layer) {
+      std::vector<Instance>& queue = g_layers[layer];
+      if (queue.empty()) continue;
+      std::memcpy(&out[first * sizeof(Instance)], queue.data(), queue.size() * sizeof(Instance));
+      CommandList::setLayer((uint8_t)layer);
+      CommandList::Command& cmd = CommandList::record(*g_shader, g_vao, GL_TRIANGLES, (int)first, (int)queue.size());
+      cmd.index_count = 6;
+      cmd.instance_buffer = g_vbo;
+      cmd.bind_instances = bindInstances;
+      first += queue.size();
+      queue.clear();
+    }
+    CommandList::setLayer(current);
+  }
+
+  void uploadInstances(const unsigned char* data, size_t bytes) {
+    if (!g_vbo) return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, g_vbo);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)bytes, data, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+
+  //Instance at the placed centre, queued in the current layer
+  Instance& queueShape(float cx, float cy, float& scale, float& pixel_scale) {
+    const InstrumentView::Placement& view = InstrumentView::current();
+    scale = view.scale_y * g_height * 0.5f;
+    pixel_scale = view.pixel_scale;
+
+    const uint8_t layer = CommandList::layer();
+    if (layer >= g_layers.size()) g_layers.resize((size_t)layer + 1);
+    g_layers[layer].push_back(Instance());
+    Instance& s = g_layers[layer].back();
+    s.shape[0] = (view.x(cx) * 0.5f + 0.5f) * g_width;
+    s.shape[1] = (view.y(cy) * 0.5f + 0.5f) * g_height;
+    return s;
+  }
+
+  //CPU fallback: outlines for the software rasterizer
+  void softRing(SoftRasterizer* soft, float cx, float cy, float radius, float line_width,
+                float r, float g, float b, float alpha) {
+    const float aspect_fix = g_height / g_width;
+    const int segments = std::max(12, std::min(200, (int)(radius * g_height)));
+
+    std::vector<float> xy;
+    xy.reserve(segments * 2);
+    for (int i = 0; i < segments; ++i) {
+      const float a = (float)i / (float)segments * 2.0f * kPi;
+      xy.push_back(cx + std::cos(a) * radius * aspect_fix);
+      xy.push_back(cy + std::sin(a) * radius);
+    }
+    soft->drawLines(xy.data(), segments, true, true, line_width, r, g, b, alpha);
+  }
+
+  void softTicks(SoftRasterizer* soft, float cx, float cy, float outer_radius,
+                 const float lengths[], const float widths[], float heading_deg, float r, float g, float b) {
+    const float aspect_fix = g_height / g_width;
+    const float rotation_deg = -heading_deg;
+    std::vector<float> xy[SdfShapes::TICK_CLASS_COUNT];
+
+    for (int deg = 0; deg < 360; deg += 5) {
+      const int cls = deg % 90 == 0 ? SdfShapes::TICK_CARDINAL
+                    : deg % 30 == 0 ? SdfShapes::TICK_MAJOR
+                    : deg % 10 == 0 ? SdfShapes::TICK_MEDIUM
+                    : SdfShapes::TICK_MINOR;
+      const float a = ((float)deg + rotation_deg) * kPi / 180.0f;
+      const float inner = outer_radius - lengths[cls];
+
+      xy[cls].insert(xy[cls].end(), {
+        cx + std::cos(a) * outer_radius * aspect_fix, cy + std::sin(a) * outer_radius,
+        cx + std::cos(a) * inner * aspect_fix,        cy + std::sin(a) * inner
+      });
+    }
+
+    for (int cls = 0; cls < SdfShapes::TICK_CLASS_COUNT; ++cls) {
+      soft->drawLines(xy[cls].data(), (int)(xy[cls].size() / 2), false, false, widths[cls], r, g, b, 1.0f);
+    }
+  }
+}
+
+bool SdfShapes::init(int width, int height) {
+  setViewport(width, height);
+
+  const std::string vs = std::string("#version 330 core\n") + FrameUniforms::GLSL_BLOCK + R"(
+    layout (location = 0) in vec4 aShape;
+    layout (location = 1) in vec4 aColor;
+    layout (location = 2) in vec4 aTickLen;
+    layout (location = 3) in vec4 aTickHalfWidth;
+    layout (location = 4) in vec4 aExtra;
+    flat out vec4 vShape;
+    flat out vec4 vColor;
+    flat out vec4 vTickLen;
+    flat out vec4 vTickHalfWidth;
+    flat out vec4 vExtra;
+    void main() {
+      vShape = aShape;
+      vColor = aColor;
+      vTickLen = aTickLen;
+      vTickHalfWidth = aTickHalfWidth;
+      vExtra = aExtra;
+
+      //Corners 0-3 of the square around the shape, pixels to NDC
+      int c = gl_VertexID;
+      vec2 corner = vec2(c == 1 || c == 2 ? 1.0 : -1.0, c >= 2 ? 1.0 : -1.0);
+      vec2 p = aShape.xy + corner * aExtra.z;
+      gl_Position = vec4(p * uViewport.zw * 2.0 - 1.0, 0.0, 1.0);
+    }
+  )";
+
+  const char* fs = R"(
+    #version 330 core
+    flat in vec4 vShape;
+    flat in vec4 vColor;
+    flat in vec4 vTickLen;
+    flat in vec4 vTickHalfWidth;
+    flat in vec4 vExtra;
+    out vec4 FragColor;
+
+    float tickCoverage(vec2 p) {
+      vec2 d = p - vShape.xy;
+      //Rose turns with the instrument heading
+      float heading = vExtra.x;
+      float phi = degrees(atan(d.y, d.x)) + heading;
+      float k = floor(phi / 5.0 + 0.5) * 5.0;
+      int deg = int(mod(k, 360.0) + 0.5) % 360;
+
+      float len = deg % 90 == 0 ? vTickLen.x : deg % 30 == 0 ? vTickLen.y
+                : deg % 10 == 0 ? vTickLen.z : vTickLen.w;
+      float hw = deg % 90 == 0 ? vTickHalfWidth.x : deg % 30 == 0 ? vTickHalfWidth.y
+               : deg % 10 == 0 ? vTickHalfWidth.z : vTickHalfWidth.w;
+
+      float a = radians(k - heading);
+      vec2 u = vec2(cos(a), sin(a));
+      float along = dot(d, u);
+      float side = abs(d.x * u.y - d.y * u.x);
+
+      float cov_side = clamp(hw - side + 0.5, 0.0, 1.0);
+      float cov_cap = clamp(min(along - (vShape.z - len), vShape.z - along) + 0.5, 0.0, 1.0);
+      return cov_side * cov_cap;
+    }
+
+    void main() {
+      vec2 p = gl_FragCoord.xy;
+
+      float coverage;
+      if (vExtra.y < 0.5) {
+        float d = abs(length(p - vShape.xy) - vShape.z);
+        coverage = clamp(vShape.w - d + 0.5, 0.0, 1.0);
+      } else {
+        coverage = tickCoverage(p);
+      }
+
+      float alpha = vColor.a * coverage;
+      if (alpha <= 0.0) discard;
+      FragColor = vec4(vColor.rgb, alpha);
+    }
+  )";
+
+  g_shader.reset(new Shader());
+  if (!g_shader->build(vs.c_str(), fs)) {
+    g_shader.reset();
+    return false;
+  }
+
+  static const GLubyte kIndices[6] = { 0, 1, 2, 0, 2, 3 };
+
+  glGenVertexArrays(1, &g_vao);
+  glGenBuffers(1, &g_vbo);
+  glGenBuffers(1, &g_ibo);
+
+  glBindVertexArray(g_vao);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_ibo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(kIndices), kIndices, GL_STATIC_DRAW);
+
+  glBindBuffer(GL_ARRAY_BUFFER, g_vbo);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(Instance), nullptr, GL_STREAM_DRAW);
+  for (GLuint i = 0; i < 5; ++i) {
+    glEnableVertexAttribArray(i);
+    glVertexAttribDivisor(i, 1);
+  }
+  bindInstances(g_vbo, 0);
+
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  g_stream = CommandList::addStream(uploadInstances);
+  CommandList::addFinishHook(finishInstances);
+
+  const uint16_t owner = CommandList::REMOTE_SDF_SHAPES;
+  CommandList::exportShader(CommandList::remoteKey(owner, 1), g_shader.get());
+  CommandList::exportObject(CommandList::ObjectKind::VertexArray, CommandList::remoteKey(owner, 1), g_vao);
+  CommandList::exportObject(CommandList::ObjectKind::Buffer, CommandList::remoteKey(owner, 1), g_vbo);
+  CommandList::exportBinder(CommandList::remoteKey(owner, 1), bindInstances);
+  CommandList::exportStream(CommandList::remoteKey(owner, 1), g_stream);
+
+  return true;
+}
+
+void SdfShapes::shutdown() {
+  if (g_vbo) glDeleteBuffers(1, &g_vbo);
+  if (g_ibo) glDeleteBuffers(1, &g_ibo);
+  if (g_vao) glDeleteVertexArrays(1, &g_vao);
+  g_vbo = g_ibo = g_vao = 0;
+  g_shader.reset();
+  g_layers.clear();
+  g_stream = -1;
+}
+
+void SdfShapes::setViewport(int width, int height) {
+  g_width = (float)width;
+  g_height = (float)height;
+}
+
+void SdfShapes::ring(float cx, float cy, float radius, float line_width,
+                     float r, float g, float b, float alpha) {
+  if (SoftRasterizer* soft = Primitives::softwareTarget()) {
+    softRing(soft, cx, cy, radius, line_width, r, g, b, alpha);
+    return;
+  }
+
+  float scale, pixel_scale;
+  Instance& s = queueShape(cx, cy, scale, pixel_scale);
+  s.shape[2] = radius * scale;
+  s.shape[3] = line_width * 0.5f * pixel_scale;
+  s.color[0] = r; s.color[1] = g; s.color[2] = b; s.color[3] = alpha;
+  s.extra[1] = (float)KIND_RING;
+  s.extra[2] = s.shape[2] + s.shape[3] + 1.0f;
+}
+
+void SdfShapes::ticks(float cx, float cy, float outer_radius,
+                      const float lengths[TICK_CLASS_COUNT], const float widths[TICK_CLASS_COUNT],
+                      float heading_deg, float r, float g, float b) {
+  if (SoftRasterizer* soft = Primitives::softwareTarget()) {
+    softTicks(soft, cx, cy, outer_radius, lengths, widths, heading_deg, r, g, b);
+    return;
+  }
+
+  float scale, pixel_scale;
+  Instance& s = queueShape(cx, cy, scale, pixel_scale);
+  s.shape[2] = outer_radius * scale;
+  for (int i = 0; i < TICK_CLASS_COUNT; ++i) {
+    s.tick_len[i] = lengths[i] * scale;
+    s.tick_half_width[i] = widths[i] * 0.5f * pixel_scale;
+  }
+  s.color[0] = r; s.color[1] = g; s.color[2] = b; s.color[3] = 1.0f;
+  s.extra[0] = heading_deg;
+  s.extra[1] = (float)KIND_TICKS;
+  s.extra[2] = s.shape[2] + 1.0f;
+}
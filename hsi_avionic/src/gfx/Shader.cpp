@@ -1,6 +1,13 @@
 #include "gfx/Shader.hpp"
+#include "gfx/FrameUniforms.hpp"
+#include "gfx/ProgramCache.hpp"
+#include "core/StartupTrace.hpp"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 
+GLuint Shader::bound_program_ = 0;
+
 static GLuint compile_shader(GLenum type, const char* src) {
   GLuint s = glCreateShader(type);
   glShaderSource(s, 1, &src, nullptr);
@@ -19,15 +26,24 @@ static GLuint compile_shader(GLenum type, const char* src) {
 }
 
 Shader::~Shader() {
-  if (program_id_) glDeleteProgram(program_id_);
+  if (!program_id_) return;
+  if (bound_program_ == program_id_) bound_program_ = 0;
+  glDeleteProgram(program_id_);
 }
 
 bool Shader::build(const char* vs_src, const char* fs_src) {
+  StartupTrace::Scope scope("shader_build", "cache");
+
+  program_id_ = ProgramCache::load(vs_src, fs_src);
+  if (program_id_) return finishLink();
+  scope.setDetail("compile");
+
   GLuint vs = compile_shader(GL_VERTEX_SHADER, vs_src);
   GLuint fs = compile_shader(GL_FRAGMENT_SHADER, fs_src);
   if (!vs || !fs) return false;
 
   program_id_ = glCreateProgram();
+  ProgramCache::prepare(program_id_);
   glAttachShader(program_id_, vs);
   glAttachShader(program_id_, fs);
   glLinkProgram(program_id_);
@@ -45,9 +61,58 @@ bool Shader::build(const char* vs_src, const char* fs_src) {
     program_id_ = 0;
     return false;
   }
+
+  ProgramCache::store(program_id_, vs_src, fs_src);
+  return finishLink();
+}
+
+bool Shader::finishLink() {
+  reflectUniforms();
+
+  //Programs that declare the shared per-frame block read it from one binding
+  const GLuint block = glGetUniformBlockIndex(program_id_, FrameUniforms::BLOCK_NAME);
+  if (block != GL_INVALID_INDEX) {
+    glUniformBlockBinding(program_id_, block, FrameUniforms::BINDING);
+  }
   return true;
 }
 
+void Shader::reflectUniforms() {
+  uniforms_.clear();
+
+  GLint count = 0;
+  glGetProgramiv(program_id_, GL_ACTIVE_UNIFORMS, &count);
+
+  char name[256];
+  for (GLint i = 0; i < count; ++i) {
+    GLsizei length = 0;
+    GLint size = 0;
+    GLenum type = 0;
+    glGetActiveUniform(program_id_, (GLuint)i, sizeof(name), &length, &size, &type, name);
+
+    //Block members have no location
+    const GLint location = glGetUniformLocation(program_id_, name);
+    if (location < 0) continue;
+
+    //Arrays are reported as "name[0]"
+    if (length > 3 && std::strcmp(name + length - 3, "[0]") == 0) name[length - 3] = '\0';
+
+    uniforms_.push_back({ name, location });
+  }
+
+  std::sort(uniforms_.begin(), uniforms_.end(),
+            [](const UniformEntry& a, const UniformEntry& b) { return a.name < b.name; });
+}
+
+GLint Shader::uniform(const char* name) const {
+  auto it = std::lower_bound(uniforms_.begin(), uniforms_.end(), name,
+                             [](const UniformEntry& e, const char* n) { return e.name.compare(n) < 0; });
+  if (it == uniforms_.end() || it->name != name) return -1;
+  return it->location;
+}
+
 void Shader::use() const {
+  if (bound_program_ == program_id_) return;
   glUseProgram(program_id_);
+  bound_program_ = program_id_;
 }
@@ -1,54 +1,189 @@
 #include "gfx/TtfTextRenderer.hpp"
+#include "gfx/CommandList.hpp"
+#include "gfx/InstrumentView.hpp"
+#include "gfx/Primitives.hpp"
+#include "gfx/BakedFontFile.hpp"
+#include "swr/SoftRasterizer.hpp"
+#include "core/StartupTrace.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <memory>
 
-#define STB_TRUETYPE_IMPLEMENTATION
-#include "stb/stb_truetype.h"
+static_assert(sizeof(TtfTextRenderer::GlyphInstance) == 16, "GlyphInstance must stay 16 bytes");
 
-#include <fstream>
-#include <vector>
-#include <iostream>
-#include <cstring>
-#include <cmath>
+namespace {
+  //Glyph positions are stored as snorm16 over [-POS_RANGE, POS_RANGE] NDC so
+  //text slightly off screen keeps its shape; UVs as unorm16 page coordinates
+  constexpr float POS_RANGE = 2.0f;
 
-//GL shader utils
-static GLuint compileShader(GLenum type, const char* src) {
-  GLuint shader = glCreateShader(type);
-  glShaderSource(shader, 1, &src, nullptr);
-  glCompileShader(shader);
+  //Every font shares the two programs, so sorted text draws never switch
+  //program between fonts; freed by TtfTextRenderer::shutdownShared()
+  std::unique_ptr<Shader> g_shader;
+  std::unique_ptr<Shader> g_pull_shader;
 
-  GLint ok = 0;
-  glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
-  if (ok) return shader;
+  int16_t packPos(float v) {
+    const float n = std::min(std::max(v / POS_RANGE, -1.0f), 1.0f);
+    return (int16_t)std::lrint(n * 32767.0f);
+  }
 
-  char log[1024];
-  glGetShaderInfoLog(shader, 1024, nullptr, log);
-  std::cerr << "TTF shader compile error:\n" << log << "\n";
+  uint16_t packUv(float v) {
+    return (uint16_t)std::lrint(std::min(std::max(v, 0.0f), 1.0f) * 65535.0f);
+  }
 
-  glDeleteShader(shader);
-  return 0;
-}
+  //Quads are axis-aligned here; rotation is applied with uTransform
+  void appendQuads(const std::vector<FontAtlas::GlyphQuad>& quads, int page,
+                   std::vector<TtfTextRenderer::GlyphInstance>& out) {
+    for (const FontAtlas::GlyphQuad& q : quads) {
+      if (q.page != page) continue;
+      out.push_back({
+        { packPos(q.px[0]), packPos(q.py[0]), packPos(q.px[2]), packPos(q.py[2]) },
+        { packUv(q.u0), packUv(q.v0), packUv(q.u1), packUv(q.v1) }
+      });
+    }
+  }
+
+  void transformQuads(std::vector<FontAtlas::GlyphQuad>& quads, float cos_a, float sin_a, float tx, float ty) {
+    for (FontAtlas::GlyphQuad& q : quads) {
+      for (int i = 0; i < 4; ++i) {
+        const float x = q.px[i], y = q.py[i];
+        q.px[i] = x * cos_a - y * sin_a + tx;
+        q.py[i] = x * sin_a + y * cos_a + ty;
+      }
+    }
+  }
+
+  //Two triangles over corners 0-1-2-3, shared by every font
+  GLuint sharedQuadIndexBuffer() {
+    static GLuint ibo = 0;
+    if (!ibo) {
+      static const GLubyte kIndices[6] = { 0, 1, 2, 0, 2, 3 };
+      glGenBuffers(1, &ibo);
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+      glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(kIndices), kIndices, GL_STATIC_DRAW);
+    }
+    return ibo;
+  }
 
-static bool readFileBytes(const std::string& path, std::vector<unsigned char>& out) {
-  std::ifstream f(path, std::ios::binary);
-  if (!f) return false;
+  //Points the per-instance attributes at the first instance of a range
+  void bindInstances(GLuint vbo, int first) {
+    const size_t base = (size_t)first * sizeof(TtfTextRenderer::GlyphInstance);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glVertexAttribPointer(0, 4, GL_SHORT, GL_TRUE, sizeof(TtfTextRenderer::GlyphInstance), (void*)base);
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(TtfTextRenderer::GlyphInstance),
+                          (void*)(base + offsetof(TtfTextRenderer::GlyphInstance, uv)));
+  }
 
-  f.seekg(0, std::ios::end);
-  const auto size = static_cast<size_t>(f.tellg());
-  f.seekg(0, std::ios::beg);
+  void setupTextVertexArray(GLuint vao, GLuint vbo, GLenum usage) {
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sharedQuadIndexBuffer());
 
-  out.resize(size);
-  f.read(reinterpret_cast<char*>(out.data()), static_cast<std::streamsize>(size));
-  return true;
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, 0, nullptr, usage);
+
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(0, 1);
+    glVertexAttribDivisor(1, 1);
+    bindInstances(vbo, 0);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
 }
 
 bool TtfTextRenderer::buildShader() {
   static const char* kVs = R"(
     #version 330 core
-    layout (location=0) in vec2 aPos;
-    layout (location=1) in vec2 aUV;
+    layout (location=0) in vec4 aRect;   // x0, y0, x1, y1 / POS_RANGE
+    layout (location=1) in vec4 aUV;     // u0, v0, u1, v1
+    uniform vec4 uTransform;   // cos, sin, translation
+    uniform vec4 uPlacement;   // instrument scale, offset
+    out vec2 vUV;
+    void main() {
+      //Corners 0-3: (x0,y0) (x1,y0) (x1,y1) (x0,y1)
+      int c = gl_VertexID;
+      bvec2 hi = bvec2(c == 1 || c == 2, c >= 2);
+      vec2 pos = vec2(hi.x ? aRect.z : aRect.x, hi.y ? aRect.w : aRect.y) * 2.0;
+      vUV = vec2(hi.x ? aUV.z : aUV.x, hi.y ? aUV.w : aUV.y);
+
+      vec2 p = vec2(pos.x * uTransform.x - pos.y * uTransform.y,
+                    pos.x * uTransform.y + pos.y * uTransform.x) + uTransform.zw;
+      gl_Position = vec4(p * uPlacement.xy + uPlacement.zw, 0.0, 1.0);
+    }
+  )";
+
+  static const char* kPullVs = R"(
+    #version 330 core
+    uniform samplerBuffer uMetrics;    // per code: (x0, y0, x1, y1) (xoff, yoff, xadvance, -)
+    uniform usamplerBuffer uCodes;     // per glyph: code point - 32 | index in string << 8 | string << 16
+    uniform samplerBuffer uStrings;    // per string: transform, color + alignment, placement, glyph count
+    uniform vec4 uAtlas;               // width, height, NDC per atlas pixel, FontAtlas::kScale
     out vec2 vUV;
+    flat out vec3 vColor;
+    const int kCorners[6] = int[6](0, 1, 2, 0, 2, 3);
+
     void main() {
-      vUV = aUV;
-      gl_Position = vec4(aPos, 0.0, 1.0);
+      int index = gl_VertexID / 6;
+      int c = kCorners[gl_VertexID % 6];
+
+      uint word = texelFetch(uCodes, index).r;
+      int glyph = int((word >> 8) & 0xFFu);
+      int str = int(word >> 16) * 4;
+      vec4 transform = texelFetch(uStrings, str);        // cos, sin, anchor
+      vec4 style = texelFetch(uStrings, str + 1);        // color, alignment
+      vec4 placement = texelFetch(uStrings, str + 2);    // instrument scale, offset
+      int count = int(texelFetch(uStrings, str + 3).x);
+      int first = index - glyph;
+      int alignment = int(style.w);
+
+      //Pen position of this glyph and extents of the whole string (FontAtlas::measure)
+      float pen = 0.0;
+      float glyph_pen = 0.0;
+      vec4 box = vec4(0.0);
+      vec4 off = vec4(0.0);
+      vec2 lo = vec2(1e9);
+      vec2 hi = vec2(-1e9);
+      for (int i = 0; i < count; ++i) {
+        int code = int(texelFetch(uCodes, first + i).r & 0xFFu);
+        vec4 b = texelFetch(uMetrics, code * 2);
+        vec4 o = texelFetch(uMetrics, code * 2 + 1);
+        if (i == glyph) { glyph_pen = pen; box = b; off = o; }
+
+        float gx0 = pen + o.x;
+        float gy0 = -o.y;
+        lo = min(lo, vec2(gx0, gy0 - (b.w - b.y)));
+        hi = max(hi, vec2(gx0 + (b.z - b.x), gy0));
+        pen += o.z;
+      }
+
+      //Corners 0-3: (x0,y0) (x1,y0) (x1,y1) (x0,y1)
+      bvec2 far = bvec2(c == 1 || c == 2, c >= 2);
+      float x0 = glyph_pen + off.x;
+      float y0 = -off.y;
+      vec2 g = vec2(far.x ? x0 + (box.z - box.x) : x0, far.y ? y0 - (box.w - box.y) : y0);
+      vUV = vec2(far.x ? box.z : box.x, far.y ? box.w : box.y) / uAtlas.xy;
+      vColor = style.rgb;
+      float kScale = uAtlas.z;
+
+      //Same placement as FontAtlas::layout*: 0 origin, 1 left, 2 right, 3 center, 4 pivot
+      vec2 anchor = transform.zw;
+      vec2 p;
+      if (alignment == 4) {
+        vec2 f = (g - 0.5 * (lo + hi)) * kScale;
+        p = vec2(f.x * transform.x - f.y * transform.y,
+                 f.x * transform.y + f.y * transform.x) + anchor;
+      } else {
+        if (alignment == 1) anchor.x -= lo.x * kScale;
+        if (alignment == 2) anchor.x -= hi.x * kScale;
+        if (alignment == 3) anchor -= 0.5 * (hi - lo) * kScale + lo * kScale;
+        //layoutNDC offsets glyph rows by the anchor in design pixels as well
+        p = vec2(anchor.x + g.x * kScale, anchor.y + (anchor.y * (uAtlas.w / kScale) + g.y) * kScale);
+      }
+      gl_Position = vec4(p * placement.xy + placement.zw, 0.0, 1.0);
     }
   )";
 
@@ -66,91 +201,144 @@ bool TtfTextRenderer::buildShader() {
     }
   )";
 
-  const GLuint v = compileShader(GL_VERTEX_SHADER, kVs);
-  const GLuint f = compileShader(GL_FRAGMENT_SHADER, kFs);
-  if (!v || !f) return false;
+  static const char* kPullFs = R"(
+    #version 330 core
+    in vec2 vUV;
+    flat in vec3 vColor;
+    out vec4 FragColor;
 
-  program_ = glCreateProgram();
-  glAttachShader(program_, v);
-  glAttachShader(program_, f);
-  glLinkProgram(program_);
+    uniform sampler2D uTex;
+
+    void main() {
+      FragColor = vec4(vColor, texture(uTex, vUV).r);
+    }
+  )";
+
+  if (!g_shader) {
+    std::unique_ptr<Shader> shader(new Shader());
+    std::unique_ptr<Shader> pull_shader(new Shader());
+    if (!shader->build(kVs, kFs)) {
+      std::cerr << "TTF program build failed\n";
+      return false;
+    }
+    if (!pull_shader->build(kPullVs, kPullFs)) {
+      std::cerr << "TTF vertex pulling program build failed\n";
+      return false;
+    }
 
-  glDeleteShader(v);
-  glDeleteShader(f);
+    shader->use();
+    glUniform1i(shader->uniform("uTex"), 0);
 
-  GLint ok = 0;
-  glGetProgramiv(program_, GL_LINK_STATUS, &ok);
-  if (!ok) {
-    char log[1024];
-    glGetProgramInfoLog(program_, 1024, nullptr, log);
-    std::cerr << "TTF program link error:\n" << log << "\n";
+    pull_shader->use();
+    glUniform1i(pull_shader->uniform("uTex"), 0);
+    glUniform1i(pull_shader->uniform("uMetrics"), 1);
+    glUniform1i(pull_shader->uniform("uCodes"), 2);
+    glUniform1i(pull_shader->uniform("uStrings"), 3);
 
-    glDeleteProgram(program_);
-    program_ = 0;
-    return false;
+    g_shader = std::move(shader);
+    g_pull_shader = std::move(pull_shader);
   }
 
-  glUseProgram(program_);
-  glUniform1i(glGetUniformLocation(program_, "uTex"), 0);
-  uColor_ = glGetUniformLocation(program_, "uColor");
+  shader_ = g_shader.get();
+  uColor_ = shader_->uniform("uColor");
+  uTransform_ = shader_->uniform("uTransform");
+  uPlacement_ = shader_->uniform("uPlacement");
+
+  pull_shader_ = g_pull_shader.get();
+  uPullAtlas_ = pull_shader_->uniform("uAtlas");
   return true;
 }
 
-bool TtfTextRenderer::init(const std::string& ttf_path, float pixel_height) {
-  if (!buildShader()) return false;
+void TtfTextRenderer::shutdownShared() {
+  g_shader.reset();
+  g_pull_shader.reset();
+}
 
-  std::vector<unsigned char> ttf;
-  if (!readFileBytes(ttf_path, ttf)) {
-    std::cerr << "Failed to read TTF: " << ttf_path << "\n";
-    return false;
-  }
+void TtfTextRenderer::exportRemote(uint16_t owner) const {
+  if (!ready_ || Primitives::softwareTarget()) return;
 
-  std::vector<unsigned char> bitmap(atlas_w_ * atlas_h_, 0);
+  using Kind = CommandList::ObjectKind;
+  const uint16_t shared = CommandList::REMOTE_TEXT_SHADERS;
+  CommandList::exportShader(CommandList::remoteKey(shared, 1), shader_);
+  CommandList::exportShader(CommandList::remoteKey(shared, 2), pull_shader_);
+  CommandList::exportBinder(CommandList::remoteKey(shared, 1), bindInstances);
 
-  stbtt_pack_context pc{};
-  if (!stbtt_PackBegin(&pc, bitmap.data(), atlas_w_, atlas_h_, 0, 1, nullptr)) {
-    std::cerr << "stbtt_PackBegin failed\n";
-    return false;
+  CommandList::exportObject(Kind::Texture, CommandList::remoteKey(owner, 1), tex_);
+  for (int i = 0; i < FontAtlas::MAX_PAGES; ++i) {
+    CommandList::exportObject(Kind::Texture, CommandList::remoteKey(owner, (uint8_t)(2 + i)), page_tex_[i]);
   }
+  CommandList::exportObject(Kind::Texture, CommandList::remoteKey(owner, 16), metrics_tex_);
+  CommandList::exportObject(Kind::Texture, CommandList::remoteKey(owner, 17), codes_tex_);
+  CommandList::exportObject(Kind::Texture, CommandList::remoteKey(owner, 18), strings_tex_);
+  CommandList::exportObject(Kind::VertexArray, CommandList::remoteKey(owner, 1), vao_);
+  CommandList::exportObject(Kind::VertexArray, CommandList::remoteKey(owner, 2), static_vao_);
+  CommandList::exportObject(Kind::VertexArray, CommandList::remoteKey(owner, 3), pull_vao_);
+  CommandList::exportObject(Kind::Buffer, CommandList::remoteKey(owner, 1), vbo_);
+  CommandList::exportObject(Kind::Buffer, CommandList::remoteKey(owner, 2), static_vbo_);
+
+  CommandList::exportStream(CommandList::remoteKey(owner, 1), instance_stream_);
+  CommandList::exportStream(CommandList::remoteKey(owner, 2), static_stream_);
+  CommandList::exportStream(CommandList::remoteKey(owner, 3), codes_stream_);
+  CommandList::exportStream(CommandList::remoteKey(owner, 4), glyph_stream_, true);
+  CommandList::exportStream(CommandList::remoteKey(owner, 5), strings_stream_);
+  CommandList::exportStream(CommandList::remoteKey(owner, 6), atlas_stream_);
+}
+
+bool TtfTextRenderer::init(const std::string& ttf_path, float pixel_height, const BakedFontFile* baked,
+                           float raster_scale) {
+  return prepare(ttf_path, pixel_height, baked, raster_scale) && upload();
+}
+
+bool TtfTextRenderer::prepare(const std::string& ttf_path, float pixel_height, const BakedFontFile* baked,
+                              float raster_scale) {
+  ttf_path_ = ttf_path;
+  pixel_height_ = pixel_height;
+  baked_ = baked;
+  return rasterize(raster_scale);
+}
 
-  stbtt_PackSetOversampling(&pc, 1, 1);
+bool TtfTextRenderer::rasterize(float raster_scale) {
+  const float px = pixel_height_ * raster_scale;
+  StartupTrace::Scope scope("font_load", ttf_path_ + " " + std::to_string((int)px) + "px baked");
 
-  stbtt_packedchar baked_ascii[95];
-  stbtt_PackFontRange(&pc, ttf.data(), 0, pixel_height, 32, 95, baked_ascii);
+  raster_scale_ = raster_scale;
+  atlas_.setGlyphScale(FontAtlas::kScale / raster_scale);
 
-  stbtt_packedchar baked_degree[1];
-  stbtt_PackFontRange(&pc, ttf.data(), 0, pixel_height, 176, 1, baked_degree);
+  const bool from_baked = baked_ && baked_->find(ttf_path_, px, atlas_);
+  if (from_baked) return true;
 
-  stbtt_PackEnd(&pc);
+  scope.setDetail(ttf_path_ + " " + std::to_string((int)px) + "px rasterized");
+  return atlas_.build(ttf_path_, px);
+}
+
+bool TtfTextRenderer::setRasterScale(float raster_scale) {
+  if (raster_scale == raster_scale_) return true;
+  if (!rasterize(raster_scale)) return false;
+
+  //Every layout was in the old atlas; dynamic pages start over
+  for (RetainedText& t : texts_) layoutRetained(t);
+  pages_sent_ = 0;
+  atlas_pending_ = true;
+  return true;
+}
 
-  for (int i = 0; i < 95; ++i) {
-    chars_[i] = {
-      static_cast<float>(baked_ascii[i].x0),
-      static_cast<float>(baked_ascii[i].y0),
-      static_cast<float>(baked_ascii[i].x1),
-      static_cast<float>(baked_ascii[i].y1),
-      baked_ascii[i].xoff,
-      baked_ascii[i].yoff,
-      baked_ascii[i].xadvance
-    };
+bool TtfTextRenderer::upload() {
+  //Software backend samples the CPU atlas directly
+  if (Primitives::softwareTarget()) {
+    ready_ = true;
+    return true;
   }
 
-  chars_[144] = {
-    static_cast<float>(baked_degree[0].x0),
-    static_cast<float>(baked_degree[0].y0),
-    static_cast<float>(baked_degree[0].x1),
-    static_cast<float>(baked_degree[0].y1),
-    baked_degree[0].xoff,
-    baked_degree[0].yoff,
-    baked_degree[0].xadvance
-  };
+  if (!buildShader()) return false;
+
+  StartupTrace::Scope scope("font_upload", std::to_string(atlas_.width()) + "x" + std::to_string(atlas_.height()));
 
   glGenTextures(1, &tex_);
   glBindTexture(GL_TEXTURE_2D, tex_);
   glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, atlas_w_, atlas_h_, 0,
-               GL_RED, GL_UNSIGNED_BYTE, bitmap.data());
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, atlas_.width(), atlas_.height(), 0,
+               GL_RED, GL_UNSIGNED_BYTE, atlas_.pixels());
 
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -161,299 +349,537 @@ bool TtfTextRenderer::init(const std::string& ttf_path, float pixel_height) {
 
   glGenVertexArrays(1, &vao_);
   glGenBuffers(1, &vbo_);
+  setupTextVertexArray(vao_, vbo_, GL_DYNAMIC_DRAW);
+
+  glGenVertexArrays(1, &static_vao_);
+  glGenBuffers(1, &static_vbo_);
+  setupTextVertexArray(static_vao_, static_vbo_, GL_STATIC_DRAW);
+
+  uploadPullBuffers();
+
+  //Page storage is allocated when the first pixels arrive; names exist up
+  //front so commands can be recorded before that
+  glGenTextures(FontAtlas::MAX_PAGES, page_tex_);
+
+  instance_stream_ = CommandList::addStream([this](const unsigned char* data, size_t bytes) {
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)bytes, data, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  });
+  static_stream_ = CommandList::addStream([this](const unsigned char* data, size_t bytes) {
+    glBindBuffer(GL_ARRAY_BUFFER, static_vbo_);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)bytes, data, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  });
+  codes_stream_ = CommandList::addStream([this](const unsigned char* data, size_t bytes) {
+    glBindBuffer(GL_TEXTURE_BUFFER, codes_buf_);
+    glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)bytes, data, GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+  });
+  strings_stream_ = CommandList::addStream([this](const unsigned char* data, size_t bytes) {
+    glBindBuffer(GL_TEXTURE_BUFFER, strings_buf_);
+    glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)bytes, data, GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+  });
+  glyph_stream_ = CommandList::addStream([this](const unsigned char* data, size_t bytes) {
+    uploadGlyphPages(data, bytes);
+  });
+  atlas_stream_ = CommandList::addStream([this](const unsigned char* data, size_t bytes) {
+    uploadAtlas(data, bytes);
+  });
+  CommandList::addFinishHook([this] { finishFrame(); });
+
+  ready_ = true;
+  return true;
+}
 
-  glBindVertexArray(vao_);
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-  glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_DYNAMIC_DRAW);
+//Two RGBA32F texels per static code: (x0, y0, x1, y1) (xoff, yoff, xadvance, -)
+void TtfTextRenderer::packMetrics(float* out) const {
+  for (int i = 0; i < FontAtlas::CHAR_COUNT; ++i) {
+    const FontAtlas::BakedChar& bc = atlas_.charTable()[i];
+    const float texels[8] = { bc.x0, bc.y0, bc.x1, bc.y1, bc.xoff, bc.yoff, bc.xadvance, 0.0f };
+    std::memcpy(out + (size_t)i * 8, texels, sizeof(texels));
+  }
+}
 
-  glEnableVertexAttribArray(0);
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+//The static metrics table goes to the GPU once; strings then only upload their glyph codes
+void TtfTextRenderer::uploadPullBuffers() {
+  std::vector<float> metrics(FontAtlas::CHAR_COUNT * 8);
+  packMetrics(metrics.data());
 
-  glEnableVertexAttribArray(1);
-  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+  glGenBuffers(1, &metrics_buf_);
+  glBindBuffer(GL_TEXTURE_BUFFER, metrics_buf_);
+  glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)(metrics.size() * sizeof(float)), metrics.data(), GL_STATIC_DRAW);
 
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindVertexArray(0);
+  glGenBuffers(1, &codes_buf_);
+  glBindBuffer(GL_TEXTURE_BUFFER, codes_buf_);
+  glBufferData(GL_TEXTURE_BUFFER, 4, nullptr, GL_STREAM_DRAW);
 
-  return true;
-}
+  glGenBuffers(1, &strings_buf_);
+  glBindBuffer(GL_TEXTURE_BUFFER, strings_buf_);
+  glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+  glGenTextures(1, &metrics_tex_);
+  glBindTexture(GL_TEXTURE_BUFFER, metrics_tex_);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, metrics_buf_);
 
-const TtfTextRenderer::BakedChar* TtfTextRenderer::getCharMetrics(unsigned char c) {
-  if (c >= 32 && c <= 126) return &chars_[c - 32];
-  if (c == 176) return &chars_[144];
-  return nullptr;
+  glGenTextures(1, &codes_tex_);
+  glBindTexture(GL_TEXTURE_BUFFER, codes_tex_);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, codes_buf_);
+
+  glGenTextures(1, &strings_tex_);
+  glBindTexture(GL_TEXTURE_BUFFER, strings_tex_);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, strings_buf_);
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+  //No vertex attributes: every input is fetched by gl_VertexID
+  glGenVertexArrays(1, &pull_vao_);
 }
 
-void TtfTextRenderer::drawTextNDC(const std::string& text, float x_ndc, float y_ndc,
-                                 float r, float g, float b) {
-  if (!program_ || !tex_ || text.empty()) return;
+//Glyph codes index the static metrics table and are appended to codes, tagged
+//with their string; false (and nothing appended) if any glyph lives in a
+//dynamic page or the string is too long to tag
+bool TtfTextRenderer::encodeStatic(const char* text, std::vector<uint32_t>& codes, uint32_t string) {
+  const size_t start = codes.size();
+  for (const char* pc = text; *pc;) {
+    const uint32_t cp = FontAtlas::decodeUtf8(pc);
+    const uint32_t tag = (uint32_t)(codes.size() - start) << 8 | string << 16;
+    if (codes.size() - start == PULL_MAX_GLYPHS) {
+      codes.resize(start);
+      return false;
+    }
+    if (cp >= 32 && cp <= 126) codes.push_back((cp - 32) | tag);
+    else if (cp == 176) codes.push_back(144 | tag);
+    else {
+      codes.resize(start);
+      return false;
+    }
+  }
+  return true;
+}
 
-  constexpr float kScale = 0.0020f;
+bool TtfTextRenderer::drawPulled(const char* text, int alignment, float x, float y,
+                                 float cos_a, float sin_a, float r, float g, float b) {
+  if (Primitives::softwareTarget()) return false;
+
+  const size_t string = strings_.size() / 16;
+  if (string >= (size_t)PULL_MAX_STRINGS) return false;
+
+  const uint8_t layer = CommandList::layer();
+  if (layer >= codes_.size()) codes_.resize((size_t)layer + 1);
+  std::vector<uint32_t>& codes = codes_[layer];
+
+  const size_t first = codes.size();
+  if (!encodeStatic(text, codes, (uint32_t)string)) return false;
+  const int count = (int)(codes.size() - first);
+  if (count == 0) return true;
+
+  //Drawn with the rest of its layer when the frame is finished
+  const InstrumentView::Placement& view = InstrumentView::current();
+  strings_.insert(strings_.end(), {
+    cos_a, sin_a, x, y,
+    r, g, b, (float)alignment,
+    view.scale_x, view.scale_y, view.offset_x, view.offset_y,
+    (float)count, 0.0f, 0.0f, 0.0f
+  });
+  return true;
+}
 
-  std::vector<float> verts;
-  verts.reserve(text.size() * 6 * 4);
+//Runs on CommandList::finish: the frame's glyph instances, codes, string records
+//and new glyph pixels go into its streams, every layer's pulled strings become
+//one draw, and retained draws get their ranges in the static buffer
+void TtfTextRenderer::finishFrame() {
+  if (static_dirty_) rebuildStaticBuffer();
+
+  for (const RetainedDraw& d : retained_draws_) {
+    CommandList::Command& cmd = CommandList::at(d.command);
+    for (const RetainedText::Range& range : texts_[d.handle].ranges) {
+      if (range.page != d.page) continue;
+      cmd.first = range.first;
+      cmd.count = range.count;
+    }
+  }
+  retained_draws_.clear();
 
-  float pen_x = 0.0f;
+  if (!instances_.empty()) {
+    std::vector<unsigned char>& out = CommandList::stream(instance_stream_);
+    out.resize(instances_.size() * sizeof(GlyphInstance));
+    std::memcpy(out.data(), instances_.data(), out.size());
+    instances_.clear();
+  }
 
-  for (unsigned char c : text) {
-    const BakedChar* bc = getCharMetrics(c);
-    if (!bc) continue;
+  if (!strings_.empty()) {
+    size_t total = 0;
+    for (const std::vector<uint32_t>& codes : codes_) total += codes.size();
+
+    std::vector<unsigned char>& out = CommandList::stream(codes_stream_);
+    out.resize(total * sizeof(uint32_t));
+
+    const uint8_t current = CommandList::layer();
+    size_t first = 0;
+    for (size_t layer = 0; layer < codes_.size(); ++layer) {
+      std::vector<uint32_t>& codes = codes_[layer];
+      if (codes.empty()) continue;
+      std::memcpy(&out[first * sizeof(uint32_t)], codes.data(), codes.size() * sizeof(uint32_t));
+
+      CommandList::setLayer((uint8_t)layer);
+      CommandList::Command& cmd = CommandList::record(*pull_shader_, pull_vao_, GL_TRIANGLES,
+                                                      (int)first * 6, (int)codes.size() * 6);
+      cmd.textures[0] = { GL_TEXTURE_2D, tex_ };
+      cmd.textures[1] = { GL_TEXTURE_BUFFER, metrics_tex_ };
+      cmd.textures[2] = { GL_TEXTURE_BUFFER, codes_tex_ };
+      cmd.textures[3] = { GL_TEXTURE_BUFFER, strings_tex_ };
+      CommandList::uniform4f(uPullAtlas_, (float)atlas_.width(), (float)atlas_.height(), atlas_.glyphScale(),
+                             FontAtlas::kScale);
+
+      first += codes.size();
+      codes.clear();
+    }
+    CommandList::setLayer(current);
 
-    const float x0 = pen_x + bc->xoff;
-    const float y0 = y_ndc - bc->yoff;
-    const float x1 = x0 + (bc->x1 - bc->x0);
-    const float y1 = y0 - (bc->y1 - bc->y0);
+    std::vector<unsigned char>& records = CommandList::stream(strings_stream_);
+    records.resize(strings_.size() * sizeof(float));
+    std::memcpy(records.data(), strings_.data(), records.size());
+    strings_.clear();
+  }
 
-    const float X0 = x_ndc + x0 * kScale;
-    const float Y0 = y_ndc + y0 * kScale;
-    const float X1 = x_ndc + x1 * kScale;
-    const float Y1 = y_ndc + y1 * kScale;
+  captureAtlas();
+  captureGlyphPages();
+}
 
-    const float U0 = bc->x0 / (float)atlas_w_;
-    const float V0 = bc->y0 / (float)atlas_h_;
-    const float U1 = bc->x1 / (float)atlas_w_;
-    const float V1 = bc->y1 / (float)atlas_h_;
+void TtfTextRenderer::recordInstances(GLuint vao, GLuint vbo, int page, int first, int count,
+                                      float r, float g, float b, float cos_a, float sin_a, float tx, float ty) {
+  CommandList::Command& cmd = CommandList::record(*shader_, vao, GL_TRIANGLES, first, count);
+  cmd.textures[0] = { GL_TEXTURE_2D, page == 0 ? tex_ : page_tex_[page - 1] };
+  cmd.index_count = 6;
+  cmd.instance_buffer = vbo;
+  cmd.bind_instances = bindInstances;
+  CommandList::uniform3f(uColor_, r, g, b);
+  CommandList::uniform4f(uTransform_, cos_a, sin_a, tx, ty);
+
+  const InstrumentView::Placement& view = InstrumentView::current();
+  CommandList::uniform4f(uPlacement_, view.scale_x, view.scale_y, view.offset_x, view.offset_y);
+}
 
-    verts.insert(verts.end(), { X0, Y0, U0, V0,  X1, Y0, U1, V0,  X1, Y1, U1, V1 });
-    verts.insert(verts.end(), { X0, Y0, U0, V0,  X1, Y1, U1, V1,  X0, Y1, U0, V1 });
+namespace {
+  struct AtlasUpload {
+    int32_t width, height;           // followed by the static page and the metrics table
+  };
 
-    pen_x += bc->xadvance;
-  }
+  struct GlyphUpload {
+    int32_t page, x, y, w, h;        // followed by w * h tightly packed pixels
+  };
+}
 
-  if (verts.empty()) return;
+//A re-rasterized static page replaces the texture and metrics table with the
+//frame that first uses it; the first frame always carries one, so remote heads
+//start from the sender's atlas whatever size they prepared
+void TtfTextRenderer::captureAtlas() {
+  if (!atlas_pending_) return;
+  atlas_pending_ = false;
+
+  const size_t pixels = (size_t)atlas_.width() * atlas_.height();
+  const size_t metrics = (size_t)FontAtlas::CHAR_COUNT * 8 * sizeof(float);
+  const AtlasUpload header = { atlas_.width(), atlas_.height() };
+
+  std::vector<unsigned char>& out = CommandList::stream(atlas_stream_);
+  out.resize(sizeof(header) + pixels + metrics);
+  std::memcpy(out.data(), &header, sizeof(header));
+  std::memcpy(&out[sizeof(header)], atlas_.pixels(), pixels);
+
+  std::vector<float> table(FontAtlas::CHAR_COUNT * 8);
+  packMetrics(table.data());
+  std::memcpy(&out[sizeof(header) + pixels], table.data(), metrics);
+}
 
-  glUseProgram(program_);
-  glUniform3f(uColor_, r, g, b);
+void TtfTextRenderer::uploadAtlas(const unsigned char* data, size_t bytes) {
+  AtlasUpload u;
+  if (bytes < sizeof(u)) return;
+  std::memcpy(&u, data, sizeof(u));
+  const size_t pixels = (size_t)u.width * u.height;
+  const size_t metrics = (size_t)FontAtlas::CHAR_COUNT * 8 * sizeof(float);
+  if (bytes != sizeof(u) + pixels + metrics) return;
 
   glActiveTexture(GL_TEXTURE0);
   glBindTexture(GL_TEXTURE_2D, tex_);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, u.width, u.height, 0, GL_RED, GL_UNSIGNED_BYTE, data + sizeof(u));
+  glBindTexture(GL_TEXTURE_2D, 0);
 
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glBindBuffer(GL_TEXTURE_BUFFER, metrics_buf_);
+  glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)metrics, data + sizeof(u) + pixels, GL_STATIC_DRAW);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
 
-  glBindVertexArray(vao_);
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-  glBufferData(GL_ARRAY_BUFFER,
-               (GLsizeiptr)(verts.size() * sizeof(float)),
-               verts.data(),
-               GL_DYNAMIC_DRAW);
+//New pages are sent once in full; after that only the glyph slots rasterized
+//since the last frame are copied into the frame's stream. Once those slots
+//outweigh the pages, all pages are sent again and restart the stream, so a
+//remote sender retains at most about twice the pages.
+void TtfTextRenderer::captureGlyphPages() {
+  const int dynamic_pages = atlas_.pageCount() - 1;
+  if (atlas_.dirtyRects().empty() && pages_sent_ == dynamic_pages) return;
+
+  const size_t page_bytes = sizeof(GlyphUpload) + (size_t)FontAtlas::PAGE_SIZE * FontAtlas::PAGE_SIZE;
+  if (glyph_bytes_ > (size_t)dynamic_pages * page_bytes) pages_sent_ = 0;
+  if (pages_sent_ == 0) {
+    CommandList::restartStream(glyph_stream_);
+    glyph_bytes_ = 0;
+  }
 
-  glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(verts.size() / 4));
+  std::vector<unsigned char>& out = CommandList::stream(glyph_stream_);
+  const size_t start = out.size();
+  auto append = [&](int page, int x, int y, int w, int h) {
+    const GlyphUpload header = { page, x, y, w, h };
+    const size_t at = out.size();
+    out.resize(at + sizeof(header) + (size_t)w * h);
+    std::memcpy(&out[at], &header, sizeof(header));
+
+    const int stride = atlas_.pageWidth(page);
+    const unsigned char* src = atlas_.pagePixels(page) + (size_t)y * stride + x;
+    unsigned char* dst = &out[at + sizeof(header)];
+    for (int row = 0; row < h; ++row) std::memcpy(dst + (size_t)row * w, src + (size_t)row * stride, (size_t)w);
+  };
 
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindVertexArray(0);
+  const int old_pages = pages_sent_;
+  for (; pages_sent_ < dynamic_pages; ++pages_sent_) {
+    const int page = pages_sent_ + 1;
+    append(page, 0, 0, atlas_.pageWidth(page), atlas_.pageHeight(page));
+  }
+  for (const FontAtlas::DirtyRect& d : atlas_.dirtyRects()) {
+    if (d.page > old_pages) continue;   // already sent in full
+    append(d.page, d.x, d.y, d.w, d.h);
+  }
 
-  glDisable(GL_BLEND);
-  glBindTexture(GL_TEXTURE_2D, 0);
+  glyph_bytes_ += out.size() - start;
+  atlas_.clearDirty();
 }
 
-void TtfTextRenderer::drawTextCenteredNDC(const std::string& text, float cx_ndc, float cy_ndc,
-                                         float r, float g, float b) {
-  if (text.empty()) return;
-
-  float pen_x = 0.0f;
-  float minx = 1e9f, miny = 1e9f;
-  float maxx = -1e9f, maxy = -1e9f;
-
-  for (unsigned char c : text) {
-    const BakedChar* bc = getCharMetrics(c);
-    if (!bc) continue;
+void TtfTextRenderer::uploadGlyphPages(const unsigned char* data, size_t bytes) {
+  glActiveTexture(GL_TEXTURE0);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-    const float gx0 = pen_x + bc->xoff;
-    const float gy0 = -bc->yoff;
-    const float gx1 = gx0 + (bc->x1 - bc->x0);
-    const float gy1 = gy0 - (bc->y1 - bc->y0);
+  for (size_t at = 0; at + sizeof(GlyphUpload) <= bytes;) {
+    GlyphUpload u;
+    std::memcpy(&u, data + at, sizeof(u));
+    at += sizeof(u);
+
+    //A record that does not fit its page or the stream ends the upload
+    if (u.page < 1 || u.page > FontAtlas::MAX_PAGES) break;
+    if (u.x < 0 || u.y < 0 || u.w < 0 || u.h < 0) break;
+    if (u.w > atlas_.pageWidth(u.page) - u.x || u.h > atlas_.pageHeight(u.page) - u.y) break;
+    if ((size_t)u.w * u.h > bytes - at) break;
+
+    glBindTexture(GL_TEXTURE_2D, page_tex_[u.page - 1]);
+    if (!page_storage_[u.page - 1]) {
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, atlas_.pageWidth(u.page), atlas_.pageHeight(u.page), 0,
+                   GL_RED, GL_UNSIGNED_BYTE, nullptr);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+      page_storage_[u.page - 1] = true;
+    }
+    glTexSubImage2D(GL_TEXTURE_2D, 0, u.x, u.y, u.w, u.h, GL_RED, GL_UNSIGNED_BYTE, data + at);
+    at += (size_t)u.w * u.h;
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
 
-    minx = std::min(minx, gx0);
-    miny = std::min(miny, gy1);
-    maxx = std::max(maxx, gx1);
-    maxy = std::max(maxy, gy0);
+void TtfTextRenderer::drawQuads(float r, float g, float b, float cos_a, float sin_a, float tx, float ty) {
+  if (quads_.empty()) return;
 
-    pen_x += bc->xadvance;
+  if (SoftRasterizer* soft = Primitives::softwareTarget()) {
+    if (cos_a != 1.0f || sin_a != 0.0f || tx != 0.0f || ty != 0.0f) transformQuads(quads_, cos_a, sin_a, tx, ty);
+    soft->drawGlyphs(atlas_, quads_.data(), (int)quads_.size(), r, g, b);
+    return;
   }
 
-  if (minx > maxx) return;
+  //Group quads by page so each page is one draw
+  for (int page = 0; page < atlas_.pageCount(); ++page) {
+    const int first = (int)instances_.size();
+    appendQuads(quads_, page, instances_);
+    const int count = (int)instances_.size() - first;
+    if (count > 0) recordInstances(vao_, vbo_, page, first, count, r, g, b, cos_a, sin_a, tx, ty);
+  }
+}
 
-  constexpr float kScale = 0.0020f;
+void TtfTextRenderer::drawTextNDC(const std::string& text, float x_ndc, float y_ndc,
+                                 float r, float g, float b) {
+  if (!ready_ || text.empty()) return;
+  if (drawPulled(text.c_str(), PULL_ORIGIN, x_ndc, y_ndc, 1.0f, 0.0f, r, g, b)) return;
 
-  const float w_ndc = (maxx - minx) * kScale;
-  const float h_ndc = (maxy - miny) * kScale;
+  quads_.clear();
+  atlas_.layoutNDC(text.c_str(), x_ndc, y_ndc, quads_);
+  drawQuads(r, g, b);
+}
 
-  const float x_ndc = cx_ndc - 0.5f * w_ndc - (minx * kScale);
-  const float y_ndc = cy_ndc - 0.5f * h_ndc - (miny * kScale);
+void TtfTextRenderer::drawTextCenteredNDC(const std::string& text, float cx_ndc, float cy_ndc,
+                                         float r, float g, float b) {
+  if (!ready_ || text.empty()) return;
+  if (drawPulled(text.c_str(), PULL_CENTER, cx_ndc, cy_ndc, 1.0f, 0.0f, r, g, b)) return;
 
-  drawTextNDC(text, x_ndc, y_ndc, r, g, b);
+  quads_.clear();
+  atlas_.layoutCentered(text.c_str(), cx_ndc, cy_ndc, quads_);
+  drawQuads(r, g, b);
 }
 
 void TtfTextRenderer::drawTextCenteredNDCRotated(const char* text,
                                                 float cx_ndc, float cy_ndc,
                                                 float rotation_deg,
                                                 float r, float g, float b) {
-  if (!text || !*text || !program_ || !tex_) return;
-
-  constexpr float kScale = 0.0020f;
+  if (!text || !*text || !ready_) return;
 
   const float angle_rad = rotation_deg * 3.14159265359f / 180.0f;
-  const float cos_a = std::cos(angle_rad);
-  const float sin_a = std::sin(angle_rad);
+  if (drawPulled(text, PULL_PIVOT, cx_ndc, cy_ndc, std::cos(angle_rad), std::sin(angle_rad), r, g, b)) return;
 
-  std::vector<float> verts;
-  verts.reserve(std::strlen(text) * 6 * 4);
+  //Laid out unrotated at the origin; the shader rotates and places it
+  quads_.clear();
+  atlas_.layoutCenteredRotated(text, 0.0f, 0.0f, 0.0f, quads_);
+  drawQuads(r, g, b, std::cos(angle_rad), std::sin(angle_rad), cx_ndc, cy_ndc);
+}
 
-  float pen_x = 0.0f;
-  float minx = 1e9f, miny = 1e9f;
-  float maxx = -1e9f, maxy = -1e9f;
+void TtfTextRenderer::drawTextLeftAligned(const char* text, float x, float y,
+                                         float r, float g, float b) {
+  if (!text || !*text || !ready_) return;
+  if (drawPulled(text, PULL_LEFT, x, y, 1.0f, 0.0f, r, g, b)) return;
 
-  for (const char* pc = text; *pc; ++pc) {
-    const unsigned char c = (unsigned char)*pc;
-    const BakedChar* bc = getCharMetrics(c);
-    if (!bc) continue;
+  quads_.clear();
+  atlas_.layoutLeftAligned(text, x, y, quads_);
+  drawQuads(r, g, b);
+}
 
-    const float gx0 = pen_x + bc->xoff;
-    const float gy0 = -bc->yoff;
-    const float gx1 = gx0 + (bc->x1 - bc->x0);
-    const float gy1 = gy0 - (bc->y1 - bc->y0);
+void TtfTextRenderer::drawTextRightAligned(const char* text, float x, float y,
+                                          float r, float g, float b) {
+  if (!text || !*text || !ready_) return;
+  if (drawPulled(text, PULL_RIGHT, x, y, 1.0f, 0.0f, r, g, b)) return;
 
-    minx = std::min(minx, gx0);
-    miny = std::min(miny, gy1);
-    maxx = std::max(maxx, gx1);
-    maxy = std::max(maxy, gy0);
+  quads_.clear();
+  atlas_.layoutRightAligned(text, x, y, quads_);
+  drawQuads(r, g, b);
+}
 
-    pen_x += bc->xadvance;
+void TtfTextRenderer::layoutRetained(RetainedText& t) {
+  t.quads.clear();
+  switch (t.align) {
+    case Align::Left:   atlas_.layoutLeftAligned(t.text.c_str(), t.x, t.y, t.quads); break;
+    case Align::Right:  atlas_.layoutRightAligned(t.text.c_str(), t.x, t.y, t.quads); break;
+    case Align::Center: atlas_.layoutCentered(t.text.c_str(), t.x, t.y, t.quads); break;
+    case Align::Pivot:  atlas_.layoutCenteredRotated(t.text.c_str(), 0.0f, 0.0f, 0.0f, t.quads); break;
   }
 
-  if (minx > maxx) return;
-
-  const float offset_x = -(minx + maxx) * 0.5f;
-  const float offset_y = -(miny + maxy) * 0.5f;
-
-  pen_x = 0.0f;
-  for (const char* pc = text; *pc; ++pc) {
-    const unsigned char c = (unsigned char)*pc;
-    const BakedChar* bc = getCharMetrics(c);
-    if (!bc) continue;
-
-    const float x0 = pen_x + bc->xoff + offset_x;
-    const float y0 = -bc->yoff + offset_y;
-    const float x1 = x0 + (bc->x1 - bc->x0);
-    const float y1 = y0 - (bc->y1 - bc->y0);
-
-    const float U0 = bc->x0 / (float)atlas_w_;
-    const float V0 = bc->y0 / (float)atlas_h_;
-    const float U1 = bc->x1 / (float)atlas_w_;
-    const float V1 = bc->y1 / (float)atlas_h_;
+  t.dynamic_glyphs = false;
+  for (const FontAtlas::GlyphQuad& q : t.quads) t.dynamic_glyphs |= q.page != 0;
+  static_dirty_ = true;
+}
 
-    const float corners[4][2] = {
-      { x0, y0 }, { x1, y0 }, { x1, y1 }, { x0, y1 }
-    };
+//Dynamic glyphs can be evicted and re-rasterized elsewhere; laying out
+//again also marks them used this frame
+bool TtfTextRenderer::glyphsMoved(RetainedText& t) {
+  if (!t.dynamic_glyphs) return false;
 
-    float p[4][2];
-    for (int i = 0; i < 4; ++i) {
-      const float fx = corners[i][0] * kScale;
-      const float fy = corners[i][1] * kScale;
+  const bool was_dirty = static_dirty_;
+  std::vector<FontAtlas::GlyphQuad> old;
+  old.swap(t.quads);
+  layoutRetained(t);
 
-      const float rx = fx * cos_a - fy * sin_a;
-      const float ry = fx * sin_a + fy * cos_a;
+  const bool moved = old.size() != t.quads.size() ||
+                     std::memcmp(old.data(), t.quads.data(), old.size() * sizeof(FontAtlas::GlyphQuad)) != 0;
+  if (!moved) static_dirty_ = was_dirty;
+  return moved;
+}
 
-      p[i][0] = rx + cx_ndc;
-      p[i][1] = ry + cy_ndc;
+//All retained meshes share one buffer, grouped by page per text
+void TtfTextRenderer::rebuildStaticBuffer() {
+  static_dirty_ = false;
+
+  std::vector<GlyphInstance> instances;
+  for (RetainedText& t : texts_) {
+    t.ranges.clear();
+    for (int page = 0; page < atlas_.pageCount(); ++page) {
+      const int first = (int)instances.size();
+      appendQuads(t.quads, page, instances);
+      const int count = (int)instances.size() - first;
+      if (count > 0) t.ranges.push_back({ page, first, count });
     }
-
-    verts.insert(verts.end(), {
-      p[0][0], p[0][1], U0, V0,
-      p[1][0], p[1][1], U1, V0,
-      p[2][0], p[2][1], U1, V1
-    });
-    verts.insert(verts.end(), {
-      p[0][0], p[0][1], U0, V0,
-      p[2][0], p[2][1], U1, V1,
-      p[3][0], p[3][1], U0, V1
-    });
-
-    pen_x += bc->xadvance;
   }
 
-  if (verts.empty()) return;
+  if (Primitives::softwareTarget()) return;
 
-  glUseProgram(program_);
-  glUniform3f(uColor_, r, g, b);
-
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, tex_);
-
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-  glBindVertexArray(vao_);
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-  glBufferData(GL_ARRAY_BUFFER,
-               (GLsizeiptr)(verts.size() * sizeof(float)),
-               verts.data(),
-               GL_DYNAMIC_DRAW);
-
-  glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(verts.size() / 4));
-
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindVertexArray(0);
-
-  glDisable(GL_BLEND);
-  glBindTexture(GL_TEXTURE_2D, 0);
+  std::vector<unsigned char>& out = CommandList::stream(static_stream_);
+  out.resize(instances.size() * sizeof(GlyphInstance));
+  std::memcpy(out.data(), instances.data(), out.size());
 }
 
-void TtfTextRenderer::drawTextLeftAligned(const char* text, float x, float y,
-                                         float r, float g, float b) {
-  if (!text || !*text || !program_ || !tex_) return;
-
-  constexpr float kScale = 0.0020f;
-
-  float pen_x = 0.0f;
-  float minx = 1e9f, maxx = -1e9f;
-
-  for (const char* pc = text; *pc; ++pc) {
-    const unsigned char c = (unsigned char)*pc;
-    const BakedChar* bc = getCharMetrics(c);
-    if (!bc) continue;
-
-    const float gx0 = pen_x + bc->xoff;
-    const float gx1 = gx0 + (bc->x1 - bc->x0);
+TtfTextRenderer::TextHandle TtfTextRenderer::createText(const char* text, Align align, float x, float y) {
+  RetainedText t;
+  t.text = text ? text : "";
+  t.align = align;
+  t.x = x;
+  t.y = y;
+  t.dynamic_glyphs = false;
+  layoutRetained(t);
+
+  texts_.push_back(std::move(t));
+  return (TextHandle)texts_.size() - 1;
+}
 
-    minx = std::min(minx, gx0);
-    maxx = std::max(maxx, gx1);
+void TtfTextRenderer::updateText(TextHandle handle, const char* text, float x, float y) {
+  RetainedText& t = texts_[handle];
+  if (!text) text = "";
+  if (t.text == text && t.x == x && t.y == y) return;
 
-    pen_x += bc->xadvance;
-  }
-
-  if (minx > maxx) return;
+  t.text = text;
+  t.x = x;
+  t.y = y;
+  layoutRetained(t);
+}
 
-  const float x_ndc = x - (minx * kScale);
-  drawTextNDC(std::string(text), x_ndc, y, r, g, b);
+void TtfTextRenderer::drawText(TextHandle handle, float r, float g, float b) {
+  drawRetained(texts_[handle], r, g, b, 1.0f, 0.0f, 0.0f, 0.0f);
 }
 
-void TtfTextRenderer::drawTextRightAligned(const char* text, float x, float y,
+void TtfTextRenderer::drawTextTransformed(TextHandle handle, float x, float y, float rotation_deg,
                                           float r, float g, float b) {
-  if (!text || !*text || !program_ || !tex_) return;
-
-  constexpr float kScale = 0.0020f;
-
-  float pen_x = 0.0f;
-  float minx = 1e9f, maxx = -1e9f;
-
-  for (const char* pc = text; *pc; ++pc) {
-    const unsigned char c = (unsigned char)*pc;
-    const BakedChar* bc = getCharMetrics(c);
-    if (!bc) continue;
-
-    const float gx0 = pen_x + bc->xoff;
-    const float gx1 = gx0 + (bc->x1 - bc->x0);
+  const float angle_rad = rotation_deg * 3.14159265359f / 180.0f;
+  drawRetained(texts_[handle], r, g, b, std::cos(angle_rad), std::sin(angle_rad), x, y);
+}
 
-    minx = std::min(minx, gx0);
-    maxx = std::max(maxx, gx1);
+void TtfTextRenderer::drawRetained(RetainedText& t, float r, float g, float b,
+                                   float cos_a, float sin_a, float tx, float ty) {
+  if (!ready_) return;
+  glyphsMoved(t);
+  if (t.quads.empty()) return;
+
+  //Software backend has no buffers; transform the stored quads on the CPU
+  if (SoftRasterizer* soft = Primitives::softwareTarget()) {
+    quads_ = t.quads;
+    transformQuads(quads_, cos_a, sin_a, tx, ty);
+    soft->drawGlyphs(atlas_, quads_.data(), (int)quads_.size(), r, g, b);
+    return;
+  }
 
-    pen_x += bc->xadvance;
+  //Static-page labels go with the frame's pulled strings, so they batch across
+  //labels and instruments; the mesh remains for dynamic glyphs and for
+  //rotating a non-pivot layout
+  if (!t.dynamic_glyphs) {
+    if (t.align == Align::Pivot &&
+        drawPulled(t.text.c_str(), PULL_PIVOT, tx, ty, cos_a, sin_a, r, g, b)) return;
+
+    const bool placed = cos_a == 1.0f && sin_a == 0.0f && tx == 0.0f && ty == 0.0f;
+    const int alignment = t.align == Align::Left ? PULL_LEFT : t.align == Align::Right ? PULL_RIGHT : PULL_CENTER;
+    if (t.align != Align::Pivot && placed &&
+        drawPulled(t.text.c_str(), alignment, t.x, t.y, 1.0f, 0.0f, r, g, b)) return;
   }
 
-  if (minx > maxx) return;
+  //Ranges in the static buffer are only known once it is rebuilt on finish
+  int page_counts[1 + FontAtlas::MAX_PAGES] = {};
+  for (const FontAtlas::GlyphQuad& q : t.quads) ++page_counts[q.page];
 
-  const float x_ndc = x - (maxx * kScale);
-  drawTextNDC(std::string(text), x_ndc, y, r, g, b);
+  const TextHandle handle = (TextHandle)(&t - texts_.data());
+  for (int page = 0; page <= FontAtlas::MAX_PAGES; ++page) {
+    if (page_counts[page] == 0) continue;
+    retained_draws_.push_back({ CommandList::size(), handle, page });
+    recordInstances(static_vao_, static_vbo_, page, 0, page_counts[page], r, g, b, cos_a, sin_a, tx, ty);
+  }
 }
@@ -1,29 +1,163 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
 #include "config/AppConfig.hpp"
+#include "capture/DeltaStreamer.hpp"
+#include "capture/FrameCapture.hpp"
+#include "capture/FrameEncoder.hpp"
+#include "capture/SharedFramePublisher.hpp"
 #include "core/ApplicationState.hpp"
+#include "core/FramePipeline.hpp"
 #include "core/InputHandler.hpp"
+#include "core/LatencyMonitor.hpp"
+#include "core/QualityGovernor.hpp"
 #include "core/RenderEngine.hpp"
+#include "core/StartupTrace.hpp"
+#include "core/TaskGraph.hpp"
+#include "core/ThreadPool.hpp"
 #include "compas/CompasRenderer.hpp"
 #include "gfx/TtfTextRenderer.hpp"
-#include "gfx/Shader.hpp"
+#include "gfx/BakedFontFile.hpp"
 #include "ui/HsiUiRenderer.hpp"
 #include "data/HsiData.hpp"
+#include "nav/MagneticModel.hpp"
+#include "gfx/CommandList.hpp"
+#include "gfx/Primitives.hpp"
+#include "gfx/SdfShapes.hpp"
+#include "gfx/FrameUniforms.hpp"
+#include "gfx/InstrumentView.hpp"
+#include "gfx/RenderTarget.hpp"
+#include "gfx/ProgramCache.hpp"
+#include "swr/SoftRasterizer.hpp"
+#include "remote/CommandStreamClient.hpp"
+#include "remote/CommandStreamServer.hpp"
 
 using namespace WindowConfig;
 using namespace DataConfig;
 using namespace FontConfig;
 using namespace ColorRGB;
 
+//Set on the GL thread; the frame builder picks the size up with its input
+static int g_framebuffer_width = WIDTH;
+static int g_framebuffer_height = HEIGHT;
+
 static void framebuffer_size_callback(GLFWwindow*, int w, int h) {
   glViewport(0, 0, w, h);
+  g_framebuffer_width = w;
+  g_framebuffer_height = h;
+}
+
+static FrameInput sampleFrameInput() {
+  FrameInput input;
+  InputHandler::drainEvents(input.events);
+  input.time_s = glfwGetTime();
+  input.width = g_framebuffer_width;
+  input.height = g_framebuffer_height;
+  return input;
 }
 
+//Atlas pixels are used in place from the mapping, so it lives for the whole run
+static BakedFontFile g_baked_fonts;
+
+//Atlas raster scale for instruments drawn pixel_scale times their design size
+static float rasterScaleFor(float pixel_scale) {
+  using namespace ResizeConfig;
+  const float scale = std::round(pixel_scale / RASTER_SCALE_STEP) * RASTER_SCALE_STEP;
+  return std::min(std::max(scale, MIN_RASTER_SCALE), MAX_RASTER_SCALE);
+}
+
+//Re-rasterizes every font for the display's pixel scale; recording thread
+static void rescaleFonts(TtfTextRenderer fonts[], float pixel_scale, int width, int height) {
+  const float scale = rasterScaleFor(pixel_scale);
+  if (fonts[0].rasterScale() == scale) return;
+
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < FONT_COUNT; ++i) {
+    if (!fonts[i].setRasterScale(scale)) std::cerr << "Failed to rasterize font: " << PATHS[i] << "\n";
+  }
+  const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  char line[120];
+  std::snprintf(line, sizeof(line), "Display %dx%d: fonts rasterized at %.3gx in %.1f ms\n", width, height, scale, ms);
+  std::cout << line;
+}
+
+//Internal size and samples the governor's level draws a window of this size at
+static RenderTarget::Format governedFormat(const QualityGovernor& governor, int window_width, int window_height) {
+  RenderTarget::Format format;
+  format.width = std::max(1, (int)std::lround(window_width * governor.resolutionScale()));
+  format.height = std::max(1, (int)std::lround(window_height * governor.resolutionScale()));
+  format.samples = governor.samples();
+  return format;
+}
+
+static void printQualityLevel(const QualityGovernor& governor) {
+  char line[120];
+  std::snprintf(line, sizeof(line), "Quality: level %d (MSAA %dx, %.0f%% resolution)\n",
+                governor.level(), governor.samples(), governor.resolutionScale() * 100.0f);
+  std::cout << line;
+}
+
+//Command-line numbers: the whole argument must parse
+static bool parseInt(const char* text, int& out) {
+  char* end = nullptr;
+  const long v = std::strtol(text, &end, 10);
+  if (end == text || *end != '\0' || v < INT_MIN || v > INT_MAX) return false;
+  out = (int)v;
+  return true;
+}
+
+static bool parseDouble(const char* text, double& out) {
+  char* end = nullptr;
+  out = std::strtod(text, &end);
+  return end != text && *end == '\0' && std::isfinite(out);
+}
+
+//Framebuffer size as seen by the recording thread. Viewports follow every new
+//size at once; settled() reports once when the size has held for
+//ResizeConfig::SETTLE_S, so an interactive resize rebuilds the atlases once.
+struct DisplaySize {
+  int width;
+  int height;
+  double changed_at = -1.0;
+
+  bool update(int w, int h, double time_s) {
+    if (w == width && h == height) return false;
+    width = w;
+    height = h;
+    changed_at = time_s;
+    Primitives::setViewport(width, height);
+    SdfShapes::setViewport(width, height);
+    FrameUniforms::setViewport(width, height);
+    return true;
+  }
+
+  bool settled(double time_s) {
+    if (changed_at < 0.0 || time_s - changed_at < ResizeConfig::SETTLE_S) return false;
+    changed_at = -1.0;
+    return true;
+  }
+};
+
 bool initializeFonts(TtfTextRenderer fonts[]) {
+  if (!g_baked_fonts.isOpen() && !g_baked_fonts.open(BAKED_ATLAS_PATH)) {
+    std::cerr << "No baked font atlas at " << BAKED_ATLAS_PATH << ", rasterizing fonts at startup\n";
+  }
+
   for (int i = 0; i < FONT_COUNT; ++i) {
-    if (!fonts[i].init(PATHS[i], SIZES[i])) {
+    if (!fonts[i].init(PATHS[i], SIZES[i], &g_baked_fonts)) {
       std::cerr << "Failed to init font: " << PATHS[i] << "\n";
       return false;
     }
@@ -31,71 +165,153 @@ bool initializeFonts(TtfTextRenderer fonts[]) {
   return true;
 }
 
+//Startup task graph: CPU work (atlas rasterization or baked lookup, compass
+//geometry, WMM coefficients) runs on a pool while the context thread creates
+//the window and uploads each font as soon as its atlas is ready. The window
+//starts at window_width x window_height and may be resized; instruments are
+//always laid out at WIDTH x HEIGHT, with atlases rasterized at raster_scale.
+//A governed window has no samples of its own; RenderTarget draws the MSAA.
 bool initializeApplication(GLFWwindow*& window, CompasRenderer& compas,
-                          TtfTextRenderer fonts[], Shader& shader) {
-  if (!glfwInit()) {
-    std::cerr << "GLFW init failed\n";
-    return false;
-  }
+                          TtfTextRenderer fonts[], MagneticModel& magnetic_model,
+                          int window_width = WIDTH, int window_height = HEIGHT, float raster_scale = 1.0f,
+                          int window_samples = 4) {
+  using Affinity = TaskGraph::Affinity;
 
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-  glfwWindowHint(GLFW_SAMPLES, 4);
+  TaskGraph graph;
+  bool glfw_ready = false;
 
-  window = glfwCreateWindow(WIDTH, HEIGHT, TITLE, nullptr, nullptr);
-  if (!window) {
-    std::cerr << "Create window failed\n";
-    glfwTerminate();
-    return false;
-  }
+  const TaskGraph::TaskId context = graph.add("context", Affinity::Main, [&] {
+    {
+      StartupTrace::Scope scope("glfw_init");
+      if (!glfwInit()) {
+        std::cerr << "GLFW init failed\n";
+        return false;
+      }
+    }
+    glfw_ready = true;
 
-  glfwMakeContextCurrent(window);
-  glfwSetWindowSizeLimits(window, WIDTH, HEIGHT, WIDTH, HEIGHT);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_SAMPLES, window_samples);
 
-  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-    std::cerr << "GLAD load failed\n";
-    glfwDestroyWindow(window);
-    glfwTerminate();
-    return false;
-  }
+    {
+      StartupTrace::Scope scope("context_create");
+      window = glfwCreateWindow(window_width, window_height, TITLE, nullptr, nullptr);
+      if (!window) {
+        std::cerr << "Create window failed\n";
+        return false;
+      }
 
-  glEnable(GL_MULTISAMPLE);
-  glEnable(GL_LINE_SMOOTH);
-  glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+      glfwMakeContextCurrent(window);
+      glfwSetWindowSizeLimits(window, ResizeConfig::MIN_WIDTH, ResizeConfig::MIN_HEIGHT,
+                              GLFW_DONT_CARE, GLFW_DONT_CARE);
+    }
+
+    {
+      StartupTrace::Scope scope("glad_load");
+      if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        std::cerr << "GLAD load failed\n";
+        return false;
+      }
+    }
+
+    if (ProgramCacheConfig::ENABLED) {
+      StartupTrace::Scope scope("program_cache_init");
+      ProgramCache::init((GLADloadproc)glfwGetProcAddress, ProgramCacheConfig::DIRECTORY);
+    }
+
+    glEnable(GL_MULTISAMPLE);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    return true;
+  });
+
+  //Initialize line/shape batcher and analytic shape pass
+  graph.add("primitives", Affinity::Main, [window_width, window_height] {
+    if (!FrameUniforms::init(window_width, window_height) || !Primitives::init(window_width, window_height) ||
+        !SdfShapes::init(window_width, window_height)) {
+      std::cerr << "Primitives init failed\n";
+      return false;
+    }
+    return true;
+  }, { context });
 
   //Initialize CompasRenderer
-  if (!compas.init(WIDTH, HEIGHT)) {
-    std::cerr << "CompasRenderer init failed\n";
-    glfwDestroyWindow(window);
-    glfwTerminate();
-    return false;
-  }
+  graph.add("compass", Affinity::Worker, [&] {
+    if (!compas.init(WIDTH, HEIGHT)) {
+      std::cerr << "CompasRenderer init failed\n";
+      return false;
+    }
+    return true;
+  });
+
+  //Navdata is optional; also builds the grid tile for the start position
+  graph.add("navdata", Affinity::Worker, [&] {
+    {
+      StartupTrace::Scope scope("wmm_load", MagneticConfig::COF_PATH);
+      if (!magnetic_model.load(MagneticConfig::COF_PATH)) {
+        scope.setDetail("missing");
+        std::cerr << "Magnetic model unavailable, COG shown without variation\n";
+        return true;
+      }
+    }
+
+    StartupTrace::Scope scope("wmm_grid_tile");
+    magnetic_model.variationDeg(DataConfig::GPS_LATITUDE, DataConfig::GPS_LONGITUDE);
+    return true;
+  });
 
   //Initialize Fonts
-  if (!initializeFonts(fonts)) {
-    glfwDestroyWindow(window);
-    glfwTerminate();
+  const TaskGraph::TaskId baked = graph.add("baked_fonts", Affinity::Worker, [] {
+    StartupTrace::Scope scope("baked_atlas_open", BAKED_ATLAS_PATH);
+    if (!g_baked_fonts.isOpen() && !g_baked_fonts.open(BAKED_ATLAS_PATH)) {
+      std::cerr << "No baked font atlas at " << BAKED_ATLAS_PATH << ", rasterizing fonts at startup\n";
+    }
+    return true;
+  });
+
+  char name[32];
+  for (int i = 0; i < FONT_COUNT; ++i) {
+    std::snprintf(name, sizeof(name), "font_prepare_%d", i);
+    const TaskGraph::TaskId prepare = graph.add(name, Affinity::Worker, [fonts, i, raster_scale] {
+      if (!fonts[i].prepare(PATHS[i], SIZES[i], &g_baked_fonts, raster_scale)) {
+        std::cerr << "Failed to init font: " << PATHS[i] << "\n";
+        return false;
+      }
+      return true;
+    }, { baked });
+
+    std::snprintf(name, sizeof(name), "font_upload_%d", i);
+    graph.add(name, Affinity::Main, [fonts, i] {
+      if (!fonts[i].upload()) {
+        std::cerr << "Failed to upload font: " << PATHS[i] << "\n";
+        return false;
+      }
+      return true;
+    }, { prepare, context });
+  }
+
+  ThreadPool pool;
+  if (!graph.run(pool)) {
+    if (window) glfwDestroyWindow(window);
+    if (glfw_ready) glfwTerminate();
+    window = nullptr;
     return false;
   }
 
-  //Setup Shader
-  const char* vs = R"(#version 330 core
-    layout (location = 0) in vec2 aPos;
-    void main() { gl_Position = vec4(aPos, 0.0, 1.0); }
-  )";
-  const char* fs = R"(#version 330 core
-    uniform vec3 uColor;
-    uniform float uAlpha;
-    out vec4 FragColor;
-    void main() { FragColor = vec4(uColor, uAlpha); }
-  )";
-  shader.build(vs, fs);
-
-  glViewport(0, 0, WIDTH, HEIGHT);
+  ProgramCache::report();
+
+  //Keys for draw-command streaming; a head exports the same ones
+  for (int i = 0; i < FONT_COUNT; ++i) {
+    fonts[i].exportRemote((uint16_t)(CommandList::REMOTE_FONT_FIRST + i));
+  }
+
+  glViewport(0, 0, window_width, window_height);
+  g_framebuffer_width = window_width;
+  g_framebuffer_height = window_height;
   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+  InputHandler::install(window);
 
   return true;
 }
@@ -109,15 +325,353 @@ void initializeApplicationState(ApplicationState& state) {
   state.wp_left = {state.wp_left_bearing, DataConfig::WP_LEFT_DISTANCE, DataConfig::WP_LEFT_NAME, DataConfig::WP_LEFT_RUNWAY, DataConfig::WP_LEFT_APP_FREQ, DataConfig::WP_LEFT_INFO_FREQ, DisplayLayout::LEFT_OFFSET, DataConfig::WP_LEFT_Y, YELLOW.r, YELLOW.g, YELLOW.b};
   state.wp_right = {state.wp_right_bearing, DataConfig::WP_RIGHT_DISTANCE, DataConfig::WP_RIGHT_NAME, DataConfig::WP_RIGHT_RUNWAY, DataConfig::WP_RIGHT_APP_FREQ, DataConfig::WP_RIGHT_INFO_FREQ, DisplayLayout::RIGHT_OFFSET, DataConfig::WP_RIGHT_Y, GREEN.r, GREEN.g, GREEN.b};
   state.bug = {state.bug_heading, DataConfig::BUG_X, DataConfig::BUG_Y, MAGENTA.r, MAGENTA.g, MAGENTA.b};
+
+  state.latitude_deg = DataConfig::GPS_LATITUDE;
+  state.longitude_deg = DataConfig::GPS_LONGITUDE;
+  state.cog_true = DataConfig::COURSE_COG;
+}
+
+//Renders one frame with the CPU rasterizer; no GL context is created
+int runSoftwareFrame(const char* out_path) {
+  SoftRasterizer soft(WIDTH, HEIGHT, SoftwareConfig::THREADS);
+  Primitives::bindSoftwareTarget(&soft);
+  SdfShapes::setViewport(WIDTH, HEIGHT);
+  FrameUniforms::init(WIDTH, HEIGHT);
+
+  CompasRenderer compas;
+  TtfTextRenderer fonts[FONT_COUNT];
+
+  if (!compas.init(WIDTH, HEIGHT) || !initializeFonts(fonts)) {
+    Primitives::bindSoftwareTarget(nullptr);
+    return 1;
+  }
+
+  HsiUiRenderer ui_renderer(fonts[INFO_VALUE], fonts[INFO_LABEL],
+                            fonts[WAYPOINT_NAME], fonts[WAYPOINT_BEARING],
+                            fonts[WAYPOINT_INFO], fonts[IAS_ALT_VALUE], fonts[IAS_ALT_LABEL]);
+
+  ApplicationState state;
+  initializeApplicationState(state);
+  compas.setHeadingDeg(state.heading_deg);
+
+  MagneticModel magnetic_model;
+  if (magnetic_model.load(MagneticConfig::COF_PATH)) {
+    state.magnetic_variation = magnetic_model.variationDeg(state.latitude_deg, state.longitude_deg);
+  }
+  state.updateFromHeading();
+
+  RenderEngine render_engine;
+  render_engine.renderFrame(compas, fonts, ui_renderer, state);
+  soft.flush();
+
+  Primitives::bindSoftwareTarget(nullptr);
+
+  if (!soft.writePpm(out_path)) {
+    std::cerr << "Failed to write frame: " << out_path << "\n";
+    return 1;
+  }
+  return 0;
+}
+
+void shutdownGraphics(GLFWwindow* window) {
+  CommandList::shutdown();
+  TtfTextRenderer::shutdownShared();
+  SdfShapes::shutdown();
+  Primitives::shutdown();
+  FrameUniforms::shutdown();
+  glfwDestroyWindow(window);
+  glfwTerminate();
+}
+
+//Display head: replays the draw commands of another HSI process with this
+//process's renderers and fonts until the stream ends or the window closes.
+//Commands carry the sender's viewport, so the window keeps its size.
+int runRemoteHead(const CommandProtocol::Endpoint& endpoint, bool vsync, int width, int height) {
+  GLFWwindow* window = nullptr;
+  CompasRenderer compas;
+  TtfTextRenderer fonts[FONT_COUNT];
+  MagneticModel magnetic_model;
+  if (!initializeApplication(window, compas, fonts, magnetic_model, width, height)) return 1;
+  glfwSetWindowSizeLimits(window, width, height, width, height);
+  glfwSwapInterval(vsync ? 1 : 0);
+
+  CommandStreamClient client;
+  int status = 1;
+  if (client.connect(endpoint, RemoteConfig::CONNECT_TIMEOUT_S)) {
+    status = 0;
+    while (!glfwWindowShouldClose(window)) {
+      CommandList::Frame* frame = client.next();
+      if (!frame) break;
+      CommandList::submit(frame);
+      glfwSwapBuffers(window);
+      glfwPollEvents();
+    }
+    client.report(std::cout);
+  }
+
+  shutdownGraphics(window);
+  return status;
 }
 
-int main() {
+//Fleet wall: count independent instruments share the fonts, programs and
+//buffers, each drawn into its grid cell through InstrumentView. Every
+//instrument records into the same per-layer batches, so a frame issues the
+//same draws for one instrument as for a hundred. Frames are built on the GL
+//thread; headings turn at per-instrument rates. The grid is laid out again
+//when the window is resized.
+int runFleet(int count, bool vsync, double fps_cap, int width, int height, bool governed, double budget_ms) {
+  using namespace FleetConfig;
+
+  GLFWwindow* window = nullptr;
+  CompasRenderer compas;
+  TtfTextRenderer fonts[FONT_COUNT];
+  MagneticModel magnetic_model;
+  DisplaySize display = { width, height };
+  const float raster_scale = rasterScaleFor(InstrumentView::cell(0, count, width, height, WIDTH, HEIGHT).pixel_scale);
+  if (!initializeApplication(window, compas, fonts, magnetic_model, width, height, raster_scale,
+                             governed ? 0 : 4)) return 1;
+  glfwSwapInterval(vsync ? 1 : 0);
+
+  struct Instrument {
+    ApplicationState state;
+    CompasRenderer compas;
+    HsiUiRenderer ui;
+    RenderEngine engine;
+    InstrumentView::Placement placement;
+    float start_heading;
+    float turn_rate_dps;
+
+    explicit Instrument(TtfTextRenderer fonts[])
+        : ui(fonts[INFO_VALUE], fonts[INFO_LABEL], fonts[WAYPOINT_NAME], fonts[WAYPOINT_BEARING],
+             fonts[WAYPOINT_INFO], fonts[IAS_ALT_VALUE], fonts[IAS_ALT_LABEL]) {}
+  };
+
+  std::vector<std::unique_ptr<Instrument>> fleet;
+  for (int i = 0; i < count; ++i) {
+    std::unique_ptr<Instrument> hsi(new Instrument(fonts));
+    if (!hsi->compas.init(WIDTH, HEIGHT)) {
+      shutdownGraphics(window);
+      return 1;
+    }
+    initializeApplicationState(hsi->state);
+    hsi->state.bug_heading = std::fmod(83.0f * i, 360.0f);
+    hsi->state.wp_left_bearing = std::fmod(347.0f + 29.0f * i, 360.0f);
+    hsi->state.wp_right_bearing = std::fmod(324.0f + 53.0f * i, 360.0f);
+    hsi->state.updateFromHeading();
+    hsi->placement = InstrumentView::cell(i, count, width, height, WIDTH, HEIGHT);
+    hsi->start_heading = std::fmod(47.0f * i, 360.0f);
+    hsi->turn_rate_dps = (MIN_TURN_RATE_DPS + (MAX_TURN_RATE_DPS - MIN_TURN_RATE_DPS) * (float)(i % 7) / 6.0f) *
+                         (i % 2 ? -1.0f : 1.0f);
+    fleet.push_back(std::move(hsi));
+  }
+  std::cout << "Fleet: " << count << " instruments in a " << width << "x" << height << " window\n";
+
+  using Clock = std::chrono::steady_clock;
+  const Clock::duration frame_interval = fps_cap > 0.0
+      ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / fps_cap))
+      : Clock::duration::zero();
+  Clock::time_point next_frame = Clock::now();
+
+  RenderTarget target;
+  QualityGovernor governor;
+  if (governed) governor.init(budget_ms);
+
+  int frames = 0;
+  double record_ms = 0.0;
+  double submit_ms = 0.0;
+  CommandList::Stats stats = {};
+
+  while (!glfwWindowShouldClose(window)) {
+    if (frame_interval > Clock::duration::zero()) {
+      std::this_thread::sleep_until(next_frame);
+      next_frame = std::max(next_frame + frame_interval, Clock::now());
+    }
+
+    const double now = glfwGetTime();
+    const float t = (float)now;
+    const Clock::time_point start = Clock::now();
+
+    RenderTarget::Format format = { g_framebuffer_width, g_framebuffer_height, 0 };
+    if (governed) format = governedFormat(governor, g_framebuffer_width, g_framebuffer_height);
+
+    if (display.update(format.width, format.height, now)) {
+      for (int i = 0; i < count; ++i) {
+        fleet[i]->placement = InstrumentView::cell(i, count, display.width, display.height, WIDTH, HEIGHT);
+      }
+    }
+    if (display.settled(now)) rescaleFonts(fonts, fleet[0]->placement.pixel_scale, display.width, display.height);
+
+    RenderEngine::beginFrame();
+    for (std::unique_ptr<Instrument>& hsi : fleet) {
+      float heading = std::fmod(hsi->start_heading + hsi->turn_rate_dps * t, 360.0f);
+      if (heading < 0.0f) heading += 360.0f;
+      hsi->state.heading_deg = heading;
+      hsi->compas.setHeadingDeg(heading);
+      hsi->state.updateFromHeading();
+
+      InstrumentView::set(hsi->placement);
+      hsi->engine.renderInstrument(hsi->compas, fonts, hsi->ui, hsi->state);
+    }
+    InstrumentView::reset();
+    CommandList::Frame* frame = CommandList::finish();
+
+    const Clock::time_point recorded = Clock::now();
+    if (governed) {
+      governor.beginFrame();
+      target.bind(format, g_framebuffer_width, g_framebuffer_height);
+    }
+    CommandList::submit(frame);
+    if (governed) {
+      target.present();
+      governor.endFrame();
+    }
+    const Clock::time_point submitted = Clock::now();
+
+    record_ms += std::chrono::duration<double, std::milli>(recorded - start).count();
+    submit_ms += std::chrono::duration<double, std::milli>(submitted - recorded).count();
+    stats = CommandList::lastStats();
+    ++frames;
+
+    glfwSwapBuffers(window);
+    if (governed && governor.poll()) printQualityLevel(governor);
+    glfwPollEvents();
+  }
+
+  char line[240];
+  std::snprintf(line, sizeof(line),
+                "Fleet: %d instruments, %d draws (%d commands), %d program and %d texture changes per frame; "
+                "record %.2f ms, submit %.2f ms per frame\n",
+                count, stats.draws, stats.commands, stats.program_changes, stats.texture_changes,
+                frames ? record_ms / frames : 0.0, frames ? submit_ms / frames : 0.0);
+  std::cout << line;
+  if (governed) {
+    governor.report(std::cout);
+    governor.shutdown();
+  }
+  target.shutdown();
+
+  fleet.clear();
+  shutdownGraphics(window);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  StartupTrace::begin();
+
+  const char* startup_report = nullptr;
+  bool exit_after_first_frame = false;
+  bool pipelined = PipelineConfig::ENABLED;
+  int pipeline_depth = PipelineConfig::MAX_QUEUED_FRAMES;
+  double sim_hz = TimingConfig::SIM_HZ;
+  double fps_cap = TimingConfig::RENDER_HZ_CAP;
+  bool vsync = TimingConfig::VSYNC;
+  bool measure_latency = LatencyConfig::ENABLED;
+  const char* record_path = nullptr;
+  const char* shm_name = nullptr;
+  int delta_port = 0;
+  const char* command_stream = nullptr;
+  const char* remote_head = nullptr;
+  int fleet_count = 0;
+  int window_width = 0;    // 0: the mode's default size
+  int window_height = 0;
+  bool use_governor = QualityConfig::ENABLED;
+  double budget_ms = QualityConfig::BUDGET_MS;
+
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--software") == 0 && i + 1 < argc) {
+      return runSoftwareFrame(argv[i + 1]);
+    }
+    if (std::strcmp(argv[i], "--startup-report") == 0 && i + 1 < argc) {
+      startup_report = argv[++i];
+    } else if (std::strcmp(argv[i], "--exit-after-first-frame") == 0) {
+      exit_after_first_frame = true;
+    } else if (std::strcmp(argv[i], "--no-pipeline") == 0) {
+      pipelined = false;
+    } else if (std::strcmp(argv[i], "--pipeline-depth") == 0 && i + 1 < argc) {
+      if (!parseInt(argv[++i], pipeline_depth) || pipeline_depth < 1 || pipeline_depth > PipelineConfig::MAX_DEPTH) {
+        std::cerr << "Bad pipeline depth: " << argv[i] << " (expected 1 to " << PipelineConfig::MAX_DEPTH << ")\n";
+        return 1;
+      }
+    } else if (std::strcmp(argv[i], "--sim-hz") == 0 && i + 1 < argc) {
+      if (!parseDouble(argv[++i], sim_hz) || !(sim_hz > 0.0)) {
+        std::cerr << "Bad simulation rate: " << argv[i] << " (expected Hz > 0)\n";
+        return 1;
+      }
+    } else if (std::strcmp(argv[i], "--fps-cap") == 0 && i + 1 < argc) {
+      if (!parseDouble(argv[++i], fps_cap) || fps_cap < 0.0) {
+        std::cerr << "Bad frame rate cap: " << argv[i] << " (expected Hz >= 0, 0 = uncapped)\n";
+        return 1;
+      }
+    } else if (std::strcmp(argv[i], "--no-vsync") == 0) {
+      vsync = false;
+    } else if (std::strcmp(argv[i], "--latency-report") == 0) {
+      measure_latency = true;
+    } else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+      record_path = argv[++i];
+    } else if (std::strcmp(argv[i], "--shm-output") == 0) {
+      shm_name = (i + 1 < argc && argv[i + 1][0] == '/') ? argv[++i] : SharedFrameConfig::NAME;
+    } else if (std::strcmp(argv[i], "--delta-stream") == 0) {
+      delta_port = (i + 1 < argc && std::atoi(argv[i + 1]) > 0) ? std::atoi(argv[++i]) : DeltaStreamConfig::PORT;
+    } else if (std::strcmp(argv[i], "--command-stream") == 0) {
+      command_stream = (i + 1 < argc && argv[i + 1][0] != '-') ? argv[++i] : RemoteConfig::ENDPOINT;
+    } else if (std::strcmp(argv[i], "--remote-head") == 0) {
+      remote_head = (i + 1 < argc && argv[i + 1][0] != '-') ? argv[++i] : RemoteConfig::ENDPOINT;
+    } else if (std::strcmp(argv[i], "--fleet") == 0) {
+      fleet_count = (i + 1 < argc && std::atoi(argv[i + 1]) > 0) ? std::atoi(argv[++i]) : FleetConfig::DEFAULT_COUNT;
+    } else if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      if (std::sscanf(argv[++i], "%dx%d", &window_width, &window_height) != 2) {
+        std::cerr << "Bad size: " << argv[i] << " (expected WxH)\n";
+        return 1;
+      }
+      window_width = std::max(window_width, ResizeConfig::MIN_WIDTH);
+      window_height = std::max(window_height, ResizeConfig::MIN_HEIGHT);
+    } else if (std::strcmp(argv[i], "--no-governor") == 0) {
+      use_governor = false;
+    } else if (std::strcmp(argv[i], "--frame-budget") == 0 && i + 1 < argc) {
+      if (!parseDouble(argv[++i], budget_ms) || !(budget_ms > 0.0)) {
+        std::cerr << "Bad frame budget: " << argv[i] << " (expected milliseconds > 0)\n";
+        return 1;
+      }
+    }
+  }
+
+  CommandProtocol::Endpoint endpoint;
+  if ((remote_head || command_stream) &&
+      !CommandProtocol::parseEndpoint(remote_head ? remote_head : command_stream, endpoint)) {
+    std::cerr << "Bad endpoint: " << (remote_head ? remote_head : command_stream)
+              << " (expected unix:/path or [host:]port)\n";
+    return 1;
+  }
+  if (remote_head) return runRemoteHead(endpoint, vsync, window_width ? window_width : WIDTH,
+                                         window_height ? window_height : HEIGHT);
+  if (fleet_count > 0) {
+    return runFleet(std::min(fleet_count, FleetConfig::MAX_COUNT), vsync, fps_cap,
+                    window_width ? window_width : FleetConfig::WINDOW_WIDTH,
+                    window_height ? window_height : FleetConfig::WINDOW_HEIGHT, use_governor, budget_ms);
+  }
+  if (!window_width) {
+    window_width = WIDTH;
+    window_height = HEIGHT;
+  }
+
+  //Cold-start benchmarking wants the report even when no path was given
+  if (exit_after_first_frame && !startup_report) startup_report = "-";
+
   GLFWwindow* window = nullptr;
   CompasRenderer compas;
   TtfTextRenderer fonts[FONT_COUNT];
-  Shader shader;
+  MagneticModel magnetic_model;
+
+  //Quality governor: frames are drawn at its MSAA level and internal size and
+  //presented into a single-sampled window. Not while streaming commands:
+  //heads replay the sender's viewport
+  const bool governed = use_governor && !command_stream;
 
-  if (!initializeApplication(window, compas, fonts, shader)) {
+  //Fonts start at the raster scale of the starting size
+  InstrumentView::Placement placement = InstrumentView::cell(0, 1, window_width, window_height, WIDTH, HEIGHT);
+  if (!initializeApplication(window, compas, fonts, magnetic_model, window_width, window_height,
+                             rasterScaleFor(placement.pixel_scale), governed ? 0 : 4)) {
+    if (startup_report) StartupTrace::writeJson(startup_report);
     return 1;
   }
 
@@ -130,26 +684,224 @@ int main() {
   compas.setHeadingDeg(state.heading_deg);
 
   InputHandler input_handler;
-  RenderEngine render_engine(shader);
+  RenderEngine render_engine;
 
-  double last_time = glfwGetTime();
+  glfwSwapInterval(vsync ? 1 : 0);
 
-  while (!glfwWindowShouldClose(window)) {
-    double current_time = glfwGetTime();
-    float delta_time = (float)(current_time - last_time);
-    last_time = current_time;
+  //Fixed-rate simulation: input events are applied in whole ticks of sim_step
+  //seconds and frames render between the last two ticks
+  const double sim_step = 1.0 / sim_hz;
+  double sim_time = glfwGetTime();   // end of the last tick
+  SimulationState sim_prev;
+  sim_prev.heading_deg = state.heading_deg;
+  sim_prev.bug_heading = state.bug_heading;
+  sim_prev.wp_left_bearing = state.wp_left_bearing;
+  sim_prev.wp_right_bearing = state.wp_right_bearing;
+  sim_prev.cdi_offset = compas.getPerpLineOffset();
+  sim_prev.to_flag = compas.getToFromFlagState();
+  SimulationState sim = sim_prev;
 
-    input_handler.processInput(window, state.heading_deg, state.bug_heading,
-                               state.wp_left_bearing, state.wp_right_bearing, compas, delta_time);
+  //Builds one frame into the command list; runs on the pipeline's builder
+  //thread, which owns the state and renderers' CPU side from then on. The
+  //instrument is letterboxed into the framebuffer at any size.
+  DisplaySize display = { window_width, window_height };
+
+  auto build_frame = [&](const FrameInput& input) {
+    if (display.update(input.width, input.height, input.time_s)) {
+      placement = InstrumentView::cell(0, 1, display.width, display.height, WIDTH, HEIGHT);
+    }
+    if (display.settled(input.time_s)) rescaleFonts(fonts, placement.pixel_scale, display.width, display.height);
+
+    input_handler.queue(input.events);
+
+    int steps = 0;
+    while (sim_time + sim_step <= input.time_s && steps < TimingConfig::MAX_SIM_STEPS) {
+      sim_prev = sim;
+      sim_time += sim_step;
+      input_handler.processInput(sim, sim_time, (float)sim_step);
+      ++steps;
+    }
+    //After a stall, skip ahead instead of catching up
+    if (input.time_s - sim_time >= sim_step) {
+      sim_time = input.time_s - std::fmod(input.time_s - sim_time, sim_step);
+    }
+
+    const float alpha = (float)((input.time_s - sim_time) / sim_step);
+    state.interpolate(sim_prev, sim, alpha);
+    compas.setHeadingDeg(state.heading_deg);
+    compas.setPerpLineOffset(sim_prev.cdi_offset + (sim.cdi_offset - sim_prev.cdi_offset) * alpha);
+    compas.setToFromFlag(sim.to_flag);
+
+    state.magnetic_variation = magnetic_model.variationDeg(state.latitude_deg, state.longitude_deg);
     state.updateFromHeading();
 
+    InstrumentView::set(placement);
     render_engine.renderFrame(compas, fonts, ui_renderer, state);
+    return input_handler.takeAppliedInputTime();
+  };
+
+  //Opened before the first frame: retained streams must hold everything sent
+  CommandStreamServer command_server;
+  if (command_stream) command_server.open(endpoint, RemoteConfig::MAX_QUEUED_FRAMES);
+
+  //Frames in the pipeline are recorded at the internal size of the level that
+  //was current when their input was sampled, and drawn at that format
+  RenderTarget target;
+  QualityGovernor governor;
+  if (governed) governor.init(budget_ms);
+  std::deque<RenderTarget::Format> formats;
 
+  auto govern = [&](FrameInput input) {
+    if (governed) {
+      const RenderTarget::Format format = governedFormat(governor, input.width, input.height);
+      input.width = format.width;
+      input.height = format.height;
+      formats.push_back(format);
+    }
+    return input;
+  };
+
+  auto submit_frame = [&](CommandList::Frame* commands) {
+    if (governed) {
+      governor.beginFrame();
+      target.bind(formats.front(), g_framebuffer_width, g_framebuffer_height);
+      formats.pop_front();
+    }
+    command_server.publish(commands);
+    CommandList::submit(commands);
+    if (governed) {
+      target.present();
+      governor.endFrame();
+    }
+  };
+
+  //First frame is built and shown directly so the startup trace measures it alone
+  {
+    StartupTrace::Scope scope("first_render");
+    build_frame(govern(sampleFrameInput()));
+    submit_frame(CommandList::finish());
+  }
+  {
+    StartupTrace::Scope scope("first_swap");
     glfwSwapBuffers(window);
+  }
+
+  StartupTrace::firstFrame();
+  std::cout << "Time to first frame: " << StartupTrace::timeToFirstFrameMs() << " ms\n";
+  if (startup_report) StartupTrace::writeJson(startup_report);
+  if (exit_after_first_frame) glfwSetWindowShouldClose(window, GLFW_TRUE);
+
+  glfwPollEvents();
+
+  //The GL thread samples input, submits the oldest finished frame and swaps
+  FramePipeline pipeline(pipelined ? pipeline_depth : 0, build_frame);
+
+  using Clock = std::chrono::steady_clock;
+  const Clock::duration frame_interval = fps_cap > 0.0
+      ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / fps_cap))
+      : Clock::duration::zero();
+  Clock::time_point next_frame = Clock::now();
+
+  LatencyMonitor latency;
+  if (measure_latency) latency.init();
+  double next_report = glfwGetTime() + LatencyConfig::REPORT_INTERVAL_S;
+
+  //Readback through a PBO ring; the encoder thread converts and writes, the
+  //publisher copies into the shared-memory ring, the streamer sends tile deltas
+  FrameEncoder encoder;
+  SharedFramePublisher publisher;
+  DeltaStreamer streamer;
+  FrameCapture capture;
+  //Captured frames have a fixed size, so the window keeps its size while capturing
+  if ((record_path || shm_name || delta_port) && capture.init(window_width, window_height, RecordConfig::PBO_COUNT)) {
+    glfwSetWindowSizeLimits(window, window_width, window_height, window_width, window_height);
+    if (record_path &&
+        encoder.open(record_path, window_width, window_height, RecordConfig::FPS, RecordConfig::MAX_QUEUED_FRAMES)) {
+      capture.addSink([&encoder](const unsigned char* rgba, int w, int h, Clock::time_point) {
+        encoder.submit(rgba, w, h);
+      });
+    }
+    if (shm_name && publisher.open(shm_name, window_width, window_height, SharedFrameConfig::SLOT_COUNT)) {
+      capture.addSink([&publisher](const unsigned char* rgba, int w, int h, Clock::time_point drawn) {
+        publisher.publish(rgba, w, h, drawn);
+      });
+    }
+    if (delta_port && streamer.open(DeltaStreamConfig::ADDRESS, delta_port, window_width, window_height,
+                                    DeltaStreamConfig::TILE_SIZE, DeltaStreamConfig::MAX_QUEUED_FRAMES)) {
+      capture.addSink([&streamer](const unsigned char* rgba, int w, int h, Clock::time_point) {
+        streamer.submit(rgba, w, h);
+      });
+    }
+  }
+  const bool recording = capture.active();
+
+  while (!glfwWindowShouldClose(window)) {
+    //Render rate cap; independent of the simulation rate
+    if (frame_interval > Clock::duration::zero()) {
+      std::this_thread::sleep_until(next_frame);
+      next_frame = std::max(next_frame + frame_interval, Clock::now());
+    }
+
+    const BuiltFrame frame = pipeline.advance(govern(sampleFrameInput()));
+    if (frame.commands) {
+      submit_frame(frame.commands);
+      if (recording) capture.capture();
+      glfwSwapBuffers(window);
+      if (measure_latency) latency.frameSwapped(frame.input_time_s, glfwGetTime());
+      if (recording) capture.collect();
+    }
+    if (governed && governor.poll()) printQualityLevel(governor);
+
+    if (measure_latency) {
+      latency.poll();
+      if (glfwGetTime() >= next_report) {
+        latency.report(std::cout);
+        next_report += LatencyConfig::REPORT_INTERVAL_S;
+      }
+    }
+
     glfwPollEvents();
   }
 
-  glfwDestroyWindow(window);
-  glfwTerminate();
+  pipeline.stop();
+
+  if (recording) {
+    capture.collect(true);
+    capture.report(std::cout);
+    if (encoder.isOpen()) {
+      encoder.close();
+      std::cout << "Recording: " << encoder.written() << " frames written to " << record_path << ", "
+                << encoder.dropped() << " dropped (encoder queue full)\n";
+    }
+    if (publisher.isOpen()) {
+      publisher.report(std::cout);
+      publisher.close();
+    }
+    if (streamer.isOpen()) {
+      streamer.close();
+      streamer.report(std::cout);
+    }
+  }
+  capture.shutdown();
+
+  if (command_server.isOpen()) {
+    command_server.close();
+    command_server.report(std::cout, display.width, display.height);
+  }
+
+  if (measure_latency) {
+    glFinish();
+    latency.poll();
+    latency.report(std::cout);
+    latency.shutdown();
+  }
+
+  if (governed) {
+    governor.report(std::cout);
+    governor.shutdown();
+  }
+  target.shutdown();
+
+  shutdownGraphics(window);
   return 0;
 }
\ No newline at end of file
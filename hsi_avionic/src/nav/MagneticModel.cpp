@@ -0,0 +1,258 @@
+#include "nav/MagneticModel.hpp"
+#include "config/AppConfig.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cmath>
+#include <ctime>
+
+namespace {
+  constexpr double kPi = 3.14159265358979323846;
+  constexpr double kDegToRad = kPi / 180.0;
+
+  //WGS84 ellipsoid and geomagnetic reference radius (km)
+  constexpr double kEllipsoidA = 6378.137;
+  constexpr double kFlattening = 1.0 / 298.257223563;
+  constexpr double kEccSq = kFlattening * (2.0 - kFlattening);
+  constexpr double kRefRadius = 6371.2;
+
+  float wrap360(float deg) {
+    deg = std::fmod(deg, 360.0f);
+    if (deg < 0.0f) deg += 360.0f;
+    return deg;
+  }
+
+  float wrap180(float deg) {
+    deg = wrap360(deg + 180.0f) - 180.0f;
+    return deg;
+  }
+}
+
+bool MagneticModel::load(const std::string& cof_path) {
+  std::ifstream f(cof_path);
+  if (!f) {
+    std::cerr << "Failed to read WMM coefficients: " << cof_path << "\n";
+    return false;
+  }
+
+  std::string line;
+  if (!std::getline(f, line)) return false;
+
+  std::istringstream header(line);
+  if (!(header >> epoch_)) {
+    std::cerr << "Invalid WMM header: " << cof_path << "\n";
+    return false;
+  }
+
+  struct Row { int n, m; double g, h, gd, hd; };
+  std::vector<Row> rows;
+  int max_n = 0;
+
+  while (std::getline(f, line)) {
+    if (line.compare(0, 4, "9999") == 0) break;
+
+    Row r{};
+    std::istringstream ls(line);
+    if (!(ls >> r.n >> r.m >> r.g >> r.h >> r.gd >> r.hd)) continue;
+    if (r.n < 1 || r.m < 0 || r.m > r.n) continue;
+
+    rows.push_back(r);
+    if (r.n > max_n) max_n = r.n;
+  }
+
+  if (max_n == 0) {
+    std::cerr << "No WMM coefficients in: " << cof_path << "\n";
+    return false;
+  }
+
+  max_degree_ = max_n;
+  const size_t count = (size_t)(max_n + 1) * (size_t)(max_n + 1);
+  g_.assign(count, 0.0);
+  h_.assign(count, 0.0);
+  g_dot_.assign(count, 0.0);
+  h_dot_.assign(count, 0.0);
+
+  for (const Row& r : rows) {
+    const int i = index(r.n, r.m);
+    g_[i] = r.g;
+    h_[i] = r.h;
+    g_dot_[i] = r.gd;
+    h_dot_[i] = r.hd;
+  }
+
+  nodes_per_side_ = MagneticConfig::GRID_TILE_DEG / MagneticConfig::GRID_STEP_DEG + 1;
+  setDecimalYear(currentDecimalYear());
+  return true;
+}
+
+void MagneticModel::setDecimalYear(float year) {
+  if (year == decimal_year_) return;
+  decimal_year_ = year;
+  tiles_.clear();
+}
+
+float MagneticModel::currentDecimalYear() {
+  const std::time_t now = std::time(nullptr);
+  std::tm utc{};
+#if defined(_WIN32)
+  gmtime_s(&utc, &now);
+#else
+  gmtime_r(&now, &utc);
+#endif
+  const int year = utc.tm_year + 1900;
+  const bool leap = (year % 4 == 0 && year % 100 != 0) || (year % 400 == 0);
+  const float days = leap ? 366.0f : 365.0f;
+  return (float)year + (float)utc.tm_yday / days;
+}
+
+float MagneticModel::evaluateDeclination(float lat_deg, float lon_deg, float alt_km) const {
+  if (!isLoaded()) return 0.0f;
+
+  //Keep away from the poles where the east component is singular
+  if (lat_deg > 89.99f) lat_deg = 89.99f;
+  if (lat_deg < -89.99f) lat_deg = -89.99f;
+
+  const double dt = (double)decimal_year_ - (double)epoch_;
+
+  //Geodetic -> geocentric spherical
+  const double lat = lat_deg * kDegToRad;
+  const double lon = lon_deg * kDegToRad;
+  const double sin_lat = std::sin(lat);
+  const double cos_lat = std::cos(lat);
+
+  const double rc = kEllipsoidA / std::sqrt(1.0 - kEccSq * sin_lat * sin_lat);
+  const double p = (rc + alt_km) * cos_lat;
+  const double z = (rc * (1.0 - kEccSq) + alt_km) * sin_lat;
+  const double r = std::sqrt(p * p + z * z);
+  const double lat_gc = std::asin(z / r);
+
+  //Legendre argument: cos(colatitude) = sin(geocentric latitude)
+  const double ct = std::sin(lat_gc);
+  const double st = std::cos(lat_gc);
+
+  const int N = max_degree_;
+  std::vector<double> P((size_t)(N + 1) * (N + 1), 0.0);
+  std::vector<double> dP((size_t)(N + 1) * (N + 1), 0.0);
+
+  //Gauss-normalized associated Legendre functions and d/dtheta
+  P[index(0, 0)] = 1.0;
+  dP[index(0, 0)] = 0.0;
+  for (int n = 1; n <= N; ++n) {
+    for (int m = 0; m <= n; ++m) {
+      const int i = index(n, m);
+      if (n == m) {
+        P[i] = st * P[index(n - 1, m - 1)];
+        dP[i] = st * dP[index(n - 1, m - 1)] + ct * P[index(n - 1, m - 1)];
+      } else if (n == 1 || m == n - 1) {
+        P[i] = ct * P[index(n - 1, m)];
+        dP[i] = ct * dP[index(n - 1, m)] - st * P[index(n - 1, m)];
+      } else {
+        const double k = (double)((n - 1) * (n - 1) - m * m) / (double)((2 * n - 1) * (2 * n - 3));
+        P[i] = ct * P[index(n - 1, m)] - k * P[index(n - 2, m)];
+        dP[i] = ct * dP[index(n - 1, m)] - st * P[index(n - 1, m)] - k * dP[index(n - 2, m)];
+      }
+    }
+  }
+
+  double x = 0.0, y = 0.0, zc = 0.0;
+  double schmidt_n0 = 1.0;
+  double ratio = kRefRadius / r;
+  double ratio_pow = ratio * ratio;
+
+  for (int n = 1; n <= N; ++n) {
+    ratio_pow *= ratio;
+    schmidt_n0 *= (double)(2 * n - 1) / (double)n;
+
+    double schmidt = schmidt_n0;
+    for (int m = 0; m <= n; ++m) {
+      if (m > 0) {
+        schmidt *= std::sqrt((double)((n - m + 1) * (m == 1 ? 2 : 1)) / (double)(n + m));
+      }
+
+      const int i = index(n, m);
+      const double g = (g_[i] + dt * g_dot_[i]) * schmidt;
+      const double h = (h_[i] + dt * h_dot_[i]) * schmidt;
+
+      const double cos_ml = std::cos(m * lon);
+      const double sin_ml = std::sin(m * lon);
+      const double gh_cos = g * cos_ml + h * sin_ml;
+
+      x += ratio_pow * gh_cos * dP[i];
+      y += ratio_pow * m * (g * sin_ml - h * cos_ml) * P[i];
+      zc -= ratio_pow * (n + 1) * gh_cos * P[i];
+    }
+  }
+
+  if (st > 1e-9) y /= st;
+
+  //Rotate north component from geocentric to geodetic frame
+  const double psi = lat_gc - lat;
+  const double x_geod = x * std::cos(psi) - zc * std::sin(psi);
+
+  return (float)(std::atan2(y, x_geod) / kDegToRad);
+}
+
+const MagneticModel::GridTile& MagneticModel::tileFor(int tile_lat, int tile_lon) {
+  const int64_t key = (int64_t)(((uint64_t)(uint32_t)tile_lat << 32) | (uint32_t)tile_lon);
+  auto it = tiles_.find(key);
+  if (it != tiles_.end()) return it->second;
+
+  GridTile tile;
+  tile.nodes.resize((size_t)nodes_per_side_ * nodes_per_side_);
+
+  const float lat0 = (float)(tile_lat * MagneticConfig::GRID_TILE_DEG);
+  const float lon0 = (float)(tile_lon * MagneticConfig::GRID_TILE_DEG);
+
+  for (int j = 0; j < nodes_per_side_; ++j) {
+    for (int i = 0; i < nodes_per_side_; ++i) {
+      const float lat = lat0 + (float)(j * MagneticConfig::GRID_STEP_DEG);
+      const float lon = lon0 + (float)(i * MagneticConfig::GRID_STEP_DEG);
+      tile.nodes[(size_t)j * nodes_per_side_ + i] = evaluateDeclination(lat, lon, 0.0f);
+    }
+  }
+
+  return tiles_.emplace(key, std::move(tile)).first->second;
+}
+
+float MagneticModel::variationDeg(float lat_deg, float lon_deg) {
+  if (!isLoaded()) return 0.0f;
+
+  if (lat_deg > 89.0f) lat_deg = 89.0f;
+  if (lat_deg < -89.0f) lat_deg = -89.0f;
+  lon_deg = wrap180(lon_deg);
+
+  const float tile_deg = (float)MagneticConfig::GRID_TILE_DEG;
+  const int tile_lat = (int)std::floor(lat_deg / tile_deg);
+  const int tile_lon = (int)std::floor(lon_deg / tile_deg);
+  const GridTile& tile = tileFor(tile_lat, tile_lon);
+
+  const float step = (float)MagneticConfig::GRID_STEP_DEG;
+  const float fy = (lat_deg - tile_lat * tile_deg) / step;
+  const float fx = (lon_deg - tile_lon * tile_deg) / step;
+
+  int iy = (int)fy;
+  int ix = (int)fx;
+  if (iy > nodes_per_side_ - 2) iy = nodes_per_side_ - 2;
+  if (ix > nodes_per_side_ - 2) ix = nodes_per_side_ - 2;
+  const float ty = fy - (float)iy;
+  const float tx = fx - (float)ix;
+
+  const float d00 = tile.nodes[(size_t)iy * nodes_per_side_ + ix];
+  const float d10 = tile.nodes[(size_t)iy * nodes_per_side_ + ix + 1];
+  const float d01 = tile.nodes[(size_t)(iy + 1) * nodes_per_side_ + ix];
+  const float d11 = tile.nodes[(size_t)(iy + 1) * nodes_per_side_ + ix + 1];
+
+  //Interpolate relative to d00 so the +/-180 seam near the poles stays continuous
+  const float e10 = wrap180(d10 - d00);
+  const float e01 = wrap180(d01 - d00);
+  const float e11 = wrap180(d11 - d00);
+
+  const float top = e10 * tx;
+  const float bottom = e01 + (e11 - e01) * tx;
+  return wrap180(d00 + top + (bottom - top) * ty);
+}
+
+float MagneticModel::trueToMagnetic(float true_deg, float lat_deg, float lon_deg) {
+  return wrap360(true_deg - variationDeg(lat_deg, lon_deg));
+}
@@ -0,0 +1,153 @@
+#include "remote/CommandProtocol.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace CommandProtocol;
+
+bool CommandProtocol::parseEndpoint(const char* text, Endpoint& out) {
+  out = Endpoint();
+  if (!text || !*text) return false;
+
+  if (std::strncmp(text, "unix:", 5) == 0) {
+    out.unix_socket = true;
+    out.path = text + 5;
+    return !out.path.empty();
+  }
+
+  const char* colon = std::strrchr(text, ':');
+  if (colon) out.host.assign(text, colon);
+  out.port = std::atoi(colon ? colon + 1 : text);
+  return out.port > 0 && out.port < 65536 && !out.host.empty();
+}
+
+std::string CommandProtocol::describe(const Endpoint& endpoint) {
+  if (endpoint.unix_socket) return "unix:" + endpoint.path;
+  return endpoint.host + ":" + std::to_string(endpoint.port);
+}
+
+#ifdef _WIN32
+
+int CommandProtocol::listenOn(const Endpoint& endpoint) {
+  std::cerr << "Command stream: sockets are not supported on this platform (" << describe(endpoint) << ")\n";
+  return -1;
+}
+
+int CommandProtocol::connectTo(const Endpoint& endpoint, double) {
+  return listenOn(endpoint);
+}
+
+void CommandProtocol::closeSocket(int) {}
+
+bool CommandProtocol::readAll(int, void*, size_t) {
+  return false;
+}
+
+#else
+
+namespace {
+  //Fills the address for either family; false if it does not fit
+  bool makeAddress(const Endpoint& endpoint, sockaddr_storage& storage, socklen_t& length) {
+    std::memset(&storage, 0, sizeof(storage));
+    if (endpoint.unix_socket) {
+      sockaddr_un& addr = reinterpret_cast<sockaddr_un&>(storage);
+      if (endpoint.path.size() >= sizeof(addr.sun_path)) return false;
+      addr.sun_family = AF_UNIX;
+      std::memcpy(addr.sun_path, endpoint.path.c_str(), endpoint.path.size() + 1);
+      length = sizeof(addr);
+      return true;
+    }
+
+    sockaddr_in& addr = reinterpret_cast<sockaddr_in&>(storage);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)endpoint.port);
+    length = sizeof(addr);
+    return inet_pton(AF_INET, endpoint.host.c_str(), &addr.sin_addr) == 1;
+  }
+}
+
+int CommandProtocol::listenOn(const Endpoint& endpoint) {
+  sockaddr_storage addr;
+  socklen_t length = 0;
+  if (!makeAddress(endpoint, addr, length)) {
+    std::cerr << "Command stream: bad endpoint " << describe(endpoint) << "\n";
+    return -1;
+  }
+
+  const int fd = socket(addr.ss_family, SOCK_STREAM, 0);
+  if (fd < 0) return -1;
+
+  if (endpoint.unix_socket) {
+    unlink(endpoint.path.c_str());
+  } else {
+    const int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  }
+
+  if (bind(fd, reinterpret_cast<const sockaddr*>(&addr), length) != 0 || listen(fd, 8) != 0) {
+    std::cerr << "Command stream: cannot listen on " << describe(endpoint) << ": " << std::strerror(errno) << "\n";
+    ::close(fd);
+    return -1;
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+  return fd;
+}
+
+int CommandProtocol::connectTo(const Endpoint& endpoint, double timeout_s) {
+  sockaddr_storage addr;
+  socklen_t length = 0;
+  if (!makeAddress(endpoint, addr, length)) {
+    std::cerr << "Command stream: bad endpoint " << describe(endpoint) << "\n";
+    return -1;
+  }
+
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(timeout_s);
+  for (;;) {
+    const int fd = socket(addr.ss_family, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, reinterpret_cast<const sockaddr*>(&addr), length) == 0) {
+      if (!endpoint.unix_socket) {
+        const int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+      }
+      return fd;
+    }
+    ::close(fd);
+
+    if (std::chrono::steady_clock::now() >= deadline) {
+      std::cerr << "Command stream: nothing listening on " << describe(endpoint) << "\n";
+      return -1;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+}
+
+void CommandProtocol::closeSocket(int fd) {
+  if (fd >= 0) ::close(fd);
+}
+
+bool CommandProtocol::readAll(int fd, void* data, size_t bytes) {
+  unsigned char* p = static_cast<unsigned char*>(data);
+  while (bytes > 0) {
+    const ssize_t n = recv(fd, p, bytes, 0);
+    if (n <= 0) return false;
+    p += n;
+    bytes -= (size_t)n;
+  }
+  return true;
+}
+
+#endif
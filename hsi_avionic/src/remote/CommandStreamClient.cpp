@@ -0,0 +1,70 @@
+#include "remote/CommandStreamClient.hpp"
+
+#include <cstdio>
+#include <iostream>
+
+using namespace CommandProtocol;
+
+CommandStreamClient::~CommandStreamClient() {
+  close();
+}
+
+bool CommandStreamClient::connect(const Endpoint& endpoint, double timeout_s) {
+  close();
+  fd_ = connectTo(endpoint, timeout_s);
+  if (fd_ < 0) return false;
+  std::cout << "Command stream: connected to " << describe(endpoint) << "\n";
+  return true;
+}
+
+void CommandStreamClient::close() {
+  closeSocket(fd_);
+  fd_ = -1;
+}
+
+CommandList::Frame* CommandStreamClient::next() {
+  while (fd_ >= 0) {
+    MessageHeader header;
+    if (!readAll(fd_, &header, sizeof(header))) break;   // stream closed
+    if (header.magic != MAGIC) {
+      std::cerr << "Command stream: bad message header\n";
+      break;
+    }
+    if (header.size > MAX_PAYLOAD) {
+      std::cerr << "Command stream: message of " << header.size << " bytes exceeds the limit\n";
+      break;
+    }
+    payload_.resize(header.size);
+    if (!readAll(fd_, payload_.data(), payload_.size())) break;
+    bytes_ += sizeof(header) + header.size;
+
+    if (header.type == SETUP) {
+      if (!CommandList::applySetup(payload_.data(), payload_.size())) {
+        std::cerr << "Command stream: malformed setup\n";
+        break;
+      }
+      continue;
+    }
+
+    CommandList::Frame* frame = CommandList::decode(payload_.data(), payload_.size());
+    if (!frame) break;
+    if (header.type == FRAME) {
+      ++frames_;
+      return frame;
+    }
+
+    //A sync only restores stream contents: uploaded now, nothing drawn
+    CommandList::submit(frame);
+    ++syncs_;
+  }
+
+  close();
+  return nullptr;
+}
+
+void CommandStreamClient::report(std::ostream& out) const {
+  char line[200];
+  std::snprintf(line, sizeof(line), "Command stream: %d frames received (%d syncs), %.0f bytes per frame\n",
+                frames_, syncs_, frames_ ? (double)bytes_ / frames_ : 0.0);
+  out << line;
+}
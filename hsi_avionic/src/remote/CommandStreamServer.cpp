@@ -0,0 +1,341 @@
+#include "remote/CommandStreamServer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+using namespace CommandProtocol;
+
+namespace {
+  void putStream(std::vector<unsigned char>& out, uint16_t key, const std::vector<unsigned char>& bytes) {
+    const uint16_t pad = 0;
+    const uint32_t size = (uint32_t)bytes.size();
+    const size_t at = out.size();
+    out.resize(at + 8);
+    std::memcpy(&out[at], &key, 2);
+    std::memcpy(&out[at + 2], &pad, 2);
+    std::memcpy(&out[at + 4], &size, 4);
+    out.insert(out.end(), bytes.begin(), bytes.end());
+  }
+
+  void putCount(std::vector<unsigned char>& out, uint32_t count) {
+    out.resize(4);
+    std::memcpy(out.data(), &count, 4);
+  }
+}
+
+CommandStreamServer::~CommandStreamServer() {
+  close();
+}
+
+void CommandStreamServer::publish(const CommandList::Frame* frame) {
+  if (!isOpen()) return;
+
+  using Clock = std::chrono::steady_clock;
+  const Clock::time_point start = Clock::now();
+  CommandList::encode(frame, encoded_);
+  encode_ms_ += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  ++frames_published_;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queue_.size() < max_queued_ && !free_.empty()) {
+      CommandList::EncodedFrame* slot = free_.back();
+      free_.pop_back();
+      std::swap(*slot, encoded_);
+      queue_.push_back(slot);
+    } else {
+      //Sender is behind: fold this frame into the last queued one
+      CommandList::EncodedFrame& last = *queue_.back();
+      for (CommandList::EncodedStream& s : encoded_.streams) {
+        auto it = last.streams.begin();
+        while (it != last.streams.end() && it->key != s.key) ++it;
+        if (it == last.streams.end()) {
+          last.streams.push_back(std::move(s));
+        } else if (s.cumulative && !s.restart) {
+          it->bytes.insert(it->bytes.end(), s.bytes.begin(), s.bytes.end());
+        } else {
+          it->bytes.swap(s.bytes);
+          it->restart = s.restart;
+        }
+      }
+      last.body.swap(encoded_.body);
+      ++merged_;
+    }
+  }
+
+#ifndef _WIN32
+  const char wake = 1;
+  if (write(wake_fds_[1], &wake, 1) < 0) {}
+#endif
+}
+
+void CommandStreamServer::appendMessage(std::vector<unsigned char>& out, uint32_t type,
+                                        const std::vector<unsigned char>& payload) const {
+  const MessageHeader header = { MAGIC, type, (uint32_t)payload.size() };
+  const size_t at = out.size();
+  out.resize(at + sizeof(header));
+  std::memcpy(&out[at], &header, sizeof(header));
+  out.insert(out.end(), payload.begin(), payload.end());
+}
+
+#ifdef _WIN32
+
+bool CommandStreamServer::open(const Endpoint& endpoint, int) {
+  return listenOn(endpoint) >= 0;
+}
+
+void CommandStreamServer::close() {}
+void CommandStreamServer::workerLoop() {}
+void CommandStreamServer::acceptHeads() {}
+void CommandStreamServer::sendFrame(const CommandList::EncodedFrame&) {}
+bool CommandStreamServer::flush(Head&) { return false; }
+void CommandStreamServer::disconnectAll() {}
+
+#else
+
+bool CommandStreamServer::open(const Endpoint& endpoint, int max_queued) {
+  close();
+
+  listen_fd_ = listenOn(endpoint);
+  if (listen_fd_ < 0) return false;
+  if (pipe(wake_fds_) != 0) {
+    closeSocket(listen_fd_);
+    listen_fd_ = -1;
+    return false;
+  }
+  fcntl(wake_fds_[0], F_SETFL, fcntl(wake_fds_[0], F_GETFL, 0) | O_NONBLOCK);
+  fcntl(wake_fds_[1], F_SETFL, fcntl(wake_fds_[1], F_GETFL, 0) | O_NONBLOCK);
+  unix_path_ = endpoint.unix_socket ? endpoint.path : std::string();
+
+  //One more frame than the queue holds: the sender works on one outside it
+  max_queued_ = (size_t)std::max(max_queued, 1);
+  frames_.clear();
+  free_.clear();
+  for (size_t i = 0; i <= max_queued_; ++i) {
+    frames_.push_back(std::make_unique<CommandList::EncodedFrame>());
+    free_.push_back(frames_.back().get());
+  }
+
+  CommandList::encodeSetup(setup_);
+  streams_.clear();
+
+  stopping_ = false;
+  worker_ = std::thread(&CommandStreamServer::workerLoop, this);
+  std::cout << "Command stream: listening on " << describe(endpoint) << "\n";
+  return true;
+}
+
+void CommandStreamServer::close() {
+  if (worker_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    const char wake = 1;
+    if (write(wake_fds_[1], &wake, 1) < 0) {}
+    worker_.join();
+  }
+  disconnectAll();
+  if (listen_fd_ >= 0) {
+    closeSocket(listen_fd_);
+    if (!unix_path_.empty()) unlink(unix_path_.c_str());
+  }
+  listen_fd_ = -1;
+  for (int& fd : wake_fds_) {
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+  }
+}
+
+void CommandStreamServer::workerLoop() {
+  std::vector<pollfd> fds;
+  for (;;) {
+    CommandList::EncodedFrame* frame = nullptr;
+    bool stopping = false;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!queue_.empty()) {
+        frame = queue_.front();
+        queue_.pop_front();
+      }
+      stopping = stopping_;
+    }
+
+    if (frame) {
+      sendFrame(*frame);
+      std::lock_guard<std::mutex> lock(mutex_);
+      free_.push_back(frame);
+      continue;
+    }
+
+    //Queue drained: give slow heads a moment to take the rest, then stop
+    if (stopping) {
+      for (int tries = 0; tries < 20; ++tries) {
+        bool pending = false;
+        for (Head& head : heads_) {
+          if (flush(head) && head.sent < head.out.size()) pending = true;
+        }
+        if (!pending) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      }
+      return;
+    }
+
+    //Sleeps until a frame is published, a head connects or a socket drains
+    fds.clear();
+    fds.push_back({ wake_fds_[0], POLLIN, 0 });
+    fds.push_back({ listen_fd_, POLLIN, 0 });
+    for (const Head& head : heads_) {
+      fds.push_back({ head.fd, (short)(POLLIN | (head.sent < head.out.size() ? POLLOUT : 0)), 0 });
+    }
+    if (poll(fds.data(), (nfds_t)fds.size(), -1) < 0) continue;
+
+    char drain[64];
+    while (read(wake_fds_[0], drain, sizeof(drain)) > 0) {}
+    if (fds[1].revents & POLLIN) acceptHeads();
+
+    //Heads send nothing; readable means closed
+    for (size_t i = 2; i < fds.size(); ++i) {
+      Head& head = heads_[i - 2];
+      if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+        if (recv(head.fd, drain, sizeof(drain), MSG_DONTWAIT) <= 0) {
+          ::close(head.fd);
+          head.fd = -1;
+          continue;
+        }
+      }
+      if (fds[i].revents & POLLOUT) flush(head);
+    }
+    heads_.erase(std::remove_if(heads_.begin(), heads_.end(), [](const Head& h) { return h.fd < 0; }),
+                 heads_.end());
+  }
+}
+
+void CommandStreamServer::acceptHeads() {
+  for (;;) {
+    const int fd = accept(listen_fd_, nullptr, nullptr);
+    if (fd < 0) return;
+    if (unix_path_.empty()) {
+      const int on = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    }
+
+    Head head = { fd, {}, 0, true };
+    appendMessage(head.out, SETUP, setup_);
+    heads_.push_back(std::move(head));
+    ++heads_connected_;
+    flush(heads_.back());
+  }
+}
+
+//Writes what the socket takes without blocking; false (and closed) on error
+bool CommandStreamServer::flush(Head& head) {
+  if (head.fd < 0) return false;
+  while (head.sent < head.out.size()) {
+    const ssize_t n = send(head.fd, head.out.data() + head.sent, head.out.size() - head.sent,
+                           MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+    if (n <= 0) {
+      ::close(head.fd);
+      head.fd = -1;
+      return false;
+    }
+    head.sent += (size_t)n;
+    bytes_sent_ += (uint64_t)n;
+  }
+  head.out.clear();
+  head.sent = 0;
+  return true;
+}
+
+void CommandStreamServer::sendFrame(const CommandList::EncodedFrame& frame) {
+  //Streams whose payload differs from the retained one
+  uint32_t changed = 0;
+  payload_.clear();
+  putCount(payload_, 0);
+  for (const CommandList::EncodedStream& s : frame.streams) {
+    auto it = streams_.find(s.key);
+    if (!s.cumulative && it != streams_.end() && it->second.bytes == s.bytes) continue;
+    putStream(payload_, s.key, s.bytes);
+    ++changed;
+  }
+  std::memcpy(payload_.data(), &changed, 4);
+  payload_.insert(payload_.end(), frame.body.begin(), frame.body.end());
+
+  //Heads needing a sync get the state as it was before this frame
+  bool sync_built = false;
+  for (Head& head : heads_) {
+    if (head.fd < 0) continue;
+    if (head.sent < head.out.size()) {
+      head.needs_sync = true;
+      ++skipped_;
+      continue;
+    }
+
+    if (head.needs_sync) {
+      if (!sync_built) {
+        putCount(sync_, (uint32_t)streams_.size());
+        for (const auto& entry : streams_) putStream(sync_, entry.first, entry.second.bytes);
+        sync_built = true;
+      }
+      appendMessage(head.out, SYNC, sync_);
+      head.needs_sync = false;
+      ++syncs_;
+    }
+    appendMessage(head.out, FRAME, payload_);
+    flush(head);
+  }
+  heads_.erase(std::remove_if(heads_.begin(), heads_.end(), [](const Head& h) { return h.fd < 0; }),
+               heads_.end());
+
+  for (const CommandList::EncodedStream& s : frame.streams) {
+    StreamState& state = streams_[s.key];
+    state.cumulative = s.cumulative;
+    if (s.cumulative && !s.restart) {
+      state.bytes.insert(state.bytes.end(), s.bytes.begin(), s.bytes.end());
+    } else if (state.bytes != s.bytes) {
+      state.bytes = s.bytes;
+    }
+  }
+
+  ++frames_sent_;
+  frame_bytes_ += sizeof(MessageHeader) + payload_.size();
+}
+
+void CommandStreamServer::disconnectAll() {
+  for (Head& head : heads_) {
+    if (head.fd >= 0) ::close(head.fd);
+  }
+  heads_.clear();
+}
+
+#endif
+
+void CommandStreamServer::report(std::ostream& out, int width, int height) const {
+  const double raw = (double)frames_sent_ * width * height * 3;
+  char line[360];
+  std::snprintf(line, sizeof(line),
+                "Command stream: %d frames to %d head(s), %d merged, %d skipped by slow heads, %d syncs; "
+                "%.0f bytes per frame (%.0f:1 against raw RGB), %llu bytes sent; encode %.3f ms per frame\n",
+                frames_sent_, heads_connected_, merged_, skipped_, syncs_,
+                frames_sent_ ? (double)frame_bytes_ / frames_sent_ : 0.0,
+                frame_bytes_ ? raw / (double)frame_bytes_ : 0.0, (unsigned long long)bytes_sent_,
+                frames_published_ ? encode_ms_ / frames_published_ : 0.0);
+  out << line;
+}
@@ -0,0 +1,420 @@
+#include "swr/SoftRasterizer.hpp"
+#include "config/AppConfig.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+  constexpr int kTile = SoftwareConfig::TILE_SIZE;
+
+  uint8_t toByte(float c) {
+    if (c < 0.0f) c = 0.0f;
+    if (c > 1.0f) c = 1.0f;
+    return (uint8_t)std::lrintf(c * 255.0f);
+  }
+
+  uint32_t packColor(float r, float g, float b) {
+    return (uint32_t)toByte(r) | ((uint32_t)toByte(g) << 8) |
+           ((uint32_t)toByte(b) << 16) | 0xFF000000u;
+  }
+
+  float saturate(float v) {
+    return v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+  }
+
+  //dst = (dst * (256 - a) + src * a) >> 8 with a = round(cov * alpha * 256)
+  void blendSpan(uint32_t* dst, const float* cov, int n, uint32_t color, float alpha) {
+    const float scale = alpha * 256.0f;
+    int i = 0;
+
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i src = _mm_unpacklo_epi8(_mm_set1_epi32((int)color), zero);
+    const __m128i full = _mm_set1_epi16(256);
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128 vmax = _mm_set1_ps(256.0f);
+
+    for (; i + 4 <= n; i += 4) {
+      __m128 c = _mm_mul_ps(_mm_loadu_ps(cov + i), vscale);
+      c = _mm_min_ps(_mm_max_ps(c, _mm_setzero_ps()), vmax);
+      const __m128i a = _mm_cvtps_epi32(c);
+      if (_mm_movemask_epi8(_mm_cmpeq_epi32(a, zero)) == 0xFFFF) continue;
+
+      const __m128i a16 = _mm_packs_epi32(a, a);
+      const __m128i a_pairs = _mm_unpacklo_epi16(a16, a16);
+      const __m128i a_lo = _mm_unpacklo_epi32(a_pairs, a_pairs);
+      const __m128i a_hi = _mm_unpackhi_epi32(a_pairs, a_pairs);
+
+      const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+      const __m128i d_lo = _mm_unpacklo_epi8(d, zero);
+      const __m128i d_hi = _mm_unpackhi_epi8(d, zero);
+
+      const __m128i r_lo = _mm_srli_epi16(
+          _mm_add_epi16(_mm_mullo_epi16(d_lo, _mm_sub_epi16(full, a_lo)), _mm_mullo_epi16(src, a_lo)), 8);
+      const __m128i r_hi = _mm_srli_epi16(
+          _mm_add_epi16(_mm_mullo_epi16(d_hi, _mm_sub_epi16(full, a_hi)), _mm_mullo_epi16(src, a_hi)), 8);
+
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(r_lo, r_hi));
+    }
+#endif
+
+    for (; i < n; ++i) {
+      const float c = std::min(std::max(cov[i] * scale, 0.0f), 256.0f);
+      const uint32_t a = (uint32_t)std::lrintf(c);
+      if (a == 0) continue;
+
+      const uint32_t d = dst[i];
+      uint32_t out = 0;
+      for (int ch = 0; ch < 4; ++ch) {
+        const uint32_t dc = (d >> (ch * 8)) & 0xFF;
+        const uint32_t sc = (color >> (ch * 8)) & 0xFF;
+        out |= (((dc * (256 - a) + sc * a) >> 8) & 0xFF) << (ch * 8);
+      }
+      dst[i] = out;
+    }
+  }
+}
+
+SoftRasterizer::SoftRasterizer(int width, int height, unsigned thread_count)
+  : width_(width), height_(height),
+    tiles_x_((width + kTile - 1) / kTile),
+    tiles_y_((height + kTile - 1) / kTile),
+    pixels_((size_t)width * height, 0xFF000000u),
+    bins_((size_t)tiles_x_ * tiles_y_),
+    pool_(thread_count) {}
+
+void SoftRasterizer::toPixel(float x_ndc, float y_ndc, float& px, float& py) const {
+  px = (x_ndc * 0.5f + 0.5f) * (float)width_;
+  py = (0.5f - y_ndc * 0.5f) * (float)height_;
+}
+
+void SoftRasterizer::finishPrimitive(Primitive& prim, float minx, float miny, float maxx, float maxy) {
+  prim.x0 = std::max(0, (int)std::floor(minx));
+  prim.y0 = std::max(0, (int)std::floor(miny));
+  prim.x1 = std::min(width_, (int)std::ceil(maxx) + 1);
+  prim.y1 = std::min(height_, (int)std::ceil(maxy) + 1);
+  if (prim.x0 >= prim.x1 || prim.y0 >= prim.y1 || prim.data.empty()) return;
+  prims_.push_back(std::move(prim));
+}
+
+void SoftRasterizer::clear(float r, float g, float b) {
+  //A clear discards everything recorded before it
+  prims_.clear();
+
+  Primitive prim{Kind::Clear, packColor(r, g, b), 1.0f, 0.0f, nullptr, 0, {}, 0, 0, width_, height_};
+  prims_.push_back(std::move(prim));
+}
+
+void SoftRasterizer::addSegment(Primitive& prim, float ax, float ay, float bx, float by,
+                                float& minx, float& miny, float& maxx, float& maxy) const {
+  const float dx = bx - ax;
+  const float dy = by - ay;
+  const float len = std::sqrt(dx * dx + dy * dy);
+  if (len < 1e-6f) return;
+
+  const float pad = prim.half_width + 1.0f;
+  const float sminx = std::min(ax, bx) - pad;
+  const float sminy = std::min(ay, by) - pad;
+  const float smaxx = std::max(ax, bx) + pad;
+  const float smaxy = std::max(ay, by) + pad;
+
+  prim.data.insert(prim.data.end(), {ax, ay, dx / len, dy / len, len, sminx, sminy, smaxx, smaxy});
+
+  minx = std::min(minx, sminx);
+  miny = std::min(miny, sminy);
+  maxx = std::max(maxx, smaxx);
+  maxy = std::max(maxy, smaxy);
+}
+
+void SoftRasterizer::drawLines(const float* xy, int vertex_count, bool strip, bool closed,
+                               float width_px, float r, float g, float b, float alpha) {
+  Primitive prim{strip ? Kind::Capsules : Kind::Segments, packColor(r, g, b), alpha,
+                 std::max(width_px, 1.0f) * 0.5f, nullptr, 0, {}, 0, 0, 0, 0};
+
+  float minx = 1e9f, miny = 1e9f, maxx = -1e9f, maxy = -1e9f;
+
+  auto segment = [&](int i0, int i1) {
+    float ax, ay, bx, by;
+    toPixel(xy[i0 * 2], xy[i0 * 2 + 1], ax, ay);
+    toPixel(xy[i1 * 2], xy[i1 * 2 + 1], bx, by);
+    addSegment(prim, ax, ay, bx, by, minx, miny, maxx, maxy);
+  };
+
+  if (strip) {
+    for (int i = 0; i + 1 < vertex_count; ++i) segment(i, i + 1);
+    if (closed && vertex_count > 2) segment(vertex_count - 1, 0);
+  } else {
+    for (int i = 0; i + 1 < vertex_count; i += 2) segment(i, i + 1);
+  }
+
+  finishPrimitive(prim, minx, miny, maxx, maxy);
+}
+
+void SoftRasterizer::fillTriangles(const float* xy, int vertex_count,
+                                   float r, float g, float b, float alpha) {
+  Primitive prim{Kind::Triangles, packColor(r, g, b), alpha, 0.0f, nullptr, 0, {}, 0, 0, 0, 0};
+
+  float minx = 1e9f, miny = 1e9f, maxx = -1e9f, maxy = -1e9f;
+
+  for (int t = 0; t + 2 < vertex_count; t += 3) {
+    float px[3], py[3];
+    for (int k = 0; k < 3; ++k) toPixel(xy[(t + k) * 2], xy[(t + k) * 2 + 1], px[k], py[k]);
+
+    const float area = (px[1] - px[0]) * (py[2] - py[0]) - (py[1] - py[0]) * (px[2] - px[0]);
+    if (std::fabs(area) < 1e-6f) continue;
+    const float sign = area > 0.0f ? 1.0f : -1.0f;
+
+    //Edge functions normalized to signed pixel distance, positive inside
+    float edges[9];
+    for (int e = 0; e < 3; ++e) {
+      const float ax = px[e], ay = py[e];
+      const float bx = px[(e + 1) % 3], by = py[(e + 1) % 3];
+      const float len = std::sqrt((bx - ax) * (bx - ax) + (by - ay) * (by - ay));
+      const float A = -(by - ay) * sign / len;
+      const float B = (bx - ax) * sign / len;
+      edges[e * 3 + 0] = A;
+      edges[e * 3 + 1] = B;
+      edges[e * 3 + 2] = -(A * ax + B * ay);
+    }
+
+    const float tminx = std::min({px[0], px[1], px[2]}) - 1.0f;
+    const float tminy = std::min({py[0], py[1], py[2]}) - 1.0f;
+    const float tmaxx = std::max({px[0], px[1], px[2]}) + 1.0f;
+    const float tmaxy = std::max({py[0], py[1], py[2]}) + 1.0f;
+
+    prim.data.insert(prim.data.end(), edges, edges + 9);
+    prim.data.insert(prim.data.end(), {tminx, tminy, tmaxx, tmaxy});
+
+    minx = std::min(minx, tminx);
+    miny = std::min(miny, tminy);
+    maxx = std::max(maxx, tmaxx);
+    maxy = std::max(maxy, tmaxy);
+  }
+
+  finishPrimitive(prim, minx, miny, maxx, maxy);
+}
+
+void SoftRasterizer::drawGlyphs(const FontAtlas& atlas, const FontAtlas::GlyphQuad* quads, int count,
+                                float r, float g, float b) {
+  //One primitive per atlas page in use
+  for (int page = 0; page < atlas.pageCount(); ++page) {
+    Primitive prim{Kind::Glyphs, packColor(r, g, b), 1.0f, 0.0f, &atlas, page, {}, 0, 0, 0, 0};
+    const float aw = (float)atlas.pageWidth(page);
+    const float ah = (float)atlas.pageHeight(page);
+
+    float minx = 1e9f, miny = 1e9f, maxx = -1e9f, maxy = -1e9f;
+
+    for (int i = 0; i < count; ++i) {
+      const FontAtlas::GlyphQuad& q = quads[i];
+      if (q.page != page) continue;
+
+      float px[4], py[4];
+      for (int k = 0; k < 4; ++k) toPixel(q.px[k], q.py[k], px[k], py[k]);
+
+      const float e1x = px[1] - px[0], e1y = py[1] - py[0];
+      const float e2x = px[3] - px[0], e2y = py[3] - py[0];
+      const float det = e1x * e2y - e2x * e1y;
+      if (std::fabs(det) < 1e-6f) continue;
+
+      const float gminx = std::min({px[0], px[1], px[2], px[3]});
+      const float gminy = std::min({py[0], py[1], py[2], py[3]});
+      const float gmaxx = std::max({px[0], px[1], px[2], px[3]});
+      const float gmaxy = std::max({py[0], py[1], py[2], py[3]});
+
+      prim.data.insert(prim.data.end(), {
+        px[0], py[0],
+        e2y / det, -e2x / det, -e1y / det, e1x / det,
+        q.u0 * aw, q.v0 * ah,
+        q.u1 * aw, q.v1 * ah,
+        gminx, gminy, gmaxx, gmaxy
+      });
+
+      minx = std::min(minx, gminx);
+      miny = std::min(miny, gminy);
+      maxx = std::max(maxx, gmaxx);
+      maxy = std::max(maxy, gmaxy);
+    }
+
+    finishPrimitive(prim, minx, miny, maxx, maxy);
+  }
+}
+
+void SoftRasterizer::flush() {
+  for (std::vector<int>& bin : bins_) bin.clear();
+
+  for (int i = 0; i < (int)prims_.size(); ++i) {
+    const Primitive& p = prims_[i];
+    const int tx0 = p.x0 / kTile, tx1 = (p.x1 - 1) / kTile;
+    const int ty0 = p.y0 / kTile, ty1 = (p.y1 - 1) / kTile;
+    for (int ty = ty0; ty <= ty1; ++ty) {
+      for (int tx = tx0; tx <= tx1; ++tx) {
+        bins_[(size_t)ty * tiles_x_ + tx].push_back(i);
+      }
+    }
+  }
+
+  pool_.parallelFor(tiles_x_ * tiles_y_, [this](int tile) { rasterizeTile(tile); });
+
+  prims_.clear();
+}
+
+void SoftRasterizer::rasterizeTile(int tile_index) {
+  const int tile_x0 = (tile_index % tiles_x_) * kTile;
+  const int tile_y0 = (tile_index / tiles_x_) * kTile;
+  const int tile_x1 = std::min(tile_x0 + kTile, width_);
+  const int tile_y1 = std::min(tile_y0 + kTile, height_);
+
+  float cov[kTile];
+
+  for (int pi : bins_[tile_index]) {
+    const Primitive& p = prims_[pi];
+
+    const int x0 = std::max(tile_x0, p.x0);
+    const int x1 = std::min(tile_x1, p.x1);
+    const int y0 = std::max(tile_y0, p.y0);
+    const int y1 = std::min(tile_y1, p.y1);
+    if (x0 >= x1 || y0 >= y1) continue;
+
+    const int n = x1 - x0;
+
+    for (int y = y0; y < y1; ++y) {
+      uint32_t* row = &pixels_[(size_t)y * width_ + x0];
+
+      if (p.kind == Kind::Clear) {
+        std::fill(row, row + n, p.color);
+        continue;
+      }
+
+      std::fill(cov, cov + n, 0.0f);
+      const float fy = (float)y + 0.5f;
+      const float* d = p.data.data();
+      const size_t size = p.data.size();
+
+      switch (p.kind) {
+        case Kind::Triangles:
+          for (size_t k = 0; k + 13 <= size; k += 13) {
+            const float* t = d + k;
+            if (fy < t[10] || fy > t[12]) continue;
+
+            const int sx0 = std::max(x0, (int)t[9]);
+            const int sx1 = std::min(x1, (int)t[11] + 1);
+            const float b0 = t[1] * fy + t[2];
+            const float b1 = t[4] * fy + t[5];
+            const float b2 = t[7] * fy + t[8];
+
+            for (int x = sx0; x < sx1; ++x) {
+              const float fx = (float)x + 0.5f;
+              const float e = std::min(std::min(t[0] * fx + b0, t[3] * fx + b1), t[6] * fx + b2);
+              float& c = cov[x - x0];
+              c = std::min(1.0f, c + saturate(e + 0.5f));
+            }
+          }
+          break;
+
+        case Kind::Segments:
+        case Kind::Capsules: {
+          const bool round = p.kind == Kind::Capsules;
+          const float hw = p.half_width;
+
+          for (size_t k = 0; k + 9 <= size; k += 9) {
+            const float* s = d + k;
+            if (fy < s[6] || fy > s[8]) continue;
+
+            const int sx0 = std::max(x0, (int)s[5]);
+            const int sx1 = std::min(x1, (int)s[7] + 1);
+            const float ly = fy - s[1];
+
+            for (int x = sx0; x < sx1; ++x) {
+              const float lx = (float)x + 0.5f - s[0];
+              const float along = lx * s[2] + ly * s[3];
+              float c;
+              if (round) {
+                const float t = std::min(std::max(along, 0.0f), s[4]);
+                const float qx = lx - s[2] * t;
+                const float qy = ly - s[3] * t;
+                c = saturate(hw - std::sqrt(qx * qx + qy * qy) + 0.5f);
+              } else {
+                const float perp = std::fabs(lx * s[3] - ly * s[2]);
+                c = saturate(hw - perp + 0.5f) * saturate(std::min(along, s[4] - along) + 0.5f);
+              }
+              float& dst = cov[x - x0];
+              dst = std::max(dst, c);
+            }
+          }
+          break;
+        }
+
+        case Kind::Glyphs: {
+          const unsigned char* bmp = p.atlas->pagePixels(p.page);
+          const int aw = p.atlas->pageWidth(p.page);
+          const int ah = p.atlas->pageHeight(p.page);
+
+          auto texel = [&](int tx, int ty) -> float {
+            tx = std::min(std::max(tx, 0), aw - 1);
+            ty = std::min(std::max(ty, 0), ah - 1);
+            return (float)bmp[(size_t)ty * aw + tx];
+          };
+
+          for (size_t k = 0; k + 14 <= size; k += 14) {
+            const float* g = d + k;
+            if (fy < g[11] - 1.0f || fy > g[13] + 1.0f) continue;
+
+            const int sx0 = std::max(x0, (int)g[10] - 1);
+            const int sx1 = std::min(x1, (int)g[12] + 2);
+            const float dy = fy - g[1];
+
+            for (int x = sx0; x < sx1; ++x) {
+              const float dx = (float)x + 0.5f - g[0];
+              const float s = g[2] * dx + g[3] * dy;
+              const float t = g[4] * dx + g[5] * dy;
+              if (s < 0.0f || s > 1.0f || t < 0.0f || t > 1.0f) continue;
+
+              const float u = g[6] + s * (g[8] - g[6]) - 0.5f;
+              const float v = g[7] + t * (g[9] - g[7]) - 0.5f;
+              const int iu = (int)std::floor(u);
+              const int iv = (int)std::floor(v);
+              const float fu = u - (float)iu;
+              const float fv = v - (float)iv;
+
+              const float top = texel(iu, iv) + (texel(iu + 1, iv) - texel(iu, iv)) * fu;
+              const float bottom = texel(iu, iv + 1) + (texel(iu + 1, iv + 1) - texel(iu, iv + 1)) * fu;
+              const float c = (top + (bottom - top) * fv) * (1.0f / 255.0f);
+
+              float& dst = cov[x - x0];
+              dst = std::max(dst, c);
+            }
+          }
+          break;
+        }
+
+        case Kind::Clear:
+          break;
+      }
+
+      blendSpan(row, cov, n, p.color, p.alpha);
+    }
+  }
+}
+
+bool SoftRasterizer::writePpm(const std::string& path) const {
+  std::FILE* f = std::fopen(path.c_str(), "wb");
+  if (!f) return false;
+
+  std::fprintf(f, "P6\n%d %d\n255\n", width_, height_);
+
+  std::vector<unsigned char> rgb((size_t)width_ * height_ * 3);
+  for (size_t i = 0; i < pixels_.size(); ++i) {
+    rgb[i * 3 + 0] = (unsigned char)(pixels_[i] & 0xFF);
+    rgb[i * 3 + 1] = (unsigned char)((pixels_[i] >> 8) & 0xFF);
+    rgb[i * 3 + 2] = (unsigned char)((pixels_[i] >> 16) & 0xFF);
+  }
+
+  const bool ok = std::fwrite(rgb.data(), 1, rgb.size(), f) == rgb.size();
+  std::fclose(f);
+  return ok;
+}
@@ -1,8 +1,19 @@
 #include "ui/HsiUiRenderer.hpp"
 #include <cmath>
-#include <cstdio>
 #include <vector>  
 
+namespace {
+  using Align = TtfTextRenderer::Align;
+
+  //Retained label: created on first use, rebuilt only when the string or position changes
+  void drawLabel(TtfTextRenderer& font, TtfTextRenderer::TextHandle& handle, const char* text,
+                 Align align, float x, float y, float r, float g, float b) {
+    if (handle < 0) handle = font.createText(text, align, x, y);
+    else font.updateText(handle, text, x, y);
+    font.drawText(handle, r, g, b);
+  }
+}
+
 HsiUiRenderer::HsiUiRenderer(TtfTextRenderer& info_font, TtfTextRenderer& info_label_font,
                              TtfTextRenderer& waypoint_name_font, TtfTextRenderer& waypoint_bearing_font,
                              TtfTextRenderer& waypoint_info_font, TtfTextRenderer& ttf_info_side, TtfTextRenderer& ttf_info_label_side)
@@ -11,47 +22,40 @@ HsiUiRenderer::HsiUiRenderer(TtfTextRenderer& info_font, TtfTextRenderer& info_l
     waypoint_info_font_(waypoint_info_font), info_side_(ttf_info_side), info_label_side_(ttf_info_label_side) {}
 
 void HsiUiRenderer::renderWindGroup(const WindGroup& wind, float left_offset) {
-  char wind_str[32];
-  snprintf(wind_str, sizeof(wind_str), "WIND %03.0f/%.0f", wind.direction, wind.speed);
+  const char* wind_str = wind_readout_.format(wind.direction, wind.speed);
   info_label_font_.drawTextLeftAligned(wind_str, left_offset, wind.y, wind.r, wind.g, wind.b);
 }
 
 void HsiUiRenderer::renderGpsGroup(const GpsGroup& gps, float left_offset) {
-  info_label_font_.drawTextLeftAligned(gps.status, left_offset, gps.y, gps.r, gps.g, gps.b);
+  drawLabel(info_label_font_, gps_text_, gps.status, Align::Left, left_offset, gps.y, gps.r, gps.g, gps.b);
 }
 
 void HsiUiRenderer::renderCogGroup(const CourseGroup& course, float right_offset) {
-  char cog_str[32];
-
-  snprintf(cog_str, sizeof(cog_str), "COG %.0f°", course.cog_value);
+  const char* cog_str = cog_readout_.format(course.cog_value);
   info_label_font_.drawTextRightAligned(cog_str, right_offset, course.y_cog,
                                   course.r, course.g, course.b);
 }
 
 void HsiUiRenderer::renderGsGroup(const CourseGroup& course, float right_offset) {
-  char gs_str[32];
-
-  snprintf(gs_str, sizeof(gs_str), "GS %.0f", course.gs_value);
+  const char* gs_str = gs_readout_.format(course.gs_value);
   info_label_font_.drawTextRightAligned(gs_str, right_offset, course.y_gs,
                                   course.r, course.g, course.b);
 }
 
 void HsiUiRenderer::renderIasGroup(const IasGroup& ias, float left_offset) {  
-  info_label_side_.drawTextLeftAligned("IAS", left_offset, ias.y + 0.15f,
-                                       ias.label_r, ias.label_g, ias.label_b);
+  drawLabel(info_label_side_, ias_text_, "IAS", Align::Left, left_offset, ias.y + 0.15f,
+            ias.label_r, ias.label_g, ias.label_b);
   
-  char ias_str[32];
-  snprintf(ias_str, sizeof(ias_str), "%.0f", ias.value);
+  const char* ias_str = ias_readout_.format(ias.value);
   info_side_.drawTextLeftAligned(ias_str, left_offset, ias.y - 0.05f,
                                  ias.value_r, ias.value_g, ias.value_b);
 }
 
 void HsiUiRenderer::renderAltGroup(const AltGroup& alt, float right_offset) {  
-  info_label_side_.drawTextRightAligned("ALT", right_offset, alt.y + 0.15f,
-                                        alt.label_r, alt.label_g, alt.label_b);
+  drawLabel(info_label_side_, alt_text_, "ALT", Align::Right, right_offset, alt.y + 0.15f,
+            alt.label_r, alt.label_g, alt.label_b);
   
-  char alt_str[32];
-  snprintf(alt_str, sizeof(alt_str), "%.0f", alt.value);
+  const char* alt_str = alt_readout_.format(alt.value);
   info_side_.drawTextRightAligned(alt_str, right_offset, alt.y - 0.05f,
                                   alt.value_r, alt.value_g, alt.value_b);
 }
@@ -60,33 +64,28 @@ void HsiUiRenderer::renderWaypointLeft(const WaypointGroup& wp, float left_offse
   float y_current = wp.y_start;
   const float line_spacing = 0.085f;
   const float bearing_to_name = 0.13f; 
-  char buffer[64];
 
-  snprintf(buffer, sizeof(buffer), "%.0f°", wp.bearing);
-  waypoint_bearing_font_.drawTextLeftAligned(buffer, left_offset, y_current,
+  waypoint_bearing_font_.drawTextLeftAligned(wp_left_bearing_.format(wp.bearing), left_offset, y_current,
                                              wp.r, wp.g, wp.b);
   y_current -= bearing_to_name;
 
-  waypoint_name_font_.drawTextLeftAligned(wp.name, left_offset, y_current,
-                                          wp.r, wp.g, wp.b);
+  drawLabel(waypoint_name_font_, wp_left_name_text_, wp.name, Align::Left, left_offset, y_current,
+            wp.r, wp.g, wp.b);
   y_current -= line_spacing;
 
-  snprintf(buffer, sizeof(buffer), "%.1f km", wp.distance);
-  waypoint_info_font_.drawTextLeftAligned(buffer, left_offset, y_current,
+  waypoint_info_font_.drawTextLeftAligned(wp_left_distance_.format(wp.distance), left_offset, y_current,
                                           wp.r, wp.g, wp.b);
   y_current -= line_spacing;
 
-  waypoint_info_font_.drawTextLeftAligned(wp.runway, left_offset, y_current,
-                                          wp.r, wp.g, wp.b);
+  drawLabel(waypoint_info_font_, wp_left_runway_text_, wp.runway, Align::Left, left_offset, y_current,
+            wp.r, wp.g, wp.b);
   y_current -= line_spacing;
 
-  snprintf(buffer, sizeof(buffer), "(APP)%.3f", wp.app_freq);
-  waypoint_info_font_.drawTextLeftAligned(buffer, left_offset, y_current,
+  waypoint_info_font_.drawTextLeftAligned(wp_left_app_.format(wp.app_freq), left_offset, y_current,
                                           wp.r, wp.g, wp.b);
   y_current -= line_spacing;
 
-  snprintf(buffer, sizeof(buffer), "(INF)%.3f", wp.info_freq);
-  waypoint_info_font_.drawTextLeftAligned(buffer, left_offset, y_current,
+  waypoint_info_font_.drawTextLeftAligned(wp_left_info_.format(wp.info_freq), left_offset, y_current,
                                           wp.r, wp.g, wp.b);
 }
 
@@ -94,44 +93,35 @@ void HsiUiRenderer::renderWaypointRight(const WaypointGroup& wp, float right_off
   float y_current = wp.y_start;
   const float line_spacing = 0.085f;
   const float bearing_to_name = 0.13f;  
-  char buffer[64];
 
-  snprintf(buffer, sizeof(buffer), "%.0f°", wp.bearing);
-  waypoint_bearing_font_.drawTextRightAligned(buffer, right_offset, y_current,
+  waypoint_bearing_font_.drawTextRightAligned(wp_right_bearing_.format(wp.bearing), right_offset, y_current,
                                               wp.r, wp.g, wp.b);
   y_current -= bearing_to_name;
 
-  waypoint_name_font_.drawTextRightAligned(wp.name, right_offset, y_current,
-                                           wp.r, wp.g, wp.b);
+  drawLabel(waypoint_name_font_, wp_right_name_text_, wp.name, Align::Right, right_offset, y_current,
+            wp.r, wp.g, wp.b);
   y_current -= line_spacing;
 
-  snprintf(buffer, sizeof(buffer), ">%.0f km", wp.distance);
-  waypoint_info_font_.drawTextRightAligned(buffer, right_offset, y_current,
+  waypoint_info_font_.drawTextRightAligned(wp_right_distance_.format(wp.distance), right_offset, y_current,
                                            wp.r, wp.g, wp.b);
   y_current -= line_spacing;
 
-  waypoint_info_font_.drawTextRightAligned(wp.runway, right_offset, y_current,
-                                           wp.r, wp.g, wp.b);
+  drawLabel(waypoint_info_font_, wp_right_runway_text_, wp.runway, Align::Right, right_offset, y_current,
+            wp.r, wp.g, wp.b);
   y_current -= line_spacing;
 
-  snprintf(buffer, sizeof(buffer), "(ACC)%.3f", wp.app_freq);
-  waypoint_info_font_.drawTextRightAligned(buffer, right_offset, y_current,
+  waypoint_info_font_.drawTextRightAligned(wp_right_app_.format(wp.app_freq), right_offset, y_current,
                                            wp.r, wp.g, wp.b);
   y_current -= line_spacing;
 
-  snprintf(buffer, sizeof(buffer), "(ACC)%.3f", wp.info_freq);
-  waypoint_info_font_.drawTextRightAligned(buffer, right_offset, y_current,
+  waypoint_info_font_.drawTextRightAligned(wp_right_info_.format(wp.info_freq), right_offset, y_current,
                                            wp.r, wp.g, wp.b);
 }
 
 void HsiUiRenderer::renderBugGroup(const BugGroup& bug) {
-  char buffer[32];
-
-  snprintf(buffer, sizeof(buffer), "BUG");
-  info_font_.drawTextCenteredNDC(buffer, bug.x, bug.y - 0.05f,
-                                 bug.r, bug.g, bug.b);
+  drawLabel(info_font_, bug_text_, "BUG", Align::Center, bug.x, bug.y - 0.05f,
+            bug.r, bug.g, bug.b);
 
-  snprintf(buffer, sizeof(buffer), "%.0f°", bug.value);
-  info_side_.drawTextCenteredNDC(buffer, bug.x, bug.y + 0.05f,  
+  info_side_.drawTextCenteredNDC(bug_readout_.format(bug.value), bug.x, bug.y + 0.05f,  
                                  bug.r, bug.g, bug.b);
 }
\ No newline at end of file
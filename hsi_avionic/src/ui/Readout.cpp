@@ -0,0 +1,88 @@
+#include "ui/Readout.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+namespace {
+  constexpr int64_t kPow10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+  constexpr int kMaxDecimals = 6;
+
+  //Copies at most max chars of a literal
+  char* copyAffix(char* out, const char* s, int max) {
+    const size_t n = std::min(std::strlen(s), (size_t)max);
+    std::memcpy(out, s, n);
+    return out + n;
+  }
+}
+
+Readout::Readout(const char* prefix, Field field)
+  : prefix_(prefix), fields_{ field, Field{} }, field_count_(1) {
+  fields_[0].decimals = std::min(std::max(fields_[0].decimals, 0), kMaxDecimals);
+  rebuild();
+}
+
+Readout::Readout(const char* prefix, Field first, Field second)
+  : prefix_(prefix), fields_{ first, second }, field_count_(2) {
+  for (Field& f : fields_) f.decimals = std::min(std::max(f.decimals, 0), kMaxDecimals);
+  rebuild();
+}
+
+//Round half to even on the scaled value, like printf on exact halves
+int64_t Readout::quantize(double value, const Field& field) const {
+  if (!std::isfinite(value)) return 0;
+  const double scaled = std::nearbyint(value * (double)kPow10[field.decimals]);
+  return (int64_t)std::min(std::max(scaled, -9.0e15), 9.0e15);
+}
+
+char* Readout::writeField(char* out, int64_t q, const Field& field) const {
+  if (q < 0) {
+    *out++ = '-';
+    q = -q;
+  }
+
+  const int64_t scale = kPow10[field.decimals];
+
+  char digits[24];
+  char* end = std::to_chars(digits, digits + sizeof(digits), q / scale).ptr;
+  for (int i = (int)(end - digits); i < std::min(field.min_digits, 20); ++i) *out++ = '0';
+  out = std::copy(digits, end, out);
+
+  if (field.decimals > 0) {
+    *out++ = '.';
+    end = std::to_chars(digits, digits + sizeof(digits), q % scale).ptr;
+    for (int i = (int)(end - digits); i < field.decimals; ++i) *out++ = '0';
+    out = std::copy(digits, end, out);
+  }
+
+  return copyAffix(out, field.suffix, kMaxAffix);
+}
+
+void Readout::rebuild() {
+  char* out = copyAffix(buf_, prefix_, kMaxAffix);
+  for (int i = 0; i < field_count_; ++i) {
+    out = writeField(out, last_[i] == kUnset ? 0 : last_[i], fields_[i]);
+  }
+  *out = '\0';
+}
+
+const char* Readout::format(double value) {
+  const int64_t q = quantize(value, fields_[0]);
+  if (q != last_[0]) {
+    last_[0] = q;
+    rebuild();
+  }
+  return buf_;
+}
+
+const char* Readout::format(double first, double second) {
+  const int64_t q0 = quantize(first, fields_[0]);
+  const int64_t q1 = quantize(second, fields_[1]);
+  if (q0 != last_[0] || q1 != last_[1]) {
+    last_[0] = q0;
+    last_[1] = q1;
+    rebuild();
+  }
+  return buf_;
+}
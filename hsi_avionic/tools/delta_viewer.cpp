@@ -0,0 +1,191 @@
+// Reference viewer for the tile delta stream (--delta-stream). Connects over
+// TCP, applies each frame's changed tiles to its own copy of the display and
+// optionally writes the result, which matches what the HSI presented.
+//
+//   hsi_delta_viewer [--host 127.0.0.1] [--port 47800] [--frames N] [--timeout S] [--dump out.ppm] [--quiet]
+//
+// Per frame it prints the frame number, changed tiles and bytes received. At
+// exit it reports totals and the ratio against raw RGB frames.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "capture/TileDeltaProtocol.hpp"
+#include "config/AppConfig.hpp"
+
+using namespace TileDeltaProtocol;
+
+namespace {
+  //Retries until the HSI is listening
+  int connectTo(const std::string& host, int port, double timeout_s) {
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+      std::cerr << "delta_viewer: bad address " << host << "\n";
+      return -1;
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(timeout_s);
+    for (;;) {
+      const int fd = socket(AF_INET, SOCK_STREAM, 0);
+      if (fd < 0) return -1;
+      if (connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0) return fd;
+      ::close(fd);
+
+      if (std::chrono::steady_clock::now() >= deadline) {
+        std::cerr << "delta_viewer: nothing listening on " << host << ":" << port << "\n";
+        return -1;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+  }
+
+  bool readAll(int fd, unsigned char* data, size_t bytes) {
+    while (bytes > 0) {
+      const ssize_t n = recv(fd, data, bytes, 0);
+      if (n <= 0) return false;
+      data += n;
+      bytes -= (size_t)n;
+    }
+    return true;
+  }
+
+  bool writePpm(const char* path, const std::vector<unsigned char>& rgb, int width, int height) {
+    std::FILE* f = std::fopen(path, "wb");
+    if (!f) return false;
+    std::fprintf(f, "P6\n%d %d\n255\n", width, height);
+    std::fwrite(rgb.data(), 1, rgb.size(), f);
+    std::fclose(f);
+    return true;
+  }
+}
+
+int main(int argc, char** argv) {
+  std::string host = "127.0.0.1";
+  int port = DeltaStreamConfig::PORT;
+  long max_frames = 0;
+  double timeout_s = 5.0;
+  const char* dump_path = nullptr;
+  bool quiet = false;
+
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--host") == 0 && i + 1 < argc) {
+      host = argv[++i];
+    } else if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+      port = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+      max_frames = std::atol(argv[++i]);
+    } else if (std::strcmp(argv[i], "--timeout") == 0 && i + 1 < argc) {
+      timeout_s = std::atof(argv[++i]);
+    } else if (std::strcmp(argv[i], "--dump") == 0 && i + 1 < argc) {
+      dump_path = argv[++i];
+    } else if (std::strcmp(argv[i], "--quiet") == 0) {
+      quiet = true;
+    } else {
+      std::cerr << "usage: hsi_delta_viewer [--host 127.0.0.1] [--port 47800] [--frames N] [--timeout S] "
+                   "[--dump out.ppm] [--quiet]\n";
+      return 2;
+    }
+  }
+
+  const int fd = connectTo(host, port, timeout_s);
+  if (fd < 0) return 1;
+
+  std::vector<unsigned char> rgb, payload;
+  int width = 0, height = 0;
+  long frames = 0, tiles = 0;
+  uint64_t bytes = 0;
+  bool keyframe_seen = false;
+  int status = 0;
+
+  while (max_frames <= 0 || frames < max_frames) {
+    unsigned char header[FRAME_HEADER_BYTES];
+    if (!readAll(fd, header, sizeof(header))) break;   // stream closed
+
+    if (getLe32(header) != MAGIC) {
+      std::cerr << "delta_viewer: bad frame header\n";
+      status = 1;
+      break;
+    }
+    const uint32_t frame_number = getLe32(header + 4);
+    const int w = getLe16(header + 8);
+    const int h = getLe16(header + 10);
+    const int tile_size = getLe16(header + 12);
+    const bool keyframe = (getLe16(header + 14) & FLAG_KEYFRAME) != 0;
+    const uint32_t tile_count = getLe32(header + 16);
+    payload.resize(getLe32(header + 20));
+    if (!readAll(fd, payload.data(), payload.size())) break;
+
+    if (keyframe) {
+      width = w;
+      height = h;
+      rgb.assign((size_t)width * height * 3, 0);
+      keyframe_seen = true;
+    }
+    if (!keyframe_seen || w != width || h != height || tile_size <= 0) {
+      std::cerr << "delta_viewer: delta before keyframe or size change without one\n";
+      status = 1;
+      break;
+    }
+
+    //Apply each tile in place
+    size_t pos = 0;
+    bool ok = true;
+    for (uint32_t i = 0; i < tile_count && ok; ++i) {
+      if (payload.size() - pos < TILE_HEADER_BYTES) {
+        ok = false;
+        break;
+      }
+      const int tx = getLe16(&payload[pos]) * tile_size;
+      const int ty = getLe16(&payload[pos + 2]) * tile_size;
+      const size_t encoded = getLe32(&payload[pos + 4]);
+      pos += TILE_HEADER_BYTES;
+
+      ok = tx < width && ty < height && encoded <= payload.size() - pos &&
+           decodeTile(&payload[pos], encoded, &rgb[((size_t)ty * width + tx) * 3], (size_t)width * 3,
+                      std::min(tile_size, width - tx), std::min(tile_size, height - ty));
+      pos += encoded;
+    }
+    if (!ok) {
+      std::cerr << "delta_viewer: malformed tile in frame " << frame_number << "\n";
+      status = 1;
+      break;
+    }
+
+    ++frames;
+    tiles += tile_count;
+    bytes += FRAME_HEADER_BYTES + payload.size();
+    if (!quiet) {
+      std::printf("frame %u%s: %u tiles, %zu bytes\n", frame_number, keyframe ? " (key)" : "",
+                  tile_count, FRAME_HEADER_BYTES + payload.size());
+    }
+  }
+  ::close(fd);
+
+  const double raw = (double)frames * width * height * 3;
+  std::printf("delta_viewer: %ld frames, %ld tiles, %llu bytes (%.1f:1 against raw RGB)\n",
+              frames, tiles, (unsigned long long)bytes, bytes ? raw / (double)bytes : 0.0);
+
+  if (dump_path && frames > 0) {
+    if (writePpm(dump_path, rgb, width, height)) {
+      std::cout << "delta_viewer: last frame written to " << dump_path << "\n";
+    } else {
+      std::cerr << "delta_viewer: cannot write " << dump_path << "\n";
+      status = 1;
+    }
+  }
+  return frames > 0 ? status : 1;
+}
@@ -0,0 +1,48 @@
+// Bakes the atlases listed in FontConfig into a single binary asset so the
+// application can map it at startup instead of rasterizing glyphs.
+//
+//   hsi_font_baker [output]     (default: FontConfig::BAKED_ATLAS_PATH)
+//
+// Font paths are resolved relative to the working directory, exactly as the
+// application resolves them, and are stored verbatim as lookup keys.
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "config/AppConfig.hpp"
+#include "gfx/BakedFontFile.hpp"
+#include "gfx/FontAtlas.hpp"
+
+int main(int argc, char** argv) {
+  const std::string out_path = argc > 1 ? argv[1] : FontConfig::BAKED_ATLAS_PATH;
+
+  std::vector<std::unique_ptr<FontAtlas>> atlases;
+  std::vector<BakedFontFile::Source> sources;
+
+  for (int i = 0; i < FontConfig::FONT_COUNT; ++i) {
+    const std::string path = FontConfig::PATHS[i];
+    const float size = FontConfig::SIZES[i];
+
+    bool duplicate = false;
+    for (const BakedFontFile::Source& s : sources) {
+      if (s.path == path && s.pixel_height == size) duplicate = true;
+    }
+    if (duplicate) continue;
+
+    std::unique_ptr<FontAtlas> atlas(new FontAtlas());
+    if (!atlas->build(path, size)) {
+      std::cerr << "font_baker: failed to bake " << path << " @ " << size << "px\n";
+      return 1;
+    }
+
+    sources.push_back({ path, size, atlas.get() });
+    atlases.push_back(std::move(atlas));
+  }
+
+  if (!BakedFontFile::write(out_path, sources)) return 1;
+
+  std::cout << "font_baker: wrote " << sources.size() << " atlases to " << out_path << "\n";
+  return 0;
+}
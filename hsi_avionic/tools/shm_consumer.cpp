@@ -0,0 +1,184 @@
+// Reference consumer for the shared-memory frame ring (--shm-output). Maps the
+// ring read-only, follows the newest frame and checks every read against the
+// slot's sequence lock, the way a compositor would before using the pixels.
+//
+//   hsi_shm_consumer [--name /hsi_frames] [--frames N] [--timeout S] [--dump out.ppm] [--quiet]
+//
+// Per frame it prints the frame number, the age of the frame when it was read
+// and the dirty rectangle. At exit it reports frames seen, frames the
+// publisher produced in between (missed), torn reads and the age statistics.
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "capture/SharedFrameLayout.hpp"
+#include "config/AppConfig.hpp"
+
+using namespace SharedFrameLayout;
+
+namespace {
+  uint64_t monotonicNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+  }
+
+  //Waits for the publisher to create and initialize the ring
+  const RingHeader* mapRing(const std::string& name, double timeout_s, size_t& mapped_bytes) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(timeout_s);
+    for (;;) {
+      const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+      if (fd >= 0) {
+        struct stat st;
+        if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(RingHeader)) {
+          void* view = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+          ::close(fd);
+          if (view == MAP_FAILED) {
+            std::cerr << "shm_consumer: mmap of " << name << " failed: " << std::strerror(errno) << "\n";
+            return nullptr;
+          }
+
+          const RingHeader* ring = static_cast<const RingHeader*>(view);
+          if (ring->magic.load(std::memory_order_acquire) == MAGIC) {
+            if (ring->version != VERSION || ring->slot_count < 2 || ring->slot_count > MAX_SLOTS ||
+                (size_t)st.st_size < objectBytes(ring->width, ring->height, ring->slot_count)) {
+              std::cerr << "shm_consumer: " << name << " has an unexpected layout\n";
+              munmap(view, (size_t)st.st_size);
+              return nullptr;
+            }
+            mapped_bytes = (size_t)st.st_size;
+            return ring;
+          }
+          munmap(view, (size_t)st.st_size);
+        } else {
+          ::close(fd);
+        }
+      }
+
+      if (std::chrono::steady_clock::now() >= deadline) {
+        std::cerr << "shm_consumer: no frame ring at " << name << "\n";
+        return nullptr;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+
+  bool writePpm(const char* path, const std::vector<unsigned char>& rgba, uint32_t width, uint32_t height) {
+    std::FILE* f = std::fopen(path, "wb");
+    if (!f) return false;
+    std::fprintf(f, "P6\n%u %u\n255\n", width, height);
+    for (size_t i = 0; i < rgba.size(); i += 4) std::fwrite(&rgba[i], 1, 3, f);
+    std::fclose(f);
+    return true;
+  }
+}
+
+int main(int argc, char** argv) {
+  std::string name = SharedFrameConfig::NAME;
+  long max_frames = 0;
+  double timeout_s = 5.0;
+  const char* dump_path = nullptr;
+  bool quiet = false;
+
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--name") == 0 && i + 1 < argc) {
+      name = argv[++i];
+    } else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+      max_frames = std::atol(argv[++i]);
+    } else if (std::strcmp(argv[i], "--timeout") == 0 && i + 1 < argc) {
+      timeout_s = std::atof(argv[++i]);
+    } else if (std::strcmp(argv[i], "--dump") == 0 && i + 1 < argc) {
+      dump_path = argv[++i];
+    } else if (std::strcmp(argv[i], "--quiet") == 0) {
+      quiet = true;
+    } else {
+      std::cerr << "usage: hsi_shm_consumer [--name /hsi_frames] [--frames N] [--timeout S] [--dump out.ppm] [--quiet]\n";
+      return 2;
+    }
+  }
+
+  size_t mapped_bytes = 0;
+  const RingHeader* ring = mapRing(name, timeout_s, mapped_bytes);
+  if (!ring) return 1;
+
+  const unsigned char* base = reinterpret_cast<const unsigned char*>(ring);
+  std::cout << "shm_consumer: " << name << " " << ring->width << "x" << ring->height << ", "
+            << ring->slot_count << " slots\n";
+
+  std::vector<unsigned char> last_frame, copy;
+  uint64_t last_seen = 0;
+  long seen = 0, missed = 0, torn = 0;
+  double age_total_ms = 0.0, age_max_ms = 0.0;
+  auto idle_since = std::chrono::steady_clock::now();
+
+  while (max_frames <= 0 || seen < max_frames) {
+    const uint64_t n = ring->latest.load(std::memory_order_acquire);
+    if (n == 0 || n == last_seen) {
+      if (ring->closed.load(std::memory_order_acquire)) break;
+      if (std::chrono::steady_clock::now() - idle_since > std::chrono::duration<double>(timeout_s)) break;
+      std::this_thread::sleep_for(std::chrono::microseconds(500));
+      continue;
+    }
+
+    const SlotHeader& slot = ring->slots[(n - 1) % ring->slot_count];
+    const uint32_t seq = slot.seq.load(std::memory_order_acquire);
+    if (seq & 1) continue;   // being rewritten; latest has moved on
+
+    //Use the slot in place; only the dump copies
+    const uint64_t frame_number = slot.frame_number;
+    const uint64_t timestamp_ns = slot.timestamp_ns;
+    const int32_t dx = slot.dirty_x, dy = slot.dirty_y, dw = slot.dirty_w, dh = slot.dirty_h;
+    const unsigned char* pixels = base + ring->pixel_offset + ((n - 1) % ring->slot_count) * ring->slot_bytes;
+    if (dump_path) copy.assign(pixels, pixels + ring->slot_bytes);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.seq.load(std::memory_order_relaxed) != seq || frame_number != n) {
+      ++torn;
+      continue;
+    }
+
+    const double age_ms = (double)(monotonicNs() - timestamp_ns) / 1e6;
+    if (last_seen && n > last_seen + 1) missed += (long)(n - last_seen - 1);
+    last_seen = n;
+    if (dump_path) last_frame.swap(copy);
+    ++seen;
+    age_total_ms += age_ms;
+    age_max_ms = std::max(age_max_ms, age_ms);
+    idle_since = std::chrono::steady_clock::now();
+
+    if (!quiet) {
+      std::printf("frame %llu age %.2f ms dirty %d,%d %dx%d\n",
+                  (unsigned long long)n, age_ms, dx, dy, dw, dh);
+    }
+  }
+
+  std::printf("shm_consumer: %ld frames, %ld missed, %ld torn reads; age mean=%.2f max=%.2f ms\n",
+              seen, missed, torn, seen ? age_total_ms / seen : 0.0, age_max_ms);
+
+  int status = seen ? 0 : 1;
+  if (dump_path && !last_frame.empty()) {
+    if (writePpm(dump_path, last_frame, ring->width, ring->height)) {
+      std::cout << "shm_consumer: frame " << last_seen << " written to " << dump_path << "\n";
+    } else {
+      std::cerr << "shm_consumer: cannot write " << dump_path << "\n";
+      status = 1;
+    }
+  }
+
+  munmap(const_cast<RingHeader*>(ring), mapped_bytes);
+  return status;
+}